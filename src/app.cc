@@ -18,6 +18,8 @@ WApplicationStrategy::WApplicationStrategy(const Wt::WEnvironment& env)
   : WApplication(env)
 {
   setTitle("FinMart");
+  // views render database results when they arrive (run_query)
+  enableUpdates(true);
 
   Wt::WCssStyleSheet& css = styleSheet();
 
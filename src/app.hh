@@ -7,8 +7,12 @@
 #include <Wt/WNavigationBar.h>
 #include <Wt/WMenu.h>
 #include <Wt/WText.h>
+#include <Wt/WServer.h>
 #include <memory>
+#include <future>
+#include <functional>
 #include "api.hh"
+#include "db_executor.hh"
 
 class WidgetLogin;
 class WidgetProjects;
@@ -33,6 +37,8 @@ public:
   void show_data();
   void show_metrics();
   void set_status(const std::string& message, bool is_error = false);
+  template<typename T, typename W>
+  void run_query(W* widget, const std::function<T(IFinMartDatabase*)>& query, void (W::*render)(std::shared_future<T>));
 
 private:
   void create_login_page();
@@ -55,4 +61,45 @@ private:
   WidgetMetrics* p_metrics;
 };
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// run_query
+// runs query on finmart_executor() and renders its result with (widget->*render)(result) back in
+// this session, through WServer::post and server push; the request thread returns at once.
+// render is skipped if the widget was deleted meanwhile (bindSafe), and is also called when the
+// query failed: result.get() then rethrows
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T, typename W>
+void WApplicationStrategy::run_query(W* widget, const std::function<T(IFinMartDatabase*)>& query, void (W::*render)(std::shared_future<T>))
+{
+  std::function<void(std::shared_future<T>)> done = widget->bindSafe(render);
+  std::string session_id = sessionId();
+  finmart_executor().submit<T>(query, [session_id, done](std::shared_future<T> result)
+    {
+      Wt::WServer* server = Wt::WServer::instance();
+      if (!server)
+      {
+        return;
+      }
+      server->post(session_id, [done, result]()
+        {
+          done(result);
+          Wt::WApplication::instance()->triggerUpdate();
+        });
+    });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// ready_result
+// a result already at hand (read from finmart_snapshot()) for a render method of run_query
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+std::shared_future<T> ready_result(T value)
+{
+  std::promise<T> promise;
+  promise.set_value(std::move(value));
+  return promise.get_future().share();
+}
+
 #endif
@@ -0,0 +1,154 @@
+#include "db_interface.hh"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// bench_insert
+// insert throughput in rows/sec: one autocommit INSERT per row against the batch API
+// usage: bench_insert [rows] [sql_server_connection_string]
+// SQLite runs on bench_insert.db in the current directory; SQL Server only when a connection
+// string is given (rows are added to its financial_records and transactions tables)
+// row-at-a-time inserts are capped at 2000 rows, the rate is what matters
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<FinancialRecord> make_records(size_t nbr_rows);
+std::vector<transaction> make_transactions(size_t nbr_rows);
+void bench_backend(IFinMartDatabase* db, size_t nbr_rows);
+void report(const std::string& name, size_t nbr_rows, double seconds);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//main
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+  size_t nbr_rows = 100000;
+  if (argc > 1)
+  {
+    nbr_rows = static_cast<size_t>(std::atol(argv[1]));
+  }
+
+  std::remove("bench_insert.db");
+  std::unique_ptr<IFinMartDatabase> lite(DatabaseFactory::create(DatabaseBackend::SQLITE, "bench_insert.db"));
+  if (!lite || !lite->is_open())
+  {
+    std::cerr << "cannot open bench_insert.db" << std::endl;
+    return 1;
+  }
+  std::cout << "SQLite" << std::endl;
+  bench_backend(lite.get(), nbr_rows);
+
+  if (argc > 2)
+  {
+    std::unique_ptr<IFinMartDatabase> server(DatabaseFactory::create(DatabaseBackend::SQLSERVER, argv[2]));
+    if (!server || !server->is_open())
+    {
+      std::cerr << "cannot connect to SQL Server" << std::endl;
+      return 1;
+    }
+    std::cout << "SQL Server" << std::endl;
+    bench_backend(server.get(), nbr_rows);
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// bench_backend
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void bench_backend(IFinMartDatabase* db, size_t nbr_rows)
+{
+  std::vector<FinancialRecord> records = make_records(nbr_rows);
+  std::vector<transaction> transactions = make_transactions(nbr_rows);
+  size_t nbr_single = std::min<size_t>(nbr_rows, 2000);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t idx = 0; idx < nbr_single; idx++)
+  {
+    db->insert_financial_record(records[idx]);
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  report("  insert_financial_record (autocommit)", nbr_single, elapsed.count());
+
+  start = std::chrono::steady_clock::now();
+  int rc = db->insert_financial_records(records);
+  elapsed = std::chrono::steady_clock::now() - start;
+  report(rc == 0 ? "  insert_financial_records (batch)" : "  insert_financial_records (FAILED)", nbr_rows, elapsed.count());
+
+  start = std::chrono::steady_clock::now();
+  rc = db->insert_transactions(transactions);
+  elapsed = std::chrono::steady_clock::now() - start;
+  report(rc == 0 ? "  insert_transactions (batch)" : "  insert_transactions (FAILED)", nbr_rows, elapsed.count());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// report
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void report(const std::string& name, size_t nbr_rows, double seconds)
+{
+  std::cout << std::left << std::setw(42) << name << std::right
+    << std::setw(10) << nbr_rows << " rows "
+    << std::fixed << std::setprecision(3) << std::setw(10) << seconds << " s "
+    << std::setprecision(0) << std::setw(12) << (nbr_rows / seconds) << " rows/sec" << std::endl;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// make_records
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<FinancialRecord> make_records(size_t nbr_rows)
+{
+  std::vector<FinancialRecord> records(nbr_rows);
+  for (size_t idx = 0; idx < nbr_rows; idx++)
+  {
+    FinancialRecord& r = records[idx];
+    r.period = "2025-Q" + std::to_string(idx % 4 + 1);
+    r.company_id = "Company " + std::to_string(idx % 100);
+    r.revenue = 1000000.0 + idx;
+    r.cogs = r.revenue * 0.6;
+    r.operating_expenses = r.revenue * 0.2;
+    r.depreciation = r.revenue * 0.03;
+    r.amortization = r.revenue * 0.02;
+    r.interest = r.revenue * 0.02;
+    r.taxes = r.revenue * 0.03;
+    r.current_assets = r.revenue * 0.4;
+    r.current_liabilities = r.revenue * 0.25;
+    r.inventory = r.revenue * 0.15;
+    r.total_assets = r.revenue * 2.0;
+    r.total_liabilities = r.revenue * 0.8;
+  }
+  return records;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// make_transactions
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<transaction> make_transactions(size_t nbr_rows)
+{
+  const char* departments[] = { "IT", "HR", "Finance", "Operations", "Procurement" };
+  const char* sources[] = { "PeopleSoft", "Coupa", "SAP", "MicroStrategy" };
+
+  std::vector<transaction> transactions(nbr_rows);
+  for (size_t idx = 0; idx < nbr_rows; idx++)
+  {
+    transaction& t = transactions[idx];
+    t.id = 0;
+    char date[16];
+    snprintf(date, sizeof(date), "2025-%02d-15", static_cast<int>(idx % 12 + 1));
+    t.date = date;
+    t.department = departments[idx % 5];
+    t.category = "Software";
+    t.vendor = "Vendor " + std::to_string(idx % 1000);
+    t.amount = 100.0 + (idx % 5000);
+    t.status = (idx % 10 == 0) ? "Pending" : "Approved";
+    t.source_system = sources[idx % 4];
+  }
+  return transactions;
+}
@@ -0,0 +1,314 @@
+#include "manager.hh"
+#include "json_writer.hh"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// bench_json
+// JSON serialization throughput in rows/sec
+// usage: bench_json [rows]
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<FinancialMetrics> make_metrics(size_t nbr_rows);
+std::vector<transaction> make_transactions(size_t nbr_rows);
+std::string stream_dataset_data_json(const std::vector<FinancialMetrics>& metrics);
+std::string stream_transactions_to_json(const std::vector<transaction>& transactions);
+std::string hand_dataset_data_json(const std::vector<FinancialMetrics>& metrics);
+std::string hand_metrics_to_json(const std::vector<FinancialMetrics>& metrics);
+void report(const std::string& name, size_t nbr_rows, size_t nbr_bytes, double seconds);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//main
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+  size_t nbr_rows = 100000;
+  if (argc > 1)
+  {
+    nbr_rows = static_cast<size_t>(std::atol(argv[1]));
+  }
+
+  std::vector<FinancialMetrics> metrics = make_metrics(nbr_rows);
+  std::vector<transaction> transactions = make_transactions(nbr_rows);
+  DataManager manager;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::string json = stream_dataset_data_json(metrics);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  report("dataset_data_json (stringstream)", nbr_rows, json.size(), elapsed.count());
+
+  start = std::chrono::steady_clock::now();
+  json = hand_dataset_data_json(metrics);
+  elapsed = std::chrono::steady_clock::now() - start;
+  report("dataset_data_json (hand written)", nbr_rows, json.size(), elapsed.count());
+
+  start = std::chrono::steady_clock::now();
+  json = manager.dataset_data_json(metrics);
+  elapsed = std::chrono::steady_clock::now() - start;
+  report("dataset_data_json (field table)", nbr_rows, json.size(), elapsed.count());
+
+  start = std::chrono::steady_clock::now();
+  DatasetDataStream stream(metrics);
+  const char* data = nullptr;
+  size_t size = 0;
+  size_t nbr_bytes = 0;
+  while (stream.next(data, size))
+  {
+    nbr_bytes += size;
+  }
+  elapsed = std::chrono::steady_clock::now() - start;
+  report("DatasetDataStream (64KB blocks)", nbr_rows, nbr_bytes, elapsed.count());
+
+  start = std::chrono::steady_clock::now();
+  json = hand_metrics_to_json(metrics);
+  elapsed = std::chrono::steady_clock::now() - start;
+  report("metrics_to_json (hand written)", nbr_rows, json.size(), elapsed.count());
+
+  start = std::chrono::steady_clock::now();
+  json = manager.metrics_to_json(metrics);
+  elapsed = std::chrono::steady_clock::now() - start;
+  report("metrics_to_json (field table)", nbr_rows, json.size(), elapsed.count());
+
+  start = std::chrono::steady_clock::now();
+  json = stream_transactions_to_json(transactions);
+  elapsed = std::chrono::steady_clock::now() - start;
+  report("transactions_to_json (stringstream)", nbr_rows, json.size(), elapsed.count());
+
+  start = std::chrono::steady_clock::now();
+  json = manager.transactions_to_json(transactions);
+  elapsed = std::chrono::steady_clock::now() - start;
+  report("transactions_to_json (json_writer)", nbr_rows, json.size(), elapsed.count());
+
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//report
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void report(const std::string& name, size_t nbr_rows, size_t nbr_bytes, double seconds)
+{
+  std::cout << std::left << std::setw(40) << name
+    << std::right << std::setw(14) << std::fixed << std::setprecision(0) << (nbr_rows / seconds) << " rows/sec "
+    << std::setw(10) << std::setprecision(1) << (nbr_bytes / seconds / (1024 * 1024)) << " MB/sec"
+    << std::endl;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//make_metrics
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<FinancialMetrics> make_metrics(size_t nbr_rows)
+{
+  const char* companies[] = { "ACME Corp", "TechVentures", "GlobalTrade \"Intl\"" };
+  std::vector<FinancialMetrics> metrics(nbr_rows);
+  for (size_t idx = 0; idx < nbr_rows; ++idx)
+  {
+    FinancialMetrics& m = metrics[idx];
+    m.period = std::to_string(2000 + idx % 25) + "-Q" + std::to_string(idx % 4 + 1);
+    m.company_id = companies[idx % 3];
+    m.revenue = 1000000.0 + idx * 13.37;
+    m.cogs = m.revenue * 0.6;
+    m.operating_expenses = m.revenue * 0.2;
+    m.depreciation = m.revenue * 0.03;
+    m.amortization = m.revenue * 0.02;
+    m.interest = m.revenue * 0.02;
+    m.taxes = m.revenue * 0.03;
+    m.current_assets = m.revenue * 0.4;
+    m.current_liabilities = m.revenue * 0.25;
+    m.inventory = m.revenue * 0.15;
+    m.total_assets = m.revenue * 2.0;
+    m.total_liabilities = m.revenue * 0.8;
+  }
+  return metrics;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//make_transactions
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<transaction> make_transactions(size_t nbr_rows)
+{
+  const char* departments[] = { "IT", "HR", "Finance", "Operations", "Procurement" };
+  const char* vendors[] = { "Microsoft", "Dell", "AWS", "Oracle", "Cisco", "Adobe" };
+  std::vector<transaction> transactions(nbr_rows);
+  for (size_t idx = 0; idx < nbr_rows; ++idx)
+  {
+    transaction& t = transactions[idx];
+    t.id = static_cast<int>(idx + 1);
+    t.date = "2025-01-" + std::to_string(idx % 28 + 10);
+    t.department = departments[idx % 5];
+    t.category = "Software";
+    t.vendor = vendors[idx % 6];
+    t.amount = (idx % 50000 + 1000) / 100.0;
+    t.status = (idx % 10 == 0) ? "Pending" : "Approved";
+    t.source_system = "PeopleSoft";
+  }
+  return transactions;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//stream_dataset_data_json
+//previous std::stringstream implementation, kept as the baseline
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string stream_dataset_data_json(const std::vector<FinancialMetrics>& metrics)
+{
+  std::stringstream json;
+  json << std::fixed << std::setprecision(4);
+  json << "{\n";
+  json << "  \"data\": [\n";
+
+  for (size_t idx = 0; idx < metrics.size(); ++idx)
+  {
+    const FinancialMetrics& m = metrics[idx];
+    json << "    [\"" << m.period << "\", \"" << m.company_id << "\", "
+      << m.revenue << ", " << m.gross_profit() << ", " << m.gross_margin() << ", "
+      << m.ebitda() << ", " << m.ebit() << ", " << m.net_income() << ", "
+      << m.net_margin() << ", " << m.working_capital() << ", "
+      << m.current_ratio() << ", " << m.quick_ratio() << ", "
+      << m.debt_to_equity() << ", " << m.return_on_assets() << ", "
+      << m.return_on_equity() << "]";
+    if (idx < metrics.size() - 1) json << ",";
+    json << "\n";
+  }
+
+  json << "  ]\n";
+  json << "}";
+  return json.str();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//stream_transactions_to_json
+//previous std::stringstream implementation, kept as the baseline
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string stream_transactions_to_json(const std::vector<transaction>& transactions)
+{
+  std::stringstream json;
+  json << std::fixed << std::setprecision(2);
+  json << "{\n";
+  json << "  \"transactions\": [\n";
+
+  for (size_t idx = 0; idx < transactions.size(); ++idx)
+  {
+    const transaction& t = transactions[idx];
+    json << "    {\n";
+    json << "      \"id\": " << t.id << ",\n";
+    json << "      \"date\": \"" << t.date << "\",\n";
+    json << "      \"department\": \"" << t.department << "\",\n";
+    json << "      \"category\": \"" << t.category << "\",\n";
+    json << "      \"vendor\": \"" << t.vendor << "\",\n";
+    json << "      \"amount\": " << t.amount << ",\n";
+    json << "      \"status\": \"" << t.status << "\",\n";
+    json << "      \"source_system\": \"" << t.source_system << "\"\n";
+    json << "    }";
+    if (idx < transactions.size() - 1) json << ",";
+    json << "\n";
+  }
+
+  json << "  ]\n";
+  json << "}";
+  return json.str();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//hand_dataset_data_json
+//json_writer with the columns written out by hand, baseline for the generated field table writer
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string hand_dataset_data_json(const std::vector<FinancialMetrics>& metrics)
+{
+  json_writer json(64 + metrics.size() * 256);
+  json.begin_object();
+  json.key("data");
+  json.begin_array();
+
+  for (size_t idx = 0; idx < metrics.size(); ++idx)
+  {
+    const FinancialMetrics& m = metrics[idx];
+    json.begin_array();
+    json.value_string(m.period);
+    json.value_string(m.company_id);
+    json.value_double(m.revenue, 4);
+    json.value_double(m.gross_profit(), 4);
+    json.value_double(m.gross_margin(), 4);
+    json.value_double(m.ebitda(), 4);
+    json.value_double(m.ebit(), 4);
+    json.value_double(m.net_income(), 4);
+    json.value_double(m.net_margin(), 4);
+    json.value_double(m.working_capital(), 4);
+    json.value_double(m.current_ratio(), 4);
+    json.value_double(m.quick_ratio(), 4);
+    json.value_double(m.debt_to_equity(), 4);
+    json.value_double(m.return_on_assets(), 4);
+    json.value_double(m.return_on_equity(), 4);
+    json.end_array();
+  }
+
+  json.end_array();
+  json.end_object();
+  return json.str();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//hand_metrics_to_json
+//json_writer with the keys written out by hand, baseline for the generated field table writer
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string hand_metrics_to_json(const std::vector<FinancialMetrics>& metrics)
+{
+  json_writer json(64 + metrics.size() * 512);
+  json.begin_object();
+  json.key("metrics");
+  json.begin_array();
+
+  for (size_t idx = 0; idx < metrics.size(); ++idx)
+  {
+    const FinancialMetrics& m = metrics[idx];
+    json.begin_object();
+    json.key("period");
+    json.value_string(m.period);
+    json.key("company_id");
+    json.value_string(m.company_id);
+    json.key("revenue");
+    json.value_double(m.revenue, 4);
+    json.key("gross_profit");
+    json.value_double(m.gross_profit(), 4);
+    json.key("gross_margin");
+    json.value_double(m.gross_margin(), 4);
+    json.key("ebitda");
+    json.value_double(m.ebitda(), 4);
+    json.key("ebit");
+    json.value_double(m.ebit(), 4);
+    json.key("net_income");
+    json.value_double(m.net_income(), 4);
+    json.key("net_margin");
+    json.value_double(m.net_margin(), 4);
+    json.key("operating_margin");
+    json.value_double(m.operating_margin(), 4);
+    json.key("working_capital");
+    json.value_double(m.working_capital(), 4);
+    json.key("current_ratio");
+    json.value_double(m.current_ratio(), 4);
+    json.key("quick_ratio");
+    json.value_double(m.quick_ratio(), 4);
+    json.key("debt_to_equity");
+    json.value_double(m.debt_to_equity(), 4);
+    json.key("debt_ratio");
+    json.value_double(m.debt_ratio(), 4);
+    json.key("roa");
+    json.value_double(m.return_on_assets(), 4);
+    json.key("roe");
+    json.value_double(m.return_on_equity(), 4);
+    json.end_object();
+  }
+
+  json.end_array();
+  json.end_object();
+  return json.str();
+}
@@ -0,0 +1,208 @@
+#include "lite.hh"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <functional>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// bench_lite
+// finmart_db query cost with the statement cache against prepare/finalize per call
+// usage: bench_lite [iterations] [db_file]
+//
+// for each statement:
+//   prepare       sqlite3_prepare_v2 + sqlite3_finalize only, the parse time the cache saves
+//   uncached      prepare, bind, step, finalize on a second connection (previous finmart_db)
+//   cached        the finmart_db method
+// inserts commit one row at a time, their numbers include the journal sync of db_file
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* SQL_TOTAL = "SELECT SUM(amount) FROM transactions;";
+const char* SQL_DEPARTMENT = "SELECT department, SUM(amount) FROM transactions GROUP BY department;";
+const char* SQL_SOURCE = "SELECT source_system, COUNT(*) FROM transactions GROUP BY source_system;";
+const char* SQL_TRANSACTIONS = "SELECT * FROM transactions ORDER BY date DESC LIMIT 100;";
+const char* SQL_COMPANY = "SELECT period, company_id, revenue, cogs, operating_expenses, "
+  "depreciation, amortization, interest, taxes, current_assets, current_liabilities, "
+  "inventory, total_assets, total_liabilities FROM financial_records WHERE company_id = ? ORDER BY period;";
+const char* SQL_INSERT = R"(
+    INSERT INTO financial_records
+    (period, company_id, revenue, cogs, operating_expenses, depreciation, amortization,
+     interest, taxes, current_assets, current_liabilities, inventory, total_assets, total_liabilities)
+    VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);
+  )";
+
+double time_calls(size_t iterations, const std::function<void()>& fn);
+void report(const std::string& name, size_t iterations, double seconds);
+void uncached_query(sqlite3* db, const char* sql, const char* text);
+void uncached_insert(sqlite3* db, const FinancialRecord& record);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//main
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+  size_t iterations = 20000;
+  std::string db_file = "bench_lite.db";
+  if (argc > 1)
+  {
+    iterations = static_cast<size_t>(std::atol(argv[1]));
+  }
+  if (argc > 2)
+  {
+    db_file = argv[2];
+  }
+  std::remove(db_file.c_str());
+
+  finmart_db fdb(db_file);
+  sqlite3* db = nullptr;
+  if (!fdb.is_open() || sqlite3_open(db_file.c_str(), &db) != SQLITE_OK)
+  {
+    std::cerr << "cannot open " << db_file << std::endl;
+    return 1;
+  }
+
+  FinancialRecord record = {};
+  record.period = "2025-Q2";
+  record.company_id = "BenchCorp";
+  record.revenue = 1000000.0;
+
+  struct query_t
+  {
+    const char* name;
+    const char* sql;
+    const char* text;
+    std::function<void()> cached;
+  };
+
+  std::vector<query_t> queries =
+  {
+    { "get_total_spending", SQL_TOTAL, nullptr, [&fdb]() { fdb.get_total_spending(); } },
+    { "get_department_spending", SQL_DEPARTMENT, nullptr, [&fdb]() { fdb.get_department_spending(); } },
+    { "get_source_system_counts", SQL_SOURCE, nullptr, [&fdb]() { fdb.get_source_system_counts(); } },
+    { "get_all_transactions", SQL_TRANSACTIONS, nullptr, [&fdb]() { fdb.get_all_transactions(); } },
+    { "get_financial_records_by_company", SQL_COMPANY, "ACME Corp", [&fdb]() { fdb.get_financial_records_by_company("ACME Corp"); } },
+  };
+
+  for (size_t idx = 0; idx < queries.size(); idx++)
+  {
+    const query_t& q = queries[idx];
+    std::cout << q.name << std::endl;
+
+    double seconds = time_calls(iterations, [db, &q]()
+      {
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(db, q.sql, -1, &stmt, nullptr);
+        sqlite3_finalize(stmt);
+      });
+    report("  prepare", iterations, seconds);
+
+    seconds = time_calls(iterations, [db, &q]() { uncached_query(db, q.sql, q.text); });
+    report("  uncached", iterations, seconds);
+
+    seconds = time_calls(iterations, q.cached);
+    report("  cached", iterations, seconds);
+  }
+
+  size_t nbr_inserts = iterations / 20 + 1;
+  std::cout << "insert_financial_record" << std::endl;
+  double seconds = time_calls(nbr_inserts, [db]()
+    {
+      sqlite3_stmt* stmt = nullptr;
+      sqlite3_prepare_v2(db, SQL_INSERT, -1, &stmt, nullptr);
+      sqlite3_finalize(stmt);
+    });
+  report("  prepare", nbr_inserts, seconds);
+
+  seconds = time_calls(nbr_inserts, [db, &record]() { uncached_insert(db, record); });
+  report("  uncached", nbr_inserts, seconds);
+
+  seconds = time_calls(nbr_inserts, [&fdb, &record]() { fdb.insert_financial_record(record); });
+  report("  cached", nbr_inserts, seconds);
+
+  sqlite3_close(db);
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// time_calls
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double time_calls(size_t iterations, const std::function<void()>& fn)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t idx = 0; idx < iterations; idx++)
+  {
+    fn();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// report
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void report(const std::string& name, size_t iterations, double seconds)
+{
+  std::cout << std::left << std::setw(12) << name << std::right
+    << std::fixed << std::setprecision(2) << std::setw(10) << (seconds * 1e6 / iterations) << " us/call "
+    << std::setprecision(0) << std::setw(12) << (iterations / seconds) << " calls/sec" << std::endl;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// uncached_query - previous finmart_db pattern: prepare, step through all rows, finalize
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void uncached_query(sqlite3* db, const char* sql, const char* text)
+{
+  sqlite3_stmt* stmt;
+  sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+  if (text)
+  {
+    sqlite3_bind_text(stmt, 1, text, -1, SQLITE_TRANSIENT);
+  }
+  int nbr_cols = sqlite3_column_count(stmt);
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+  {
+    for (int col = 0; col < nbr_cols; col++)
+    {
+      if (sqlite3_column_type(stmt, col) == SQLITE_TEXT)
+      {
+        std::string value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+      }
+      else
+      {
+        sqlite3_column_double(stmt, col);
+      }
+    }
+  }
+  sqlite3_finalize(stmt);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// uncached_insert
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void uncached_insert(sqlite3* db, const FinancialRecord& record)
+{
+  sqlite3_stmt* stmt;
+  sqlite3_prepare_v2(db, SQL_INSERT, -1, &stmt, nullptr);
+  sqlite3_bind_text(stmt, 1, record.period.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 2, record.company_id.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_double(stmt, 3, record.revenue);
+  sqlite3_bind_double(stmt, 4, record.cogs);
+  sqlite3_bind_double(stmt, 5, record.operating_expenses);
+  sqlite3_bind_double(stmt, 6, record.depreciation);
+  sqlite3_bind_double(stmt, 7, record.amortization);
+  sqlite3_bind_double(stmt, 8, record.interest);
+  sqlite3_bind_double(stmt, 9, record.taxes);
+  sqlite3_bind_double(stmt, 10, record.current_assets);
+  sqlite3_bind_double(stmt, 11, record.current_liabilities);
+  sqlite3_bind_double(stmt, 12, record.inventory);
+  sqlite3_bind_double(stmt, 13, record.total_assets);
+  sqlite3_bind_double(stmt, 14, record.total_liabilities);
+  sqlite3_step(stmt);
+  sqlite3_finalize(stmt);
+}
@@ -0,0 +1,86 @@
+#include "odbc.hh"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// bench_odbc
+// odbc::fetch and odbc::fetch_each throughput in rows/sec for several rows per SQLFetch call
+// usage: bench_odbc sql_server_connection_string [rows]
+// creates table bench_fetch with rows transaction-like rows (generated by the server), reads it
+// back with each fetch_rows setting and drops it; fetch_rows 1 is one driver call per row
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void report(const std::string& name, size_t nbr_rows, double seconds);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//main
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cerr << "usage: bench_odbc sql_server_connection_string [rows]" << std::endl;
+    return 1;
+  }
+  size_t nbr_rows = 200000;
+  if (argc > 2)
+  {
+    nbr_rows = static_cast<size_t>(std::atol(argv[2]));
+  }
+
+  odbc db;
+  if (db.connect(argv[1]) < 0)
+  {
+    std::cerr << "cannot connect to SQL Server" << std::endl;
+    return 1;
+  }
+
+  std::string sql = "DROP TABLE IF EXISTS bench_fetch; CREATE TABLE bench_fetch (id INT NOT NULL, date VARCHAR(20) NOT NULL, "
+    "department VARCHAR(50) NOT NULL, vendor VARCHAR(100) NOT NULL, amount FLOAT NOT NULL, status VARCHAR(20) NOT NULL);";
+  if (db.exec_direct(sql) < 0) return 1;
+  sql = "WITH n AS (SELECT TOP (" + std::to_string(nbr_rows) + ") ROW_NUMBER() OVER (ORDER BY (SELECT NULL)) AS i "
+    "FROM sys.all_objects a CROSS JOIN sys.all_objects b CROSS JOIN sys.all_objects c) "
+    "INSERT INTO bench_fetch SELECT i, CONVERT(VARCHAR(10), DATEADD(day, i % 365, '2025-01-01'), 23), "
+    "CHOOSE(i % 5 + 1, 'IT', 'HR', 'Finance', 'Operations', 'Procurement'), CONCAT('Vendor ', i % 1000), "
+    "100.0 + i % 5000, CASE WHEN i % 10 = 0 THEN 'Pending' ELSE 'Approved' END FROM n;";
+  if (db.exec_direct(sql) < 0) return 1;
+
+  const std::string query = "SELECT id, date, department, vendor, amount, status FROM bench_fetch";
+  const size_t fetch_rows[] = { 1, 10, 100, 1000, 5000 };
+  for (size_t idx = 0; idx < sizeof(fetch_rows) / sizeof(fetch_rows[0]); idx++)
+  {
+    db.set_fetch_rows(fetch_rows[idx]);
+    std::cout << "fetch_rows " << fetch_rows[idx] << std::endl;
+
+    table_t table;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    db.fetch(query, table);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    report("  fetch", table.rows.size(), elapsed.count());
+
+    size_t nbr_visited = 0;
+    start = std::chrono::steady_clock::now();
+    db.fetch_each(query, [&nbr_visited](const row_view_t&) { nbr_visited++; return true; });
+    elapsed = std::chrono::steady_clock::now() - start;
+    report("  fetch_each", nbr_visited, elapsed.count());
+  }
+
+  db.exec_direct("DROP TABLE bench_fetch;");
+  db.disconnect();
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// report
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void report(const std::string& name, size_t nbr_rows, double seconds)
+{
+  std::cout << std::left << std::setw(14) << name << std::right
+    << std::setw(10) << nbr_rows << " rows "
+    << std::fixed << std::setprecision(3) << std::setw(10) << seconds << " s "
+    << std::setprecision(0) << std::setw(12) << (nbr_rows / seconds) << " rows/sec" << std::endl;
+}
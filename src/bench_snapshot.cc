@@ -0,0 +1,254 @@
+#include "snapshot.hh"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// bench_snapshot
+// FinMartSnapshot::group_by latency on 1M and 10M generated transactions, on 1M, 10M and 100M
+// with "all", or on rows given
+// usage: bench_snapshot [rows|all] [threads]
+//
+// rows are generated in memory (no database): 365 dates, 5 departments, 8 categories,
+// 1000 vendors, 3 statuses, 5 source systems. Each query runs on 1, 2, 4 ... threads up to
+// threads (default: hardware threads); the median of REPEAT runs is reported in microseconds,
+// and every result must have the same groups and counts as the one thread result. 100M rows
+// need about 4 GB
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const int REPEAT = 5;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// generated_source_t
+// row source for FinMartSnapshot::load, latest first like the databases
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct generated_source_t
+{
+  size_t nbr_rows;
+  std::vector<std::string> dates;
+  std::vector<std::string> vendors;
+
+  generated_source_t(size_t nbr_rows) : nbr_rows(nbr_rows)
+  {
+    const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    for (int month = 12; month >= 1; month--)
+    {
+      for (int day = days[month - 1]; day >= 1; day--)
+      {
+        char date[32];
+        snprintf(date, sizeof(date), "2025-%02d-%02d", month, day);
+        dates.push_back(date);
+      }
+    }
+    for (size_t idx = 0; idx < 1000; idx++)
+    {
+      vendors.push_back("Vendor " + std::to_string(idx));
+    }
+  }
+
+  int for_each_transaction(const transaction_filter&, const std::function<bool(const transaction_view&)>& visit)
+  {
+    const char* departments[] = { "IT", "HR", "Finance", "Operations", "Procurement" };
+    const char* categories[] = { "Software", "Hardware", "Services", "Travel", "Training", "Supplies", "Facilities", "Consulting" };
+    const char* statuses[] = { "Approved", "Pending", "Rejected" };
+    const char* sources[] = { "PeopleSoft", "Coupa", "SAP", "MicroStrategy", "Legacy" };
+
+    transaction_view t;
+    for (size_t row = 0; row < nbr_rows; row++)
+    {
+      t.id = static_cast<int>(nbr_rows - row);
+      t.date = dates[row * dates.size() / nbr_rows];
+      t.department = departments[(row * 7) % 5];
+      t.category = categories[(row / 3) % 8];
+      t.vendor = vendors[(row * 31) % 1000];
+      t.amount = 10.0 + static_cast<double>((row * 2654435761u) % 500000) / 100.0;
+      t.status = statuses[row % 10 == 0 ? 1 : (row % 97 == 0 ? 2 : 0)];
+      t.source_system = sources[(row / 11) % 5];
+      if (!visit(t))
+      {
+        break;
+      }
+    }
+    return 0;
+  }
+
+  int for_each_financial_record(const std::function<bool(const financial_record_view&)>&)
+  {
+    return 0;
+  }
+
+  std::vector<std::string> get_departments()
+  {
+    return { "Finance", "HR", "IT", "Operations", "Procurement" };
+  }
+
+  std::vector<std::string> get_companies()
+  {
+    return std::vector<std::string>();
+  }
+};
+
+struct query_t
+{
+  const char* name;
+  std::vector<FinMartSnapshot::dimension_t> dimensions;
+  transaction_filter filter;
+};
+
+int run(size_t nbr_rows, size_t nbr_threads);
+std::vector<size_t> thread_counts(size_t nbr_threads);
+double median_us(const FinMartSnapshot& snapshot, const query_t& query, size_t nbr_threads, FinMartSnapshot::groups_t& groups);
+bool same_groups(const FinMartSnapshot::groups_t& a, const FinMartSnapshot::groups_t& b);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//main
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+  std::vector<size_t> sizes = { 1000000, 10000000 };
+  size_t nbr_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  if (argc > 1 && std::string(argv[1]) == "all")
+  {
+    sizes.push_back(100000000);
+  }
+  else if (argc > 1)
+  {
+    sizes.assign(1, static_cast<size_t>(std::atol(argv[1])));
+  }
+  if (argc > 2)
+  {
+    nbr_threads = std::max<size_t>(1, static_cast<size_t>(std::atol(argv[2])));
+  }
+
+  for (size_t idx = 0; idx < sizes.size(); idx++)
+  {
+    if (run(sizes[idx], nbr_threads) < 0)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// run
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int run(size_t nbr_rows, size_t nbr_threads)
+{
+  generated_source_t source(nbr_rows);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::shared_ptr<const FinMartSnapshot> snapshot = FinMartSnapshot::load(source, "generated");
+  std::chrono::duration<double> load = std::chrono::steady_clock::now() - start;
+  if (!snapshot)
+  {
+    std::cerr << "cannot load snapshot" << std::endl;
+    return -1;
+  }
+
+  std::vector<query_t> queries =
+  {
+    { "department", { FinMartSnapshot::DEPARTMENT }, transaction_filter() },
+    { "source_system", { FinMartSnapshot::SOURCE_SYSTEM }, transaction_filter() },
+    { "department,status", { FinMartSnapshot::DEPARTMENT, FinMartSnapshot::STATUS }, transaction_filter() },
+    { "dept,category,vendor", { FinMartSnapshot::DEPARTMENT, FinMartSnapshot::CATEGORY, FinMartSnapshot::VENDOR }, transaction_filter() },
+    { "vendor,date", { FinMartSnapshot::VENDOR, FinMartSnapshot::DATE }, transaction_filter() },
+    { "department, Pending", { FinMartSnapshot::DEPARTMENT }, transaction_filter() },
+  };
+  queries.back().filter.status = "Pending";
+
+  std::vector<size_t> counts = thread_counts(nbr_threads);
+  std::cout << nbr_rows << " rows, loaded in " << std::fixed << std::setprecision(2) << load.count() << " s" << std::endl;
+  std::cout << std::left << std::setw(24) << "query" << std::right << std::setw(10) << "groups";
+  for (size_t idx = 0; idx < counts.size(); idx++)
+  {
+    std::cout << std::setw(14) << std::to_string(counts[idx]) + (counts[idx] == 1 ? " thread us" : " threads us");
+  }
+  std::cout << std::setw(14) << "Mrows/s" << std::endl;
+
+  for (size_t idx = 0; idx < queries.size(); idx++)
+  {
+    FinMartSnapshot::groups_t single;
+    std::vector<double> times;
+    times.push_back(median_us(*snapshot, queries[idx], 1, single));
+    for (size_t count = 1; count < counts.size(); count++)
+    {
+      FinMartSnapshot::groups_t parallel;
+      times.push_back(median_us(*snapshot, queries[idx], counts[count], parallel));
+      if (!same_groups(single, parallel))
+      {
+        std::cerr << queries[idx].name << ": results differ between 1 and " << counts[count] << " threads" << std::endl;
+        return -1;
+      }
+    }
+    double best_us = *std::min_element(times.begin(), times.end());
+    std::cout << std::left << std::setw(24) << queries[idx].name << std::right << std::setw(10) << single.size()
+      << std::setprecision(0);
+    for (size_t count = 0; count < times.size(); count++)
+    {
+      std::cout << std::setw(14) << times[count];
+    }
+    std::cout << std::setw(14) << (best_us > 0 ? nbr_rows / best_us : 0.0) << std::endl;
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// thread_counts - 1, 2, 4 ... below nbr_threads, then nbr_threads
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<size_t> thread_counts(size_t nbr_threads)
+{
+  std::vector<size_t> counts;
+  for (size_t count = 1; count < nbr_threads; count *= 2)
+  {
+    counts.push_back(count);
+  }
+  counts.push_back(nbr_threads);
+  return counts;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// median_us - median time of REPEAT group_by calls, in microseconds
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double median_us(const FinMartSnapshot& snapshot, const query_t& query, size_t nbr_threads, FinMartSnapshot::groups_t& groups)
+{
+  std::vector<double> times;
+  for (int idx = 0; idx < REPEAT; idx++)
+  {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    groups = snapshot.group_by(query.dimensions, query.filter, nbr_threads);
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    times.push_back(elapsed.count());
+  }
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// same_groups - same keys, counts, min and max; sums within 1e-9 relative (added in another order)
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool same_groups(const FinMartSnapshot::groups_t& a, const FinMartSnapshot::groups_t& b)
+{
+  if (a.size() != b.size()) return false;
+  for (size_t idx = 0; idx < a.size(); idx++)
+  {
+    const FinMartSnapshot::aggregate_t& x = a[idx].aggregate;
+    const FinMartSnapshot::aggregate_t& y = b[idx].aggregate;
+    if (a[idx].key != b[idx].key || x.count != y.count || x.min != y.min || x.max != y.max ||
+      std::fabs(x.sum - y.sum) > 1e-9 * std::max(1.0, std::fabs(x.sum)))
+    {
+      return false;
+    }
+  }
+  return true;
+}
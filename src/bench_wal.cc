@@ -0,0 +1,243 @@
+#include "lite.hh"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// bench_wal
+// dashboard latency while an ETL load writes, rollback journal against the tuned sqlite_profile_t
+// usage: bench_wal [rows] [readers] [db_file]
+//
+// the table is preloaded with rows transactions; each reader thread has its own connection and
+// refreshes the dashboard queries (total, department spending, latest transactions) every 10 ms,
+// first for one second with no writer (idle), then while the ETL load inserts another rows
+// transactions in batches of 5000, one transaction per batch
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const size_t ETL_BATCH = 5000;
+const std::chrono::milliseconds REFRESH_INTERVAL(10);
+
+struct latency_t
+{
+  size_t refreshes = 0;
+  double p50_ms = 0;
+  double p99_ms = 0;
+  double max_ms = 0;
+};
+
+struct wal_result_t
+{
+  double load_seconds = 0;
+  latency_t idle;
+  latency_t load;
+};
+
+wal_result_t run_profile(const std::string& db_file, const sqlite_profile_t& profile, size_t nbr_rows, size_t nbr_readers);
+latency_t run_readers(const std::string& db_file, const sqlite_profile_t& profile, size_t nbr_readers, const std::function<void()>& work);
+int load_rows(finmart_db& writer, size_t nbr_rows, size_t offset);
+std::vector<transaction> make_transactions(size_t nbr_rows, size_t offset);
+void remove_files(const std::string& db_file);
+void report(const std::string& name, size_t nbr_rows, const wal_result_t& result);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//main
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+  size_t nbr_rows = 200000;
+  size_t nbr_readers = 4;
+  std::string db_file = "bench_wal.db";
+  if (argc > 1)
+  {
+    nbr_rows = static_cast<size_t>(std::atol(argv[1]));
+  }
+  if (argc > 2)
+  {
+    nbr_readers = std::max<size_t>(1, static_cast<size_t>(std::atol(argv[2])));
+  }
+  if (argc > 3)
+  {
+    db_file = argv[3];
+  }
+
+  // SQLite defaults, with the same busy timeout so that readers wait instead of failing
+  sqlite_profile_t rollback;
+  rollback.journal_mode = "DELETE";
+  rollback.synchronous = "FULL";
+  rollback.mmap_size = 0;
+  rollback.cache_size = -2000;
+  rollback.temp_store = "DEFAULT";
+
+  sqlite_profile_t tuned;
+
+  std::cout << nbr_rows << " rows, " << nbr_readers << " readers" << std::endl;
+  std::cout << std::left << std::setw(10) << "profile" << std::right
+    << std::setw(10) << "load s" << std::setw(10) << "rows/sec"
+    << std::setw(11) << "idle p50" << std::setw(11) << "idle p99"
+    << std::setw(11) << "load p50" << std::setw(11) << "load p99" << std::setw(11) << "load max" << "  (ms)" << std::endl;
+
+  report("rollback", nbr_rows, run_profile(db_file, rollback, nbr_rows, nbr_readers));
+  report("wal", nbr_rows, run_profile(db_file, tuned, nbr_rows, nbr_readers));
+  remove_files(db_file);
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// run_profile
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+wal_result_t run_profile(const std::string& db_file, const sqlite_profile_t& profile, size_t nbr_rows, size_t nbr_readers)
+{
+  wal_result_t result;
+  remove_files(db_file);
+  finmart_db writer(db_file, true, profile);
+  if (!writer.is_open() || load_rows(writer, nbr_rows, 0) != 0)
+  {
+    std::cerr << "cannot load " << db_file << std::endl;
+    return result;
+  }
+
+  result.idle = run_readers(db_file, profile, nbr_readers, []()
+    {
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+    });
+
+  result.load = run_readers(db_file, profile, nbr_readers, [&writer, &result, nbr_rows]()
+    {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      load_rows(writer, nbr_rows, nbr_rows);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      result.load_seconds = elapsed.count();
+    });
+  return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// run_readers
+// dashboard refresh latency of nbr_readers connections for as long as work runs
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+latency_t run_readers(const std::string& db_file, const sqlite_profile_t& profile, size_t nbr_readers, const std::function<void()>& work)
+{
+  std::atomic<bool> done(false);
+  std::vector<std::vector<double>> latency(nbr_readers);
+  std::vector<std::thread> readers;
+  for (size_t reader = 0; reader < nbr_readers; reader++)
+  {
+    readers.emplace_back([&db_file, &profile, &done, &latency, reader]()
+      {
+        finmart_db db(db_file, false, profile);
+        while (!done)
+        {
+          std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+          db.get_total_spending();
+          db.get_department_spending();
+          db.get_all_transactions();
+          std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+          latency[reader].push_back(elapsed.count());
+          std::this_thread::sleep_for(REFRESH_INTERVAL);
+        }
+      });
+  }
+
+  work();
+  done = true;
+  for (size_t idx = 0; idx < readers.size(); idx++)
+  {
+    readers[idx].join();
+  }
+
+  std::vector<double> all;
+  for (size_t idx = 0; idx < latency.size(); idx++)
+  {
+    all.insert(all.end(), latency[idx].begin(), latency[idx].end());
+  }
+  std::sort(all.begin(), all.end());
+
+  latency_t result;
+  result.refreshes = all.size();
+  if (!all.empty())
+  {
+    result.p50_ms = all[static_cast<size_t>(0.50 * (all.size() - 1))];
+    result.p99_ms = all[static_cast<size_t>(0.99 * (all.size() - 1))];
+    result.max_ms = all.back();
+  }
+  return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// load_rows - ETL load, one transaction per ETL_BATCH rows
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int load_rows(finmart_db& writer, size_t nbr_rows, size_t offset)
+{
+  for (size_t idx = 0; idx < nbr_rows; idx += ETL_BATCH)
+  {
+    std::vector<transaction> batch = make_transactions(std::min(ETL_BATCH, nbr_rows - idx), offset + idx);
+    if (writer.insert_transactions(batch) != 0)
+    {
+      std::cerr << "insert_transactions failed at row " << offset + idx << std::endl;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// report
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void report(const std::string& name, size_t nbr_rows, const wal_result_t& result)
+{
+  std::cout << std::left << std::setw(10) << name << std::right << std::fixed
+    << std::setprecision(3) << std::setw(10) << result.load_seconds
+    << std::setprecision(0) << std::setw(10) << (result.load_seconds > 0 ? nbr_rows / result.load_seconds : 0.0)
+    << std::setprecision(2) << std::setw(11) << result.idle.p50_ms << std::setw(11) << result.idle.p99_ms
+    << std::setw(11) << result.load.p50_ms << std::setw(11) << result.load.p99_ms
+    << std::setw(11) << result.load.max_ms << std::endl;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// remove_files - database, rollback journal and WAL files
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void remove_files(const std::string& db_file)
+{
+  std::remove(db_file.c_str());
+  std::remove((db_file + "-journal").c_str());
+  std::remove((db_file + "-wal").c_str());
+  std::remove((db_file + "-shm").c_str());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// make_transactions
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<transaction> make_transactions(size_t nbr_rows, size_t offset)
+{
+  const char* departments[] = { "IT", "HR", "Finance", "Operations", "Procurement" };
+  const char* sources[] = { "PeopleSoft", "Coupa", "SAP", "MicroStrategy" };
+
+  std::vector<transaction> transactions(nbr_rows);
+  for (size_t idx = 0; idx < nbr_rows; idx++)
+  {
+    size_t row = offset + idx;
+    transaction& t = transactions[idx];
+    t.id = 0;
+    char date[16];
+    snprintf(date, sizeof(date), "2025-%02d-%02d", static_cast<int>(row % 12 + 1), static_cast<int>(row % 28 + 1));
+    t.date = date;
+    t.department = departments[row % 5];
+    t.category = "Software";
+    t.vendor = "Vendor " + std::to_string(row % 1000);
+    t.amount = 100.0 + (row % 5000);
+    t.status = (row % 10 == 0) ? "Pending" : "Approved";
+    t.source_system = sources[row % 4];
+  }
+  return transactions;
+}
@@ -0,0 +1,487 @@
+#include "columnar.hh"
+#include <cstring>
+#include <cstdio>
+#include <limits>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// align8 - round up to the next 8-byte boundary
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t align8(uint64_t value)
+{
+  return (value + 7) & ~static_cast<uint64_t>(7);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// columnar_writer
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+columnar_writer::columnar_writer(size_t nbr_rows) :
+  nbr_rows(nbr_rows),
+  failed(false)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// add_int32
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int columnar_writer::add_int32(const std::string& name, const std::vector<int32_t>& values)
+{
+  if (values.size() != nbr_rows)
+  {
+    failed = true;
+    return -1;
+  }
+  column_t column;
+  column.name = name;
+  column.type = COLUMNAR::INT32;
+  column.values.resize(nbr_rows * sizeof(int32_t));
+  if (nbr_rows)
+  {
+    std::memcpy(column.values.data(), values.data(), column.values.size());
+  }
+  columns.push_back(std::move(column));
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// add_double
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int columnar_writer::add_double(const std::string& name, const std::vector<double>& values)
+{
+  if (values.size() != nbr_rows)
+  {
+    failed = true;
+    return -1;
+  }
+  column_t column;
+  column.name = name;
+  column.type = COLUMNAR::FLOAT64;
+  column.values.resize(nbr_rows * sizeof(double));
+  if (nbr_rows)
+  {
+    std::memcpy(column.values.data(), values.data(), column.values.size());
+  }
+  columns.push_back(std::move(column));
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// add_string
+// offsets array of nbr_rows + 1 entries, then all values concatenated
+// offsets are uint32_t, a column whose bytes do not fit is rejected
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int columnar_writer::add_string(const std::string& name, const std::vector<std::string_view>& values)
+{
+  if (values.size() != nbr_rows)
+  {
+    failed = true;
+    return -1;
+  }
+  column_t column;
+  column.name = name;
+  column.type = COLUMNAR::STRING;
+
+  uint64_t total = 0;
+  for (size_t idx = 0; idx < nbr_rows; idx++)
+  {
+    total += values[idx].size();
+  }
+  if (total > std::numeric_limits<uint32_t>::max())
+  {
+    failed = true;
+    return -1;
+  }
+
+  std::vector<uint32_t> offsets(nbr_rows + 1);
+  column.data.resize(static_cast<size_t>(total));
+  uint32_t offset = 0;
+  for (size_t idx = 0; idx < nbr_rows; idx++)
+  {
+    offsets[idx] = offset;
+    if (values[idx].size())
+    {
+      std::memcpy(column.data.data() + offset, values[idx].data(), values[idx].size());
+    }
+    offset += static_cast<uint32_t>(values[idx].size());
+  }
+  offsets[nbr_rows] = offset;
+
+  column.values.resize(offsets.size() * sizeof(uint32_t));
+  std::memcpy(column.values.data(), offsets.data(), column.values.size());
+  columns.push_back(std::move(column));
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// write
+// lays out header, directory and buffers, writes to path + ".tmp" and renames over path
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int columnar_writer::write(const std::string& path)
+{
+  if (failed)
+  {
+    return -1;
+  }
+  columnar_header_t header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, COLUMNAR::MAGIC, sizeof(header.magic));
+  header.version = COLUMNAR::VERSION;
+  header.nbr_columns = static_cast<uint32_t>(columns.size());
+  header.nbr_rows = nbr_rows;
+
+  std::vector<columnar_entry_t> entries(columns.size());
+  uint64_t offset = sizeof(columnar_header_t) + entries.size() * sizeof(columnar_entry_t);
+  for (size_t idx = 0; idx < columns.size(); idx++)
+  {
+    const column_t& column = columns[idx];
+    if (column.name.size() >= COLUMNAR::NAME_SIZE)
+    {
+      return -1;
+    }
+    columnar_entry_t& entry = entries[idx];
+    std::memset(&entry, 0, sizeof(entry));
+    std::memcpy(entry.name, column.name.data(), column.name.size());
+    entry.type = column.type;
+    entry.values_offset = align8(offset);
+    entry.values_size = column.values.size();
+    offset = entry.values_offset + entry.values_size;
+    if (column.type == COLUMNAR::STRING)
+    {
+      entry.data_offset = align8(offset);
+      entry.data_size = column.data.size();
+      offset = entry.data_offset + entry.data_size;
+    }
+  }
+
+  std::string tmp = path + ".tmp";
+  FILE* file = std::fopen(tmp.c_str(), "wb");
+  if (!file)
+  {
+    return -1;
+  }
+
+  static const char pad[8] = { 0 };
+  uint64_t pos = 0;
+  bool ok = true;
+  auto put = [&](const void* data, size_t size)
+  {
+    if (size && std::fwrite(data, 1, size, file) != size)
+    {
+      ok = false;
+    }
+    pos += size;
+  };
+  auto put_at = [&](uint64_t at)
+  {
+    put(pad, static_cast<size_t>(at - pos));
+  };
+
+  put(&header, sizeof(header));
+  put(entries.data(), entries.size() * sizeof(columnar_entry_t));
+  for (size_t idx = 0; idx < columns.size(); idx++)
+  {
+    put_at(entries[idx].values_offset);
+    put(columns[idx].values.data(), columns[idx].values.size());
+    if (columns[idx].type == COLUMNAR::STRING)
+    {
+      put_at(entries[idx].data_offset);
+      put(columns[idx].data.data(), columns[idx].data.size());
+    }
+  }
+
+  if (std::fclose(file) != 0 || !ok)
+  {
+    std::remove(tmp.c_str());
+    return -1;
+  }
+
+#ifdef _WIN32
+  if (!MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+#else
+  if (std::rename(tmp.c_str(), path.c_str()) != 0)
+#endif
+  {
+    std::remove(tmp.c_str());
+    return -1;
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// columnar_reader
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+columnar_reader::columnar_reader() :
+  buf(nullptr),
+  size(0),
+  header(nullptr),
+  entries(nullptr)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// in_bounds - [offset, offset + length) lies inside a buffer of total bytes, without overflow
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool in_bounds(uint64_t offset, uint64_t length, uint64_t total)
+{
+  return offset <= total && length <= total - offset;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// open
+// validates magic, version and that every column buffer lies inside the input
+// string offsets must start at 0, never decrease and end at data_size
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int columnar_reader::open(const char* data, size_t data_size)
+{
+  buf = nullptr;
+  size = 0;
+  header = nullptr;
+  entries = nullptr;
+
+  if (data_size < sizeof(columnar_header_t))
+  {
+    return -1;
+  }
+  const columnar_header_t* h = reinterpret_cast<const columnar_header_t*>(data);
+  if (std::memcmp(h->magic, COLUMNAR::MAGIC, sizeof(h->magic)) != 0 || h->version != COLUMNAR::VERSION)
+  {
+    return -1;
+  }
+  if (!in_bounds(sizeof(columnar_header_t), static_cast<uint64_t>(h->nbr_columns) * sizeof(columnar_entry_t), data_size))
+  {
+    return -1;
+  }
+
+  const columnar_entry_t* e = reinterpret_cast<const columnar_entry_t*>(data + sizeof(columnar_header_t));
+  for (size_t idx = 0; idx < h->nbr_columns; idx++)
+  {
+    uint64_t width = 0;
+    switch (e[idx].type)
+    {
+    case COLUMNAR::INT32: width = sizeof(int32_t); break;
+    case COLUMNAR::FLOAT64: width = sizeof(double); break;
+    case COLUMNAR::STRING: width = sizeof(uint32_t); break;
+    default: return -1;
+    }
+
+    //nbr_rows comes from the file, bound it by the input size before multiplying
+    if (h->nbr_rows >= data_size / width)
+    {
+      return -1;
+    }
+    uint64_t count = e[idx].type == COLUMNAR::STRING ? h->nbr_rows + 1 : h->nbr_rows;
+    if (e[idx].values_offset % 8 != 0 || e[idx].values_size != count * width ||
+      !in_bounds(e[idx].values_offset, e[idx].values_size, data_size))
+    {
+      return -1;
+    }
+
+    if (e[idx].type == COLUMNAR::STRING)
+    {
+      if (!in_bounds(e[idx].data_offset, e[idx].data_size, data_size))
+      {
+        return -1;
+      }
+      const uint32_t* offsets = reinterpret_cast<const uint32_t*>(data + e[idx].values_offset);
+      if (offsets[0] != 0 || offsets[h->nbr_rows] != e[idx].data_size)
+      {
+        return -1;
+      }
+      for (uint64_t row = 0; row < h->nbr_rows; row++)
+      {
+        if (offsets[row] > offsets[row + 1])
+        {
+          return -1;
+        }
+      }
+    }
+  }
+
+  buf = data;
+  size = data_size;
+  header = h;
+  entries = e;
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// column_index - -1 if there is no column with that name
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int columnar_reader::column_index(const std::string& name) const
+{
+  for (size_t idx = 0; idx < nbr_columns(); idx++)
+  {
+    if (column_name(idx) == name)
+    {
+      return static_cast<int>(idx);
+    }
+  }
+  return -1;
+}
+
+std::string columnar_reader::column_name(size_t col) const
+{
+  const char* name = entries[col].name;
+  return std::string(name, strnlen(name, COLUMNAR::NAME_SIZE));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// column accessors - nullptr if the column has another type
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const int32_t* columnar_reader::int32_column(size_t col) const
+{
+  if (entries[col].type != COLUMNAR::INT32)
+  {
+    return nullptr;
+  }
+  return reinterpret_cast<const int32_t*>(buf + entries[col].values_offset);
+}
+
+const double* columnar_reader::double_column(size_t col) const
+{
+  if (entries[col].type != COLUMNAR::FLOAT64)
+  {
+    return nullptr;
+  }
+  return reinterpret_cast<const double*>(buf + entries[col].values_offset);
+}
+
+std::string_view columnar_reader::string_value(size_t col, size_t row) const
+{
+  const uint32_t* offsets = reinterpret_cast<const uint32_t*>(buf + entries[col].values_offset);
+  const char* data = buf + entries[col].data_offset;
+  return std::string_view(data + offsets[row], offsets[row + 1] - offsets[row]);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// columnar_file
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+columnar_file::columnar_file() :
+  m_data(nullptr),
+  m_size(0)
+#ifdef _WIN32
+  , m_file(INVALID_HANDLE_VALUE),
+  m_mapping(nullptr)
+#endif
+{
+}
+
+columnar_file::~columnar_file()
+{
+  close();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// open - map the whole file read-only and validate it
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int columnar_file::open(const std::string& path)
+{
+  close();
+
+#ifdef _WIN32
+  m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (m_file == INVALID_HANDLE_VALUE)
+  {
+    return -1;
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(m_file, &file_size) || file_size.QuadPart == 0)
+  {
+    close();
+    return -1;
+  }
+  m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!m_mapping)
+  {
+    close();
+    return -1;
+  }
+  m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!m_data)
+  {
+    close();
+    return -1;
+  }
+  m_size = static_cast<size_t>(file_size.QuadPart);
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0)
+  {
+    ::close(fd);
+    return -1;
+  }
+  void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED)
+  {
+    return -1;
+  }
+  m_data = static_cast<const char*>(addr);
+  m_size = static_cast<size_t>(st.st_size);
+#endif
+
+  if (m_reader.open(m_data, m_size) < 0)
+  {
+    close();
+    return -1;
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// close
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void columnar_file::close()
+{
+  m_reader = columnar_reader();
+#ifdef _WIN32
+  if (m_data)
+  {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mapping)
+  {
+    CloseHandle(m_mapping);
+  }
+  if (m_file != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(m_file);
+  }
+  m_mapping = nullptr;
+  m_file = INVALID_HANDLE_VALUE;
+#else
+  if (m_data)
+  {
+    munmap(const_cast<char*>(m_data), m_size);
+  }
+#endif
+  m_data = nullptr;
+  m_size = 0;
+}
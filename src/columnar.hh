@@ -0,0 +1,148 @@
+#ifndef COLUMNAR_HH
+#define COLUMNAR_HH
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// columnar binary format
+//
+// Column-oriented export for consumers on the same host; a reader maps the file and reads the
+// column arrays in place, nothing is parsed or copied.
+// Layout follows the Arrow idea of one contiguous buffer per column (fixed width values, or
+// offsets + bytes for strings) in a simpler container. Native little-endian, every buffer starts
+// on an 8-byte boundary.
+//
+//   header          magic "FMCOL01", version, number of columns, number of rows
+//   directory       one columnar_entry_t per column
+//   buffers         INT32:   int32_t[rows]
+//                   FLOAT64: double[rows]
+//                   STRING:  uint32_t offsets[rows + 1], then the UTF-8 bytes;
+//                            value i is bytes[offsets[i], offsets[i + 1])
+//
+// String offsets are 32-bit, so one string column holds at most 4 GB of bytes; the writer
+// refuses larger columns. The reader checks every size and offset against the input before
+// handing out pointers, a truncated or corrupt file fails open() instead of reading past the end.
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace COLUMNAR
+{
+  const char MAGIC[8] = { 'F', 'M', 'C', 'O', 'L', '0', '1', '\0' };
+  const uint32_t VERSION = 1;
+  const size_t NAME_SIZE = 32;
+
+  enum column_type : uint32_t
+  {
+    INT32 = 1,
+    FLOAT64 = 2,
+    STRING = 3
+  };
+}
+
+struct columnar_header_t
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t nbr_columns;
+  uint64_t nbr_rows;
+  uint64_t reserved;
+};
+
+struct columnar_entry_t
+{
+  char name[COLUMNAR::NAME_SIZE];
+  uint32_t type;
+  uint32_t reserved;
+  uint64_t values_offset; // fixed width values, or string offsets
+  uint64_t values_size;
+  uint64_t data_offset; // string bytes (0 for fixed width columns)
+  uint64_t data_size;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// columnar_writer
+// collects columns of the same length and writes them to a file
+// the file is written under a temporary name and renamed, readers never see a partial file
+// an add_* call with the wrong number of values, or a string column over 4 GB, returns -1 and
+// makes write() fail
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class columnar_writer
+{
+public:
+  columnar_writer(size_t nbr_rows);
+  int add_int32(const std::string& name, const std::vector<int32_t>& values);
+  int add_double(const std::string& name, const std::vector<double>& values);
+  int add_string(const std::string& name, const std::vector<std::string_view>& values);
+  int write(const std::string& path);
+
+private:
+  struct column_t
+  {
+    std::string name;
+    uint32_t type;
+    std::vector<char> values;
+    std::vector<char> data;
+  };
+  size_t nbr_rows;
+  bool failed;
+  std::vector<column_t> columns;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// columnar_reader
+// zero-copy view over a columnar buffer (usually a columnar_file mapping)
+// pointers and string_views stay valid while the underlying buffer is alive
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class columnar_reader
+{
+public:
+  columnar_reader();
+  int open(const char* buf, size_t size);
+  size_t nbr_rows() const { return header ? static_cast<size_t>(header->nbr_rows) : 0; }
+  size_t nbr_columns() const { return header ? header->nbr_columns : 0; }
+  int column_index(const std::string& name) const;
+  std::string column_name(size_t col) const;
+  uint32_t column_type(size_t col) const { return entries[col].type; }
+  const int32_t* int32_column(size_t col) const;
+  const double* double_column(size_t col) const;
+  std::string_view string_value(size_t col, size_t row) const;
+
+private:
+  const char* buf;
+  size_t size;
+  const columnar_header_t* header;
+  const columnar_entry_t* entries;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// columnar_file
+// read-only memory mapping of a columnar file
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class columnar_file
+{
+public:
+  columnar_file();
+  ~columnar_file();
+  int open(const std::string& path);
+  void close();
+  const columnar_reader& reader() const { return m_reader; }
+
+private:
+  columnar_file(const columnar_file&) = delete;
+  columnar_file& operator=(const columnar_file&) = delete;
+  const char* m_data;
+  size_t m_size;
+#ifdef _WIN32
+  void* m_file;
+  void* m_mapping;
+#endif
+  columnar_reader m_reader;
+};
+
+#endif
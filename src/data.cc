@@ -1,20 +1,16 @@
 #include "data.hh"
 #include "app.hh"
 #include "db_interface.hh"
-#include "odbc.hh"
+#include "db_executor.hh"
+#include "snapshot.hh"
+#include "manager.hh"
 #include <Wt/WBreak.h>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
-#define USE_SQLSERVER 0
-
-#if USE_SQLSERVER
-const DatabaseBackend DB_BACKEND = DatabaseBackend::SQLSERVER;
-const std::string DB_CONNECTION = make_conn("localhost", "finmart_db", "", "");
-#else
-const DatabaseBackend DB_BACKEND = DatabaseBackend::SQLITE;
-const std::string DB_CONNECTION = "finmart.db";
-#endif
+// rows per page of the transactions grid
+const size_t TRANSACTIONS_PAGE_SIZE = 100;
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // WidgetView
@@ -41,17 +37,12 @@ WidgetView::WidgetView(WApplicationStrategy* app)
 
   Wt::WPushButton* run_etl_btn = toolbar->addWidget(std::make_unique<Wt::WPushButton>("Run ETL"));
   run_etl_btn->setStyleClass("btn btn-sm btn-info");
-  run_etl_btn->clicked().connect(this, &WidgetView::load_data);
+  run_etl_btn->clicked().connect(this, &WidgetView::run_etl);
 
   toolbar->addWidget(std::make_unique<Wt::WText>(" Filter: "));
 
   filter_combo = toolbar->addWidget(std::make_unique<Wt::WComboBox>());
-  filter_combo->addItem("All Departments");
-  filter_combo->addItem("IT");
-  filter_combo->addItem("HR");
-  filter_combo->addItem("Finance");
-  filter_combo->addItem("Operations");
-  filter_combo->addItem("Procurement");
+  filter_combo->addItem("All Departments"); // departments are added by show_departments
   filter_combo->changed().connect(this, &WidgetView::apply_filter);
 
   status_text = toolbar->addWidget(std::make_unique<Wt::WText>());
@@ -76,6 +67,20 @@ WidgetView::WidgetView(WApplicationStrategy* app)
   addWidget(std::make_unique<Wt::WBreak>());
 
   addWidget(std::make_unique<Wt::WText>("<h4>Recent Transactions</h4>"));
+
+  Wt::WContainerWidget* pager = addWidget(std::make_unique<Wt::WContainerWidget>());
+  pager->setStyleClass("toolbar");
+  newer_btn = pager->addWidget(std::make_unique<Wt::WPushButton>("Newer"));
+  newer_btn->setStyleClass("btn btn-sm btn-outline-secondary");
+  newer_btn->clicked().connect(this, &WidgetView::newer_page);
+  older_btn = pager->addWidget(std::make_unique<Wt::WPushButton>("Older"));
+  older_btn->setStyleClass("btn btn-sm btn-outline-secondary");
+  older_btn->clicked().connect(this, &WidgetView::older_page);
+  page_text = pager->addWidget(std::make_unique<Wt::WText>());
+  page_text->setStyleClass("status-text");
+  newer_btn->disable();
+  older_btn->disable();
+
   table = addWidget(std::make_unique<Wt::WTable>());
   table->setStyleClass("table table-striped table-hover data-table");
   table->setHeaderCount(1);
@@ -92,118 +97,389 @@ void WidgetView::refresh()
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // load_data
+// totals, department summary and the first page of the grid, from the snapshot or in one job
+// on the executor
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void WidgetView::load_data()
 {
-  IFinMartDatabase* db = DatabaseFactory::create(DB_BACKEND, DB_CONNECTION);
-  
-  if (!db)
+  filter = selected_filter();
+  page_starts.assign(1, transaction_cursor());
+  transaction_filter requested = filter;
+
+  std::shared_ptr<const FinMartSnapshot> snapshot = finmart_snapshot();
+  if (snapshot)
   {
-    status_text->setText("Error: Could not create database instance");
+    show_dashboard(ready_result(read_dashboard(*snapshot, requested)));
     return;
   }
 
-  std::string backend_name = db->get_backend_name();
-  status_text->setText("Loading data from " + backend_name + "...");
+  set_loading(backend_name.empty() ? "Loading data..." : "Loading data from " + backend_name + "...");
+  app->run_query<dashboard_t>(this, [requested](IFinMartDatabase* db)
+    {
+      return read_dashboard(*db, requested);
+    }, &WidgetView::show_dashboard);
+}
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// read_dashboard - S is IFinMartDatabase or FinMartSnapshot
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename S>
+WidgetView::dashboard_t WidgetView::read_dashboard(S& source, const transaction_filter& filter)
+{
+  dashboard_t dashboard;
+  dashboard.backend_name = source.get_backend_name();
+  dashboard.total = source.get_total_spending();
+  dashboard.spending = source.get_department_spending();
+  dashboard.departments = source.get_departments();
+  dashboard.filter = filter;
+  dashboard.page = source.get_transactions_page(filter, transaction_cursor(), TRANSACTIONS_PAGE_SIZE);
+  return dashboard;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// run_etl
+// "Run ETL": stages, checks and publishes the load, then reloads the shared snapshot, all on the
+// executor (the job's own connection is not used); then the view
+// the MicroStrategy extract is not part of this tree yet, the load step is empty
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WidgetView::run_etl()
+{
+  set_loading("Running ETL...");
+  app->run_query<int>(this, [](IFinMartDatabase*)
+    {
+      DataManager manager;
+      return manager.run_etl(finmart_pool(), nullptr);
+    }, &WidgetView::show_etl_result);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// show_etl_result - a failed run keeps the published data and the previous snapshot, the view
+// reloads anyway
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WidgetView::show_etl_result(std::shared_future<int> result)
+{
+  bool published = false;
   try
   {
-    if (!db->is_open())
-    {
-      status_text->setText("Error: Database not connected");
-      delete db;
-      return;
-    }
+    published = result.get() == 0;
+  }
+  catch (const std::exception&)
+  {
+  }
+  load_data();
+  if (!published)
+  {
+    app->set_status("ETL failed, the previous data is kept", true);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// show_dashboard
+// the grid page is dropped if the filter was changed while the dashboard was loading, the
+// page asked for by apply_filter is then on its way
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WidgetView::show_dashboard(std::shared_future<dashboard_t> result)
+{
+  try
+  {
+    const dashboard_t& dashboard = result.get();
+    backend_name = dashboard.backend_name;
 
-    double total = db->get_total_spending();
     std::stringstream ss;
     ss << "<div style='font-size:1.5em;padding:15px;background:#e3f2fd;border-radius:5px;margin:10px 0;'>"
-      << "<b>Total Spending:</b> $" << std::fixed << std::setprecision(2) << total
+      << "<b>Total Spending:</b> $" << std::fixed << std::setprecision(2) << dashboard.total
       << " <span style='font-size:0.6em;color:#666;'>(" << backend_name << ")</span>"
       << "</div>";
     total_spending_text->setText(ss.str());
 
-    show_department_summary(db);
-    std::vector<transaction> transactions = db->get_all_transactions();
-    table->clear();
+    show_departments(dashboard.departments);
+    show_department_summary(dashboard.spending);
+
+    if (dashboard.filter == filter)
+    {
+      page = dashboard.page;
+      show_page();
+      start_prefetch();
+    }
+    app->set_status("FinMart data refreshed (" + backend_name + ")");
+  }
+  catch (const std::exception& e)
+  {
+    status_text->setText("Error loading data: " + std::string(e.what()));
+    app->set_status("Database error", true);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// show_departments
+// fills the filter after "All Departments" with the reference list, keeping the selection; the
+// combo is left alone when the list did not change
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WidgetView::show_departments(const std::vector<std::string>& departments)
+{
+  bool same = filter_combo->count() == static_cast<int>(departments.size()) + 1;
+  for (size_t idx = 0; same && idx < departments.size(); idx++)
+  {
+    same = filter_combo->itemText(static_cast<int>(idx) + 1).toUTF8() == departments[idx];
+  }
+  if (same)
+  {
+    return;
+  }
+
+  Wt::WString selected = filter_combo->currentText();
+  filter_combo->clear();
+  filter_combo->addItem("All Departments");
+  for (size_t idx = 0; idx < departments.size(); idx++)
+  {
+    filter_combo->addItem(departments[idx]);
+  }
+  filter_combo->setCurrentIndex(std::max(filter_combo->findText(selected), 0));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// set_loading
+// status shown while a query runs; the pager is enabled again by show_page
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WidgetView::set_loading(const std::string& message)
+{
+  status_text->setText(message);
+  newer_btn->disable();
+  older_btn->disable();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// show_page
+// renders the current page, whose rows all match the filter
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WidgetView::show_page()
+{
+  table->clear();
+
+  table->elementAt(0, 0)->addWidget(std::make_unique<Wt::WText>("<b>ID</b>"));
+  table->elementAt(0, 1)->addWidget(std::make_unique<Wt::WText>("<b>Date</b>"));
+  table->elementAt(0, 2)->addWidget(std::make_unique<Wt::WText>("<b>Department</b>"));
+  table->elementAt(0, 3)->addWidget(std::make_unique<Wt::WText>("<b>Category</b>"));
+  table->elementAt(0, 4)->addWidget(std::make_unique<Wt::WText>("<b>Vendor</b>"));
+  table->elementAt(0, 5)->addWidget(std::make_unique<Wt::WText>("<b>Amount</b>"));
+  table->elementAt(0, 6)->addWidget(std::make_unique<Wt::WText>("<b>Status</b>"));
+  table->elementAt(0, 7)->addWidget(std::make_unique<Wt::WText>("<b>Source</b>"));
+
+  int row = 1;
+  int count = 0;
+  for (size_t idx = 0; idx < page.rows.size(); idx++)
+  {
+    const transaction& t = page.rows[idx];
+
+    table->elementAt(row, 0)->addWidget(
+      std::make_unique<Wt::WText>(std::to_string(t.id)));
+    table->elementAt(row, 1)->addWidget(
+      std::make_unique<Wt::WText>(t.date));
+    table->elementAt(row, 2)->addWidget(
+      std::make_unique<Wt::WText>(t.department));
+    table->elementAt(row, 3)->addWidget(
+      std::make_unique<Wt::WText>(t.category));
+    table->elementAt(row, 4)->addWidget(
+      std::make_unique<Wt::WText>(t.vendor));
+
+    std::stringstream amt_str;
+    amt_str << "$" << std::fixed << std::setprecision(2) << t.amount;
+    table->elementAt(row, 5)->addWidget(
+      std::make_unique<Wt::WText>(amt_str.str()));
+
+    std::string status_style = (t.status == "Pending")
+      ? "color:orange;font-weight:bold;"
+      : "color:green;";
+    table->elementAt(row, 6)->addWidget(
+      std::make_unique<Wt::WText>("<span style='" + status_style + "'>" + t.status + "</span>"));
 
-    table->elementAt(0, 0)->addWidget(std::make_unique<Wt::WText>("<b>ID</b>"));
-    table->elementAt(0, 1)->addWidget(std::make_unique<Wt::WText>("<b>Date</b>"));
-    table->elementAt(0, 2)->addWidget(std::make_unique<Wt::WText>("<b>Department</b>"));
-    table->elementAt(0, 3)->addWidget(std::make_unique<Wt::WText>("<b>Category</b>"));
-    table->elementAt(0, 4)->addWidget(std::make_unique<Wt::WText>("<b>Vendor</b>"));
-    table->elementAt(0, 5)->addWidget(std::make_unique<Wt::WText>("<b>Amount</b>"));
-    table->elementAt(0, 6)->addWidget(std::make_unique<Wt::WText>("<b>Status</b>"));
-    table->elementAt(0, 7)->addWidget(std::make_unique<Wt::WText>("<b>Source</b>"));
+    std::string source_icon;
+    if (t.source_system == "PeopleSoft") source_icon = "PS ";
+    else if (t.source_system == "Coupa") source_icon = "CO ";
+    else if (t.source_system == "SAP") source_icon = "SAP ";
+    else if (t.source_system == "MicroStrategy") source_icon = "MS ";
+    else source_icon = "LG ";
 
-    std::string filter = filter_combo->currentText().toUTF8();
+    table->elementAt(row, 7)->addWidget(
+      std::make_unique<Wt::WText>(source_icon + t.source_system));
+
+    row++;
+    count++;
+  }
+
+  newer_btn->setEnabled(page_starts.size() > 1);
+  older_btn->setEnabled(page.has_more);
+  page_text->setText(" Page " + std::to_string(page_starts.size()));
+  status_text->setText("Loaded " + std::to_string(count) + " transactions from " + backend_name);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// older_page
+// takes the prefetched page when it is the one asked for and has arrived, otherwise asks for it
+/////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    int row = 1;
-    int count = 0;
-    for (size_t idx = 0; idx < transactions.size(); idx++)
+void WidgetView::older_page()
+{
+  if (!page.has_more)
+  {
+    return;
+  }
+  transaction_cursor after = page.next;
+  page_starts.push_back(after);
+
+  if (prefetch.valid() && prefetch_after == after && prefetch_filter == filter &&
+    prefetch.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+  {
+    try
     {
-      const transaction& t = transactions[idx];
-      if (filter != "All Departments" && t.department != filter)
-        continue;
-
-      table->elementAt(row, 0)->addWidget(
-        std::make_unique<Wt::WText>(std::to_string(t.id)));
-      table->elementAt(row, 1)->addWidget(
-        std::make_unique<Wt::WText>(t.date));
-      table->elementAt(row, 2)->addWidget(
-        std::make_unique<Wt::WText>(t.department));
-      table->elementAt(row, 3)->addWidget(
-        std::make_unique<Wt::WText>(t.category));
-      table->elementAt(row, 4)->addWidget(
-        std::make_unique<Wt::WText>(t.vendor));
-
-      std::stringstream amt_str;
-      amt_str << "$" << std::fixed << std::setprecision(2) << t.amount;
-      table->elementAt(row, 5)->addWidget(
-        std::make_unique<Wt::WText>(amt_str.str()));
-
-      std::string status_style = (t.status == "Pending")
-        ? "color:orange;font-weight:bold;"
-        : "color:green;";
-      table->elementAt(row, 6)->addWidget(
-        std::make_unique<Wt::WText>("<span style='" + status_style + "'>" + t.status + "</span>"));
-
-      std::string source_icon;
-      if (t.source_system == "PeopleSoft") source_icon = "PS ";
-      else if (t.source_system == "Coupa") source_icon = "CO ";
-      else if (t.source_system == "SAP") source_icon = "SAP ";
-      else if (t.source_system == "MicroStrategy") source_icon = "MS ";
-      else source_icon = "LG ";
-
-      table->elementAt(row, 7)->addWidget(
-        std::make_unique<Wt::WText>(source_icon + t.source_system));
-
-      row++;
-      count++;
+      page = prefetch.get();
+      show_page();
+      start_prefetch();
+      return;
     }
+    catch (const std::exception&)
+    {
+      // the prefetch failed, ask again
+    }
+  }
+  request_page();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// newer_page
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WidgetView::newer_page()
+{
+  if (page_starts.size() < 2)
+  {
+    return;
+  }
+  page_starts.pop_back();
+  request_page();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// request_page
+// reads the page at page_starts.back() with the current filter, from the snapshot or on the
+// executor
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WidgetView::request_page()
+{
+  transaction_filter requested = filter;
+  transaction_cursor after = page_starts.back();
+
+  std::shared_ptr<const FinMartSnapshot> snapshot = finmart_snapshot();
+  if (snapshot)
+  {
+    show_requested_page(ready_result(read_page(*snapshot, requested, after)));
+    return;
+  }
+
+  set_loading("Loading page " + std::to_string(page_starts.size()) + "...");
+  app->run_query<page_result_t>(this, [requested, after](IFinMartDatabase* db)
+    {
+      return read_page(*db, requested, after);
+    }, &WidgetView::show_requested_page);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// read_page
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename S>
+WidgetView::page_result_t WidgetView::read_page(S& source, const transaction_filter& filter, const transaction_cursor& after)
+{
+  page_result_t result;
+  result.filter = filter;
+  result.after = after;
+  result.page = source.get_transactions_page(filter, after, TRANSACTIONS_PAGE_SIZE);
+  return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// show_requested_page
+// a page that is not the one asked for last (the user moved on meanwhile) is dropped
+/////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    status_text->setText("Loaded " + std::to_string(count) + " transactions from " + backend_name);
-    app->set_status("FinMart data refreshed - " + std::to_string(count) + " records (" + backend_name + ")");
-    
-    delete db;
+void WidgetView::show_requested_page(std::shared_future<page_result_t> result)
+{
+  try
+  {
+    const page_result_t& requested = result.get();
+    if (!(requested.filter == filter) || !(requested.after == page_starts.back()))
+    {
+      return;
+    }
+    page = requested.page;
+    show_page();
+    start_prefetch();
   }
   catch (const std::exception& e)
   {
-    status_text->setText("Error loading data: " + std::string(e.what()));
+    status_text->setText("Error loading page: " + std::string(e.what()));
+    newer_btn->setEnabled(page_starts.size() > 1);
     app->set_status("Database error", true);
-    delete db;
   }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
-// show_department_summary
+// start_prefetch
+// reads the page after the current one on the executor; the job only touches its connection,
+// never the widget. A prefetch that is not the next page any more is simply abandoned, its
+// future does not wait on destruction. Not needed when pages come from the snapshot
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void WidgetView::show_department_summary(IFinMartDatabase* db)
+void WidgetView::start_prefetch()
 {
-  std::map<std::string, double> spending = db->get_department_spending();
+  if (!page.has_more || finmart_snapshot())
+  {
+    return;
+  }
+  if (prefetch.valid() && prefetch_after == page.next && prefetch_filter == filter)
+  {
+    return;
+  }
+  prefetch_filter = filter;
+  prefetch_after = page.next;
+  transaction_filter requested = prefetch_filter;
+  transaction_cursor after = prefetch_after;
+  prefetch = finmart_executor().submit<transaction_page>([requested, after](IFinMartDatabase* db)
+    {
+      return db->get_transactions_page(requested, after, TRANSACTIONS_PAGE_SIZE);
+    });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// selected_filter - filter chosen in the toolbar
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+transaction_filter WidgetView::selected_filter() const
+{
+  transaction_filter selected;
+  std::string department = filter_combo->currentText().toUTF8();
+  if (department != "All Departments")
+  {
+    selected.department = department;
+  }
+  return selected;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// show_department_summary
+/////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void WidgetView::show_department_summary(const std::map<std::string, double>& spending)
+{
   summary_table->clear();
 
   summary_table->elementAt(0, 0)->addWidget(std::make_unique<Wt::WText>("<b>Department</b>"));
@@ -246,9 +522,13 @@ void WidgetView::show_source_system_counts(IFinMartDatabase* db)
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // apply_filter
+// reloads the grid from its first page with the new filter; the totals and the department
+// summary do not depend on the filter and are left as they are
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void WidgetView::apply_filter()
 {
-  load_data();
+  filter = selected_filter();
+  page_starts.assign(1, transaction_cursor());
+  request_page();
 }
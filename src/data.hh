@@ -6,12 +6,26 @@
 #include <Wt/WTable.h>
 #include <Wt/WPushButton.h>
 #include <Wt/WComboBox.h>
+#include <future>
+#include <vector>
+#include <map>
+#include "finmart.h"
 
 class WApplicationStrategy;
 class IFinMartDatabase;
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // WidgetView
+// the transactions grid shows one page of get_transactions_page at a time; while a page is
+// shown the next one is read in the background on a pooled connection, so "Older" usually
+// finds it ready
+// data is read from finmart_snapshot() when it is loaded, at once and without SQL; otherwise
+// queries run on finmart_executor() (WApplicationStrategy::run_query): the view shows a loading
+// state and the pager is disabled until the result is pushed back; a result that no longer
+// matches the filter or page asked for last is dropped. "Run ETL" runs DataManager::run_etl on the
+// executor, which publishes the load and reloads the snapshot
+// the department filter lists the reference departments of the last dashboard read (the ref
+// cache of finmart_db, copied into the snapshot when it loads)
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 class WidgetView : public Wt::WContainerWidget
@@ -22,6 +36,23 @@ public:
   void load_data();
 
 private:
+  struct dashboard_t
+  {
+    std::string backend_name;
+    double total = 0;
+    std::map<std::string, double> spending;
+    std::vector<std::string> departments;
+    transaction_filter filter;
+    transaction_page page;
+  };
+
+  struct page_result_t
+  {
+    transaction_filter filter;
+    transaction_cursor after;
+    transaction_page page;
+  };
+
   WApplicationStrategy* app;
   Wt::WText* status_text;
   Wt::WPushButton* refresh_btn;
@@ -29,10 +60,37 @@ private:
   Wt::WTable* summary_table;
   Wt::WText* total_spending_text;
   Wt::WComboBox* filter_combo;
+  Wt::WPushButton* newer_btn;
+  Wt::WPushButton* older_btn;
+  Wt::WText* page_text;
+
+  transaction_filter filter;
+  std::vector<transaction_cursor> page_starts; // cursor of each page up to the one shown
+  transaction_page page;
+  std::future<transaction_page> prefetch;
+  transaction_filter prefetch_filter;
+  transaction_cursor prefetch_after;
+  std::string backend_name;
 
-  void show_department_summary(IFinMartDatabase* db);
+  template<typename S>
+  static dashboard_t read_dashboard(S& source, const transaction_filter& filter);
+  template<typename S>
+  static page_result_t read_page(S& source, const transaction_filter& filter, const transaction_cursor& after);
+  void run_etl();
+  void show_etl_result(std::shared_future<int> result);
+  void show_dashboard(std::shared_future<dashboard_t> result);
+  void show_departments(const std::vector<std::string>& departments);
+  void show_department_summary(const std::map<std::string, double>& spending);
   void show_source_system_counts(IFinMartDatabase* db);
   void apply_filter();
+  void request_page();
+  void show_requested_page(std::shared_future<page_result_t> result);
+  void show_page();
+  void older_page();
+  void newer_page();
+  void start_prefetch();
+  void set_loading(const std::string& message);
+  transaction_filter selected_filter() const;
 };
 
 #endif
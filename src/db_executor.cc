@@ -0,0 +1,106 @@
+#include "db_executor.hh"
+#include <algorithm>
+
+// fewer threads than finmart_pool() connections, so that view prefetches and DataManager calls
+// made outside the executor still find a connection
+const size_t DB_EXECUTOR_THREADS = 4;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// finmart_executor
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DatabaseExecutor& finmart_executor()
+{
+  static DatabaseExecutor executor(finmart_pool(), DB_EXECUTOR_THREADS);
+  return executor;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// DatabaseExecutor
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DatabaseExecutor::DatabaseExecutor(DatabasePool& pool, size_t nbr_threads) :
+  pool(pool),
+  stopping(false)
+{
+  nbr_threads = std::max<size_t>(nbr_threads, 1);
+  for (size_t idx = 0; idx < nbr_threads; idx++)
+  {
+    threads.emplace_back(&DatabaseExecutor::run, this);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// ~DatabaseExecutor
+// jobs already submitted still run, then the threads are joined
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DatabaseExecutor::~DatabaseExecutor()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  ready.notify_all();
+  for (size_t idx = 0; idx < threads.size(); idx++)
+  {
+    threads[idx].join();
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// pending - jobs waiting for a thread
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+size_t DatabaseExecutor::pending()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return jobs.size();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// post
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DatabaseExecutor::post(const job_t& job)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back(job);
+  }
+  ready.notify_one();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// run
+// worker loop: one job at a time on a borrowed connection (nullptr if the pool is unavailable);
+// the connection goes back to the pool before the next job is taken
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DatabaseExecutor::run()
+{
+  while (true)
+  {
+    job_t job;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      ready.wait(lock, [this]() { return stopping || !jobs.empty(); });
+      if (jobs.empty())
+      {
+        return;
+      }
+      job = std::move(jobs.front());
+      jobs.pop_front();
+    }
+
+    try
+    {
+      DatabasePool::Lease db = pool.acquire();
+      job(db.get());
+    }
+    catch (...)
+    {
+      // a throwing callback must not end the worker
+    }
+  }
+}
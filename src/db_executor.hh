@@ -0,0 +1,122 @@
+#ifndef DB_EXECUTOR_HH
+#define DB_EXECUTOR_HH
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <functional>
+#include <condition_variable>
+#include "db_pool.hh"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// DatabaseExecutor
+// worker threads that run database queries off the caller's thread; each job borrows a
+// connection from the pool for as long as it runs, so the caller (a Wt event handler) returns
+// at once and the result arrives later through a future or a callback
+// the callback runs on the worker thread: a Wt view forwards it to its session with
+// WServer::post (see WApplicationStrategy::run_query), it must not touch widgets itself
+// a query that throws, or that finds the pool unavailable, delivers an exception instead of a
+// value; T is the result type of the query, not void
+//
+// Usage:
+//   std::future<double> total = finmart_executor().submit<double>(
+//     [](IFinMartDatabase* db) { return db->get_total_spending(); });
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class DatabaseExecutor
+{
+public:
+  DatabaseExecutor(DatabasePool& pool, size_t nbr_threads);
+  ~DatabaseExecutor();
+
+  template<typename T>
+  std::future<T> submit(const std::function<T(IFinMartDatabase*)>& query);
+  template<typename T>
+  void submit(const std::function<T(IFinMartDatabase*)>& query, const std::function<void(std::shared_future<T>)>& done);
+  size_t pending();
+
+private:
+  typedef std::function<void(IFinMartDatabase*)> job_t;
+  DatabaseExecutor(const DatabaseExecutor&) = delete;
+  DatabaseExecutor& operator=(const DatabaseExecutor&) = delete;
+  void post(const job_t& job);
+  void run();
+  template<typename T>
+  static void fulfil(std::promise<T>& promise, const std::function<T(IFinMartDatabase*)>& query, IFinMartDatabase* db);
+
+  DatabasePool& pool;
+  std::vector<std::thread> threads;
+  std::deque<job_t> jobs;
+  bool stopping;
+  std::mutex mutex;
+  std::condition_variable ready;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// submit
+// future: get() waits for the result, or rethrows what the query threw
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+std::future<T> DatabaseExecutor::submit(const std::function<T(IFinMartDatabase*)>& query)
+{
+  std::shared_ptr<std::promise<T>> promise = std::make_shared<std::promise<T>>();
+  std::future<T> result = promise->get_future();
+  post([promise, query](IFinMartDatabase* db)
+    {
+      fulfil(*promise, query, db);
+    });
+  return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// submit
+// callback: done(result) is called on the worker thread with the ready result
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+void DatabaseExecutor::submit(const std::function<T(IFinMartDatabase*)>& query, const std::function<void(std::shared_future<T>)>& done)
+{
+  std::shared_ptr<std::promise<T>> promise = std::make_shared<std::promise<T>>();
+  std::shared_future<T> result = promise->get_future().share();
+  post([promise, result, query, done](IFinMartDatabase* db)
+    {
+      fulfil(*promise, query, db);
+      done(result);
+    });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// fulfil
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+void DatabaseExecutor::fulfil(std::promise<T>& promise, const std::function<T(IFinMartDatabase*)>& query, IFinMartDatabase* db)
+{
+  try
+  {
+    if (!db)
+    {
+      throw std::runtime_error("database not connected");
+    }
+    promise.set_value(query(db));
+  }
+  catch (...)
+  {
+    promise.set_exception(std::current_exception());
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// finmart_executor
+// process-wide executor on finmart_pool()
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DatabaseExecutor& finmart_executor();
+
+#endif
@@ -1,10 +1,15 @@
 #include "db_interface.hh"
 #include "lite.hh"
 #include "odbc.hh"
-#include <sstream>
-#include <iomanip>
+#include "sqlserver_migrations.hh"
 #include <ctime>
 #include <random>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
+#include <chrono>
+#include <iostream>
+#include <cstdio>
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // FinMartSQLite - SQLite implementation
@@ -16,9 +21,9 @@ private:
   finmart_db* db;
 
 public:
-  FinMartSQLite(const std::string& filename)
+  FinMartSQLite(const std::string& filename, bool initialize)
   {
-    db = new finmart_db(filename);
+    db = new finmart_db(filename, initialize);
   }
 
   ~FinMartSQLite()
@@ -31,6 +36,12 @@ public:
     return db->is_open();
   }
 
+  // a SQLite connection is a file handle, it cannot be dropped by a server
+  bool is_alive(bool) override
+  {
+    return db->is_open();
+  }
+
   std::vector<transaction> get_all_transactions() override
   {
     return db->get_all_transactions();
@@ -51,6 +62,26 @@ public:
     return db->get_total_spending();
   }
 
+  std::map<std::string, double> get_daily_spending(const std::string& date_from, const std::string& date_to) override
+  {
+    return db->get_daily_spending(date_from, date_to);
+  }
+
+  int check_summaries(std::vector<std::string>& mismatches) override
+  {
+    return db->check_summaries(mismatches);
+  }
+
+  std::vector<std::string> get_departments() override
+  {
+    return db->get_departments();
+  }
+
+  std::vector<std::string> get_companies() override
+  {
+    return db->get_companies();
+  }
+
   DatabaseBackend get_backend() const override
   {
     return DatabaseBackend::SQLITE;
@@ -79,8 +110,266 @@ public:
   {
     return db->insert_financial_record(record);
   }
+
+  transaction_page get_transactions_page(const transaction_filter& filter, const transaction_cursor& after,
+    size_t page_size) override
+  {
+    return db->get_transactions_page(filter, after, page_size);
+  }
+
+  int for_each_transaction(const transaction_filter& filter, const std::function<bool(const transaction_view&)>& visit) override
+  {
+    return db->for_each_transaction(filter, visit);
+  }
+
+  int for_each_financial_record(const std::function<bool(const financial_record_view&)>& visit) override
+  {
+    return db->for_each_financial_record(visit);
+  }
+
+  int insert_financial_records(const std::vector<FinancialRecord>& records) override
+  {
+    return db->insert_financial_records(records);
+  }
+
+  int insert_transactions(const std::vector<transaction>& transactions) override
+  {
+    return db->insert_transactions(transactions);
+  }
 };
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// SQLSERVER_SUMMARY_CHECKS
+// for check_summaries: each indexed view, read from its own index (NOEXPAND), and the aggregate of
+// transactions it must equal; EXPAND VIEWS keeps the optimizer from answering the aggregate
+// with the view itself
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct sqlserver_summary_check_t
+{
+  const char* name;
+  const char* summary_sql;
+  const char* base_sql;
+};
+
+const sqlserver_summary_check_t SQLSERVER_SUMMARY_CHECKS[] =
+{
+  { "transactions_by_department", "SELECT department, amount, nbr FROM transactions_by_department WITH (NOEXPAND)",
+    "SELECT department, SUM(amount), COUNT_BIG(*) FROM transactions GROUP BY department OPTION (EXPAND VIEWS)" },
+  { "transactions_by_source_system", "SELECT source_system, amount, nbr FROM transactions_by_source_system WITH (NOEXPAND)",
+    "SELECT source_system, SUM(amount), COUNT_BIG(*) FROM transactions GROUP BY source_system OPTION (EXPAND VIEWS)" },
+  { "transactions_by_day", "SELECT date, amount, nbr FROM transactions_by_day WITH (NOEXPAND)",
+    "SELECT date, SUM(amount), COUNT_BIG(*) FROM transactions GROUP BY date OPTION (EXPAND VIEWS)" },
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// to_params - single-row ODBC parameters for the '?' markers of a filter
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::vector<param_array_t> to_params(const std::vector<sql_value_t>& values)
+{
+  std::vector<param_array_t> params;
+  for (size_t idx = 0; idx < values.size(); idx++)
+  {
+    if (values[idx].is_text)
+    {
+      params.push_back(param_array_t::text(std::max<size_t>(values[idx].text.size(), 1), 1));
+      params.back().set(0, values[idx].text);
+    }
+    else
+    {
+      params.push_back(param_array_t::real(1));
+      params.back().set(0, values[idx].number);
+    }
+  }
+  return params;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// has_types - the typed table has exactly these columns C types
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool has_types(const typed_table_t& table, const std::vector<SQLSMALLINT>& c_types)
+{
+  if (table.cols.size() != c_types.size()) return false;
+  for (size_t idx = 0; idx < c_types.size(); idx++)
+  {
+    if (table.cols[idx].c_type != c_types[idx]) return false;
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// cell_text, cell_double
+// value of a typed cell whatever C type the column was bound with: numbers are formatted or text
+// parsed, a timestamp is its date; NULL is empty or 0
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::string cell_text(const typed_column_t& col, size_t row)
+{
+  if (col.null[row])
+  {
+    return std::string();
+  }
+  char buf[64];
+  switch (col.c_type)
+  {
+  case SQL_C_DOUBLE:
+    snprintf(buf, sizeof(buf), "%.17g", col.doubles[row]);
+    return buf;
+  case SQL_C_SBIGINT:
+    return std::to_string(col.integers[row]);
+  case SQL_C_TYPE_TIMESTAMP:
+    snprintf(buf, sizeof(buf), "%04d-%02d-%02d", col.timestamps[row].year, col.timestamps[row].month, col.timestamps[row].day);
+    return buf;
+  default:
+    return std::string(col.text(row));
+  }
+}
+
+static double cell_double(const typed_column_t& col, size_t row)
+{
+  if (col.null[row])
+  {
+    return 0.0;
+  }
+  switch (col.c_type)
+  {
+  case SQL_C_DOUBLE:
+    return col.doubles[row];
+  case SQL_C_SBIGINT:
+    return static_cast<double>(col.integers[row]);
+  default:
+    return std::atof(cell_text(col, row).c_str());
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// records_from_table
+// financial records of a typed table with the columns period, company_id and the twelve values
+// in FinancialRecord order; when the server reports other types (an INT or DECIMAL amount bound
+// as text, a DATE period) the mismatch is logged and every cell is converted; empty if the
+// number of columns does not match
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::vector<FinancialRecord> records_from_table(const typed_table_t& table)
+{
+  std::vector<FinancialRecord> records;
+  const size_t nbr_cols = 14;
+  if (table.cols.size() != nbr_cols)
+  {
+    std::cerr << "financial_records: " << table.cols.size() << " columns, expected " << nbr_cols << std::endl;
+    return records;
+  }
+
+  std::vector<SQLSMALLINT> c_types(nbr_cols, SQL_C_DOUBLE);
+  c_types[0] = SQL_C_CHAR;
+  c_types[1] = SQL_C_CHAR;
+  records.resize(table.nbr_rows);
+  if (!has_types(table, c_types))
+  {
+    for (size_t idx = 0; idx < nbr_cols; idx++)
+    {
+      if (table.cols[idx].c_type != c_types[idx])
+      {
+        std::cerr << "financial_records: column " << table.cols[idx].name << " has C type " << table.cols[idx].c_type
+          << ", expected " << c_types[idx] << ", converting" << std::endl;
+      }
+    }
+    for (size_t idx = 0; idx < table.nbr_rows; ++idx)
+    {
+      FinancialRecord& r = records[idx];
+      r.period = cell_text(table.cols[0], idx);
+      r.company_id = cell_text(table.cols[1], idx);
+      double* values[] = { &r.revenue, &r.cogs, &r.operating_expenses, &r.depreciation, &r.amortization, &r.interest,
+        &r.taxes, &r.current_assets, &r.current_liabilities, &r.inventory, &r.total_assets, &r.total_liabilities };
+      for (size_t idx_col = 2; idx_col < nbr_cols; idx_col++)
+      {
+        *values[idx_col - 2] = cell_double(table.cols[idx_col], idx);
+      }
+    }
+    return records;
+  }
+
+  for (size_t idx = 0; idx < table.nbr_rows; ++idx)
+  {
+    FinancialRecord& r = records[idx];
+    r.period = std::string(table.cols[0].text(idx));
+    r.company_id = std::string(table.cols[1].text(idx));
+    r.revenue = table.cols[2].doubles[idx];
+    r.cogs = table.cols[3].doubles[idx];
+    r.operating_expenses = table.cols[4].doubles[idx];
+    r.depreciation = table.cols[5].doubles[idx];
+    r.amortization = table.cols[6].doubles[idx];
+    r.interest = table.cols[7].doubles[idx];
+    r.taxes = table.cols[8].doubles[idx];
+    r.current_assets = table.cols[9].doubles[idx];
+    r.current_liabilities = table.cols[10].doubles[idx];
+    r.inventory = table.cols[11].doubles[idx];
+    r.total_assets = table.cols[12].doubles[idx];
+    r.total_liabilities = table.cols[13].doubles[idx];
+  }
+  return records;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// text_param
+// text parameter array for member of count rows, column_size wide or wider if a value is longer;
+// a value that does not fit the table column then fails on the server instead of being truncated
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+static param_array_t text_param(SQLULEN column_size, const T* rows, size_t count, std::string T::* member)
+{
+  size_t longest = column_size;
+  for (size_t row = 0; row < count; row++)
+  {
+    longest = std::max(longest, (rows[row].*member).size());
+  }
+  return param_array_t::text(longest, count);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// financial_record_params
+// parameter arrays of SQL_INSERT_FINANCIAL_RECORD for count records, column sizes follow
+// initialize_schema
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static const std::string SQL_INSERT_FINANCIAL_RECORD = "INSERT INTO financial_records (period, company_id, revenue, cogs, "
+  "operating_expenses, depreciation, amortization, interest, taxes, current_assets, current_liabilities, "
+  "inventory, total_assets, total_liabilities) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+static std::vector<param_array_t> financial_record_params(const FinancialRecord* records, size_t count)
+{
+  std::vector<param_array_t> params;
+  params.push_back(text_param(20, records, count, &FinancialRecord::period));
+  params.push_back(text_param(100, records, count, &FinancialRecord::company_id));
+  for (int idx = 0; idx < 12; idx++)
+  {
+    params.push_back(param_array_t::real(count));
+  }
+
+  for (size_t row = 0; row < count; row++)
+  {
+    const FinancialRecord& r = records[row];
+    params[0].set(row, r.period);
+    params[1].set(row, r.company_id);
+    params[2].set(row, r.revenue);
+    params[3].set(row, r.cogs);
+    params[4].set(row, r.operating_expenses);
+    params[5].set(row, r.depreciation);
+    params[6].set(row, r.amortization);
+    params[7].set(row, r.interest);
+    params[8].set(row, r.taxes);
+    params[9].set(row, r.current_assets);
+    params[10].set(row, r.current_liabilities);
+    params[11].set(row, r.inventory);
+    params[12].set(row, r.total_assets);
+    params[13].set(row, r.total_liabilities);
+  }
+  return params;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // FinMartSQLServer - SQL Server ODBC implementation
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -90,6 +379,25 @@ class FinMartSQLServer : public IFinMartDatabase
 private:
   odbc db;
   bool connected;
+  statement_t insert_record; // insert_financial_record, prepared on first use
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // text_column - values of a query returning one text column
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  std::vector<std::string> text_column(const std::string& sql)
+  {
+    std::vector<std::string> values;
+    typed_table_t table;
+    if (db.fetch(sql, table) == 0 && has_types(table, { SQL_C_CHAR }))
+    {
+      for (size_t idx = 0; idx < table.nbr_rows; idx++)
+      {
+        values.push_back(std::string(table.cols[0].text(idx)));
+      }
+    }
+    return values;
+  }
 
   void initialize_schema()
   {
@@ -143,6 +451,8 @@ private:
         )";
     db.exec_direct(fin_sql);
 
+    migrate_schema();
+
     table_t check;
     db.fetch("SELECT COUNT(*) as cnt FROM transactions", check);
     if (check.rows.size() > 0 && check.rows[0].col[0] == "0")
@@ -179,24 +489,25 @@ private:
     std::uniform_int_distribution<> status_dist(0, 1);
     std::uniform_real_distribution<> amount_dist(100.0, 50000.0);
 
+    std::vector<transaction> transactions(50);
     for (int idx = 0; idx < 50; idx++) {
       std::time_t t = std::time(nullptr) - (idx * 86400);
       std::tm* tm = std::localtime(&t);
       char date_buf[20];
       std::strftime(date_buf, sizeof(date_buf), "%Y-%m-%d", tm);
 
-      std::stringstream sql;
-      sql << "INSERT INTO transactions (date, department, category, vendor, amount, status, source_system) VALUES ('"
-        << date_buf << "', '"
-        << departments[dept_dist(gen)] << "', '"
-        << categories[cat_dist(gen)] << "', '"
-        << vendors[vendor_dist(gen)] << "', "
-        << amount_dist(gen) << ", '"
-        << statuses[status_dist(gen)] << "', '"
-        << sources[source_dist(gen)] << "')";
-
-      db.exec_direct(sql.str());
+      transaction& tr = transactions[idx];
+      tr.id = 0;
+      tr.date = date_buf;
+      tr.department = departments[dept_dist(gen)];
+      tr.category = categories[cat_dist(gen)];
+      tr.vendor = vendors[vendor_dist(gen)];
+      tr.amount = amount_dist(gen);
+      tr.status = statuses[status_dist(gen)];
+      tr.source_system = sources[source_dist(gen)];
     }
+
+    insert_transactions(transactions);
   }
 
   /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -212,6 +523,7 @@ private:
     std::random_device rd;
     std::mt19937 gen(rd());
 
+    std::vector<FinancialRecord> records;
     for (int cidx = 0; cidx < 3; ++cidx)
     {
       double company_factor = 1.0 + (cidx * 0.5);
@@ -219,46 +531,167 @@ private:
       for (int pidx = 0; pidx < 5; ++pidx)
       {
         double growth = 1.0 + (pidx * 0.05);
-        double revenue = base_revenue * company_factor * growth;
-        double cogs = revenue * (0.55 + (gen() % 10) / 100.0);
-        double opex = revenue * (0.20 + (gen() % 5) / 100.0);
-        double depr = revenue * 0.03;
-        double amort = revenue * 0.02;
-        double interest_exp = revenue * 0.02;
-        double taxes_exp = (revenue - cogs - opex - depr - amort - interest_exp) * 0.25;
-        double curr_assets = revenue * 0.4;
-        double curr_liab = revenue * 0.25;
-        double inv = revenue * 0.15;
-        double tot_assets = revenue * 2.0;
-        double tot_liab = revenue * 0.8;
-
-        std::stringstream sql;
-        sql << std::fixed << std::setprecision(2);
-        sql << "INSERT INTO financial_records (period, company_id, revenue, cogs, operating_expenses, "
-          << "depreciation, amortization, interest, taxes, current_assets, current_liabilities, "
-          << "inventory, total_assets, total_liabilities) VALUES ('"
-          << periods[pidx] << "', '" << companies[cidx] << "', "
-          << revenue << ", " << cogs << ", " << opex << ", " << depr << ", " << amort << ", "
-          << interest_exp << ", " << taxes_exp << ", " << curr_assets << ", " << curr_liab << ", "
-          << inv << ", " << tot_assets << ", " << tot_liab << ")";
-
-        db.exec_direct(sql.str());
+
+        FinancialRecord r;
+        r.period = periods[pidx];
+        r.company_id = companies[cidx];
+        r.revenue = base_revenue * company_factor * growth;
+        r.cogs = r.revenue * (0.55 + (gen() % 10) / 100.0);
+        r.operating_expenses = r.revenue * (0.20 + (gen() % 5) / 100.0);
+        r.depreciation = r.revenue * 0.03;
+        r.amortization = r.revenue * 0.02;
+        r.interest = r.revenue * 0.02;
+        r.taxes = (r.revenue - r.cogs - r.operating_expenses - r.depreciation - r.amortization - r.interest) * 0.25;
+        r.current_assets = r.revenue * 0.4;
+        r.current_liabilities = r.revenue * 0.25;
+        r.inventory = r.revenue * 0.15;
+        r.total_assets = r.revenue * 2.0;
+        r.total_liabilities = r.revenue * 0.8;
+        records.push_back(r);
+      }
+    }
+
+    insert_financial_records(records);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // migrate_schema
+  // runs the SQLSERVER_MIGRATIONS newer than schema_version, each in its own transaction together
+  // with its version row (name and seconds the SQL took), and logs each one with its time to
+  // std::cerr; {online} in a migration is replaced by online_index_option() (see migration_sql).
+  // stops at the first failure, returns 0 if the schema is up to date
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  int migrate_schema()
+  {
+    std::string sql = R"(
+            IF NOT EXISTS (SELECT * FROM sys.tables WHERE name = 'schema_version')
+            BEGIN
+                CREATE TABLE schema_version (
+                    version INT PRIMARY KEY,
+                    name VARCHAR(100) NOT NULL,
+                    seconds FLOAT NOT NULL,
+                    applied_at DATETIME NOT NULL DEFAULT GETDATE()
+                )
+            END
+        )";
+    if (db.exec_direct(sql) < 0) return -1;
+
+    table_t table;
+    if (db.fetch("SELECT ISNULL(MAX(version), 0) FROM schema_version", table) < 0 || table.rows.empty())
+    {
+      return -1;
+    }
+    int version = std::atoi(table.rows[0].col[0].c_str());
+    std::string online = online_index_option();
+
+    for (size_t idx = 0; idx < sizeof(SQLSERVER_MIGRATIONS) / sizeof(SQLSERVER_MIGRATIONS[0]); idx++)
+    {
+      const schema_migration_t& migration = SQLSERVER_MIGRATIONS[idx];
+      if (migration.version <= version)
+      {
+        continue;
       }
+
+      if (db.set_manual() < 0) return -1;
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      int ret = db.exec_direct(migration_sql(migration, online));
+      std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+      if (ret == 0)
+      {
+        std::vector<param_array_t> params = to_params({ sql_value_t::from_number(migration.version),
+          sql_value_t::from_text(migration.name), sql_value_t::from_number(seconds.count()) });
+        ret = db.exec_array("INSERT INTO schema_version (version, name, seconds) VALUES (?, ?, ?)", params, 1);
+      }
+      if (ret == 0)
+      {
+        ret = db.commit_transaction();
+      }
+      else
+      {
+        db.rollback_transaction();
+      }
+      db.set_auto_commit();
+      if (ret < 0)
+      {
+        std::cerr << "schema migration " << migration.version << " (" << migration.name << ") failed" << std::endl;
+        return -1;
+      }
+      std::cerr << "schema migration " << migration.version << " (" << migration.name << "): "
+        << seconds.count() << " s" << std::endl;
+      version = migration.version;
+    }
+    return 0;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // online_index_option
+  // online_index_option of the server's EngineEdition, "OFF" if it cannot be read
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  std::string online_index_option()
+  {
+    table_t table;
+    if (db.fetch("SELECT CAST(SERVERPROPERTY('EngineEdition') AS INT)", table) < 0 || table.rows.empty())
+    {
+      return "OFF";
     }
+    return ::online_index_option(std::atoi(table.rows[0].col[0].c_str()));
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // exec_batches
+  // prepares sql once and executes it over rows [0, nbr_rows) in parameter arrays of
+  // INSERT_ARRAY_SIZE rows, all in one manual-commit transaction; fill(first_row, count) loads
+  // one array
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  int exec_batches(const std::string& sql, size_t nbr_rows,
+    const std::function<std::vector<param_array_t>(size_t, size_t)>& fill)
+  {
+    const size_t INSERT_ARRAY_SIZE = 1000;
+    if (!connected) return -1;
+    if (nbr_rows == 0) return 0;
+
+    statement_t stmt;
+    if (stmt.prepare(db, sql) < 0) return -1;
+    if (db.set_manual() < 0) return -1;
+    int ret = 0;
+    for (size_t row = 0; row < nbr_rows && ret == 0; row += INSERT_ARRAY_SIZE)
+    {
+      size_t count = std::min(INSERT_ARRAY_SIZE, nbr_rows - row);
+      std::vector<param_array_t> params = fill(row, count);
+      ret = stmt.execute(params, count);
+    }
+
+    if (ret == 0)
+    {
+      ret = db.commit_transaction();
+    }
+    else
+    {
+      db.rollback_transaction();
+    }
+    db.set_auto_commit();
+    return ret;
   }
 
 public:
-  FinMartSQLServer(const std::string& connection_string) : connected(false)
+  FinMartSQLServer(const std::string& connection_string, bool initialize) : connected(false)
   {
     if (db.connect(connection_string) == 0) 
     {
       connected = true;
-      initialize_schema();
+      if (initialize)
+      {
+        initialize_schema();
+      }
     }
   }
 
   ~FinMartSQLServer()
   {
+    insert_record.close();
     if (connected)
     {
       db.disconnect();
@@ -270,6 +703,11 @@ public:
     return connected;
   }
 
+  bool is_alive(bool round_trip) override
+  {
+    return connected && db.is_alive(round_trip);
+  }
+
   /////////////////////////////////////////////////////////////////////////////////////////////////////
   // get_all_transactions
   /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -277,40 +715,103 @@ public:
   std::vector<transaction> get_all_transactions() override
   {
     std::vector<transaction> transactions;
-    table_t table;
+    typed_table_t table;
 
-    if (db.fetch("SELECT id, date, department, category, vendor, amount, status, source_system FROM transactions ORDER BY date DESC", table) == 0) {
-      for (size_t idx = 0; idx < table.rows.size(); idx++) {
-        const row_t& row = table.rows[idx];
-        if (row.col.size() >= 8) {
-          transaction t;
-          t.id = std::stoi(row.col[0]);
-          t.date = row.col[1];
-          t.department = row.col[2];
-          t.category = row.col[3];
-          t.vendor = row.col[4];
-          t.amount = std::stod(row.col[5]);
-          t.status = row.col[6];
-          t.source_system = row.col[7];
-          transactions.push_back(t);
-        }
+    if (db.fetch("SELECT id, date, department, category, vendor, amount, status, source_system FROM transactions ORDER BY date DESC", table) == 0 &&
+      has_types(table, { SQL_C_SBIGINT, SQL_C_CHAR, SQL_C_CHAR, SQL_C_CHAR, SQL_C_CHAR, SQL_C_DOUBLE, SQL_C_CHAR, SQL_C_CHAR }))
+    {
+      transactions.reserve(table.nbr_rows);
+      for (size_t idx = 0; idx < table.nbr_rows; idx++)
+      {
+        transaction t;
+        t.id = static_cast<int>(table.cols[0].integers[idx]);
+        t.date = std::string(table.cols[1].text(idx));
+        t.department = std::string(table.cols[2].text(idx));
+        t.category = std::string(table.cols[3].text(idx));
+        t.vendor = std::string(table.cols[4].text(idx));
+        t.amount = table.cols[5].doubles[idx];
+        t.status = std::string(table.cols[6].text(idx));
+        t.source_system = std::string(table.cols[7].text(idx));
+        transactions.push_back(t);
       }
     }
 
     return transactions;
   }
 
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // get_transactions_page
+  // TOP (page_size + 1) seek on idx_transactions_date_id, or idx_transactions_department_date
+  // when the filter sets the department
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  transaction_page get_transactions_page(const transaction_filter& filter, const transaction_cursor& after,
+    size_t page_size) override
+  {
+    transaction_page page;
+    if (!connected || page_size == 0) return page;
+
+    std::vector<sql_value_t> values;
+    std::string where = filter.where_clause(values);
+    if (!after.is_start())
+    {
+      where += where.empty() ? "" : " AND ";
+      where += "(date < ? OR (date = ? AND id < ?))";
+      values.push_back(sql_value_t::from_text(after.date));
+      values.push_back(sql_value_t::from_text(after.date));
+      // as text: SQL Server converts it to the INT of id, a FLOAT would convert the column instead
+      values.push_back(sql_value_t::from_text(std::to_string(after.id)));
+    }
+    std::string sql = "SELECT TOP (" + std::to_string(page_size + 1) + ") "
+      "id, date, department, category, vendor, amount, status, source_system FROM transactions ";
+    if (!where.empty())
+    {
+      sql += "WHERE " + where + " ";
+    }
+    sql += "ORDER BY date DESC, id DESC";
+
+    std::vector<param_array_t> params = to_params(values);
+    page.rows.reserve(page_size);
+    db.fetch_each(sql, params, [&page, page_size](const row_view_t& row)
+      {
+        if (row.col.size() < 8) return false;
+        if (page.rows.size() == page_size)
+        {
+          page.has_more = true;
+          return false;
+        }
+        transaction t;
+        t.id = std::atoi(row.col[0].data());
+        t.date = std::string(row.col[1]);
+        t.department = std::string(row.col[2]);
+        t.category = std::string(row.col[3]);
+        t.vendor = std::string(row.col[4]);
+        t.amount = std::strtod(row.col[5].data(), nullptr);
+        t.status = std::string(row.col[6]);
+        t.source_system = std::string(row.col[7]);
+        page.rows.push_back(t);
+        return true;
+      });
+
+    if (!page.rows.empty())
+    {
+      page.next.date = page.rows.back().date;
+      page.next.id = page.rows.back().id;
+    }
+    return page;
+  }
+
   std::map<std::string, double> get_department_spending() override
   {
     std::map<std::string, double> spending;
-    table_t table;
+    typed_table_t table;
 
-    if (db.fetch("SELECT department, SUM(amount) as total FROM transactions GROUP BY department ORDER BY total DESC", table) == 0) {
-      for (size_t idx = 0; idx < table.rows.size(); idx++) {
-        const row_t& row = table.rows[idx];
-        if (row.col.size() >= 2) {
-          spending[row.col[0]] = std::stod(row.col[1]);
-        }
+    if (db.fetch("SELECT department, amount FROM transactions_by_department WITH (NOEXPAND) ORDER BY amount DESC", table) == 0 &&
+      has_types(table, { SQL_C_CHAR, SQL_C_DOUBLE }))
+    {
+      for (size_t idx = 0; idx < table.nbr_rows; idx++)
+      {
+        spending[std::string(table.cols[0].text(idx))] = table.cols[1].doubles[idx];
       }
     }
 
@@ -320,33 +821,93 @@ public:
   std::map<std::string, int> get_source_system_counts() override
   {
     std::map<std::string, int> counts;
-    table_t table;
+    typed_table_t table;
 
-    if (db.fetch("SELECT source_system, COUNT(*) as cnt FROM transactions GROUP BY source_system", table) == 0) {
-      for (size_t idx = 0; idx < table.rows.size(); idx++) {
-        const row_t& row = table.rows[idx];
-        if (row.col.size() >= 2) {
-          counts[row.col[0]] = std::stoi(row.col[1]);
-        }
+    if (db.fetch("SELECT source_system, nbr FROM transactions_by_source_system WITH (NOEXPAND)", table) == 0 &&
+      has_types(table, { SQL_C_CHAR, SQL_C_SBIGINT }))
+    {
+      for (size_t idx = 0; idx < table.nbr_rows; idx++)
+      {
+        counts[std::string(table.cols[0].text(idx))] = static_cast<int>(table.cols[1].integers[idx]);
       }
     }
 
     return counts;
   }
 
+  std::vector<std::string> get_departments() override
+  {
+    return text_column("SELECT department FROM transactions_by_department WITH (NOEXPAND) ORDER BY department");
+  }
+
+  std::vector<std::string> get_companies() override
+  {
+    return text_column("SELECT DISTINCT company_id FROM financial_records ORDER BY company_id");
+  }
+
   double get_total_spending() override
   {
-    table_t table;
+    typed_table_t table;
+
+    if (db.fetch("SELECT ISNULL(SUM(amount), 0) as total FROM transactions_by_department WITH (NOEXPAND)", table) == 0 &&
+      has_types(table, { SQL_C_DOUBLE }) && table.nbr_rows > 0)
+    {
+      return table.cols[0].doubles[0];
+    }
+
+    return 0.0;
+  }
+
+  std::map<std::string, double> get_daily_spending(const std::string& date_from, const std::string& date_to) override
+  {
+    std::map<std::string, double> spending;
+    if (!connected) return spending;
+
+    std::vector<param_array_t> params = to_params({ sql_value_t::from_text(date_from), sql_value_t::from_text(date_to) });
+    db.fetch_each("SELECT date, amount FROM transactions_by_day WITH (NOEXPAND) WHERE date >= ? AND date <= ?", params,
+      [&spending](const row_view_t& row)
+      {
+        if (row.col.size() < 2) return false;
+        spending[std::string(row.col[0])] = std::strtod(row.col[1].data(), nullptr);
+        return true;
+      });
+    return spending;
+  }
 
-    if (db.fetch("SELECT SUM(amount) as total FROM transactions", table) == 0)
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // check_summaries
+  // the two reads of a check are separate statements at READ COMMITTED, a load writing in between
+  // shows up as a mismatch; run it when no load is writing, or run it again
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  int check_summaries(std::vector<std::string>& mismatches) override
+  {
+    if (!connected) return -1;
+    size_t first = mismatches.size();
+    for (size_t idx = 0; idx < sizeof(SQLSERVER_SUMMARY_CHECKS) / sizeof(SQLSERVER_SUMMARY_CHECKS[0]); idx++)
     {
-      if (table.rows.size() > 0 && table.rows[0].col.size() > 0) 
+      summary_map_t summary;
+      summary_map_t base;
+      if (read_summary(SQLSERVER_SUMMARY_CHECKS[idx].summary_sql, summary) < 0 ||
+        read_summary(SQLSERVER_SUMMARY_CHECKS[idx].base_sql, base) < 0)
       {
-        return std::stod(table.rows[0].col[0]);
+        return -1;
       }
+      compare_summaries(SQLSERVER_SUMMARY_CHECKS[idx].name, base, summary, mismatches);
     }
+    return static_cast<int>(mismatches.size() - first);
+  }
 
-    return 0.0;
+  int read_summary(const std::string& sql, summary_map_t& summary)
+  {
+    return db.fetch_each(sql, [&summary](const row_view_t& row)
+      {
+        if (row.col.size() < 3) return false;
+        transaction_summary& group = summary[std::string(row.col[0])];
+        group.amount = std::strtod(row.col[1].data(), nullptr);
+        group.nbr = std::atoll(row.col[2].data());
+        return true;
+      });
   }
 
   DatabaseBackend get_backend() const override 
@@ -365,97 +926,154 @@ public:
 
   std::vector<FinancialRecord> get_financial_records() override
   {
-    std::vector<FinancialRecord> records;
-    table_t table;
+    typed_table_t table;
 
     std::string query = "SELECT period, company_id, revenue, cogs, operating_expenses, "
       "depreciation, amortization, interest, taxes, current_assets, current_liabilities, "
       "inventory, total_assets, total_liabilities FROM financial_records ORDER BY company_id, period";
 
-    if (db.fetch(query, table) == 0)
+    if (db.fetch(query, table) < 0)
     {
-      for (size_t idx = 0; idx < table.rows.size(); ++idx)
-      {
-        const row_t& row = table.rows[idx];
-        if (row.col.size() >= 14)
-        {
-          FinancialRecord r;
-          r.period = row.col[0];
-          r.company_id = row.col[1];
-          r.revenue = std::stod(row.col[2]);
-          r.cogs = std::stod(row.col[3]);
-          r.operating_expenses = std::stod(row.col[4]);
-          r.depreciation = std::stod(row.col[5]);
-          r.amortization = std::stod(row.col[6]);
-          r.interest = std::stod(row.col[7]);
-          r.taxes = std::stod(row.col[8]);
-          r.current_assets = std::stod(row.col[9]);
-          r.current_liabilities = std::stod(row.col[10]);
-          r.inventory = std::stod(row.col[11]);
-          r.total_assets = std::stod(row.col[12]);
-          r.total_liabilities = std::stod(row.col[13]);
-          records.push_back(r);
-        }
-      }
+      return std::vector<FinancialRecord>();
     }
-
-    return records;
+    return records_from_table(table);
   }
 
   std::vector<FinancialRecord> get_financial_records_by_company(const std::string& company_id) override
   {
-    std::vector<FinancialRecord> records;
-    table_t table;
+    typed_table_t table;
 
     std::string query = "SELECT period, company_id, revenue, cogs, operating_expenses, "
       "depreciation, amortization, interest, taxes, current_assets, current_liabilities, "
-      "inventory, total_assets, total_liabilities FROM financial_records WHERE company_id = '"
-      + company_id + "' ORDER BY period";
+      "inventory, total_assets, total_liabilities FROM financial_records WHERE company_id = ? ORDER BY period";
+    std::vector<param_array_t> params = to_params({ sql_value_t::from_text(company_id) });
 
-    if (db.fetch(query, table) == 0)
+    if (db.fetch(query, params, table) < 0)
     {
-      for (size_t idx = 0; idx < table.rows.size(); ++idx)
-      {
-        const row_t& row = table.rows[idx];
-        if (row.col.size() >= 14)
-        {
-          FinancialRecord r;
-          r.period = row.col[0];
-          r.company_id = row.col[1];
-          r.revenue = std::stod(row.col[2]);
-          r.cogs = std::stod(row.col[3]);
-          r.operating_expenses = std::stod(row.col[4]);
-          r.depreciation = std::stod(row.col[5]);
-          r.amortization = std::stod(row.col[6]);
-          r.interest = std::stod(row.col[7]);
-          r.taxes = std::stod(row.col[8]);
-          r.current_assets = std::stod(row.col[9]);
-          r.current_liabilities = std::stod(row.col[10]);
-          r.inventory = std::stod(row.col[11]);
-          r.total_assets = std::stod(row.col[12]);
-          r.total_liabilities = std::stod(row.col[13]);
-          records.push_back(r);
-        }
-      }
+      return std::vector<FinancialRecord>();
     }
+    return records_from_table(table);
+  }
 
-    return records;
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // row visitors - odbc::fetch_each, numbers are parsed in place from the column buffers
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  int for_each_transaction(const transaction_filter& filter, const std::function<bool(const transaction_view&)>& visit) override
+  {
+    if (!connected) return -1;
+    std::vector<sql_value_t> values;
+    std::string where = filter.where_clause(values);
+    std::string sql = "SELECT id, date, department, category, vendor, amount, status, source_system FROM transactions ";
+    if (!where.empty())
+    {
+      sql += "WHERE " + where + " ";
+    }
+    sql += "ORDER BY date DESC, id DESC";
+
+    std::vector<param_array_t> params = to_params(values);
+    transaction_view t;
+    return db.fetch_each(sql, params, [&visit, &t](const row_view_t& row)
+      {
+        if (row.col.size() < 8) return false;
+        t.id = std::atoi(row.col[0].data());
+        t.date = row.col[1];
+        t.department = row.col[2];
+        t.category = row.col[3];
+        t.vendor = row.col[4];
+        t.amount = std::strtod(row.col[5].data(), nullptr);
+        t.status = row.col[6];
+        t.source_system = row.col[7];
+        return visit(t);
+      });
   }
 
+  int for_each_financial_record(const std::function<bool(const financial_record_view&)>& visit) override
+  {
+    if (!connected) return -1;
+    financial_record_view r;
+    return db.fetch_each("SELECT period, company_id, revenue, cogs, operating_expenses, "
+      "depreciation, amortization, interest, taxes, current_assets, current_liabilities, "
+      "inventory, total_assets, total_liabilities FROM financial_records ORDER BY company_id, period",
+      [&visit, &r](const row_view_t& row)
+      {
+        if (row.col.size() < 14) return false;
+        r.period = row.col[0];
+        r.company_id = row.col[1];
+        r.revenue = std::strtod(row.col[2].data(), nullptr);
+        r.cogs = std::strtod(row.col[3].data(), nullptr);
+        r.operating_expenses = std::strtod(row.col[4].data(), nullptr);
+        r.depreciation = std::strtod(row.col[5].data(), nullptr);
+        r.amortization = std::strtod(row.col[6].data(), nullptr);
+        r.interest = std::strtod(row.col[7].data(), nullptr);
+        r.taxes = std::strtod(row.col[8].data(), nullptr);
+        r.current_assets = std::strtod(row.col[9].data(), nullptr);
+        r.current_liabilities = std::strtod(row.col[10].data(), nullptr);
+        r.inventory = std::strtod(row.col[11].data(), nullptr);
+        r.total_assets = std::strtod(row.col[12].data(), nullptr);
+        r.total_liabilities = std::strtod(row.col[13].data(), nullptr);
+        return visit(r);
+      });
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // insert_financial_record - the prepared insert_record statement, autocommit
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
   int insert_financial_record(const FinancialRecord& record) override
   {
-    std::stringstream sql;
-    sql << std::fixed << std::setprecision(2);
-    sql << "INSERT INTO financial_records (period, company_id, revenue, cogs, operating_expenses, "
-      << "depreciation, amortization, interest, taxes, current_assets, current_liabilities, "
-      << "inventory, total_assets, total_liabilities) VALUES ('"
-      << record.period << "', '" << record.company_id << "', "
-      << record.revenue << ", " << record.cogs << ", " << record.operating_expenses << ", "
-      << record.depreciation << ", " << record.amortization << ", " << record.interest << ", "
-      << record.taxes << ", " << record.current_assets << ", " << record.current_liabilities << ", "
-      << record.inventory << ", " << record.total_assets << ", " << record.total_liabilities << ")";
+    if (!connected) return -1;
+    if (!insert_record.is_prepared() && insert_record.prepare(db, SQL_INSERT_FINANCIAL_RECORD) < 0) return -1;
+    std::vector<param_array_t> params = financial_record_params(&record, 1);
+    return insert_record.execute(params, 1);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // insert_financial_records - ODBC parameter arrays, column sizes follow initialize_schema
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  int insert_financial_records(const std::vector<FinancialRecord>& records) override
+  {
+    return exec_batches(SQL_INSERT_FINANCIAL_RECORD, records.size(), [&records](size_t first, size_t count)
+      {
+        return financial_record_params(&records[first], count);
+      });
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // insert_transactions - ODBC parameter arrays, id is an IDENTITY column
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  int insert_transactions(const std::vector<transaction>& transactions) override
+  {
+    const std::string sql = "INSERT INTO transactions (date, department, category, vendor, amount, status, source_system) "
+      "VALUES (?, ?, ?, ?, ?, ?, ?)";
 
-    return db.exec_direct(sql.str());
+    return exec_batches(sql, transactions.size(), [&transactions](size_t first, size_t count)
+      {
+        const transaction* rows = &transactions[first];
+        std::vector<param_array_t> params;
+        params.push_back(text_param(20, rows, count, &transaction::date));
+        params.push_back(text_param(50, rows, count, &transaction::department));
+        params.push_back(text_param(50, rows, count, &transaction::category));
+        params.push_back(text_param(100, rows, count, &transaction::vendor));
+        params.push_back(param_array_t::real(count));
+        params.push_back(text_param(20, rows, count, &transaction::status));
+        params.push_back(text_param(50, rows, count, &transaction::source_system));
+
+        for (size_t row = 0; row < count; row++)
+        {
+          const transaction& t = transactions[first + row];
+          params[0].set(row, t.date);
+          params[1].set(row, t.department);
+          params[2].set(row, t.category);
+          params[3].set(row, t.vendor);
+          params[4].set(row, t.amount);
+          params[5].set(row, t.status);
+          params[6].set(row, t.source_system);
+        }
+        return params;
+      });
   }
 };
 
@@ -463,14 +1081,14 @@ public:
 // DatabaseFactory implementation
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-IFinMartDatabase* DatabaseFactory::create(DatabaseBackend backend, const std::string& connection_string)
+IFinMartDatabase* DatabaseFactory::create(DatabaseBackend backend, const std::string& connection_string, bool initialize)
 {
   switch (backend) 
   {
   case DatabaseBackend::SQLITE:
-    return new FinMartSQLite(connection_string);
+    return new FinMartSQLite(connection_string, initialize);
   case DatabaseBackend::SQLSERVER:
-    return new FinMartSQLServer(connection_string);
+    return new FinMartSQLServer(connection_string, initialize);
   default:
     return nullptr;
   }
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <functional>
 #include "finmart.h"
 #include "metrics.hh"
 
@@ -29,11 +30,39 @@ public:
   virtual ~IFinMartDatabase() = default;
 
   virtual bool is_open() const = 0;
+
+  // is_alive: connection check of DatabasePool before a connection is lent; round_trip runs a
+  // query, otherwise only the client side state is checked
+  virtual bool is_alive(bool round_trip) = 0;
+
   virtual std::vector<transaction> get_all_transactions() = 0;
   virtual std::map<std::string, double> get_department_spending() = 0;
   virtual std::map<std::string, int> get_source_system_counts() = 0;
   virtual double get_total_spending() = 0;
 
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // summaries
+  // the totals above and get_daily_spending read summary tables (SQLite, kept by triggers) or
+  // indexed views (SQL Server) with one row per department, source system and day, updated in
+  // the transaction that writes transactions, so their cost depends on the number of groups only
+  // get_daily_spending: amount per day between date_from and date_to (YYYY-MM-DD, inclusive)
+  // check_summaries: recomputes each summary from transactions, appends a line to mismatches for
+  // each group that differs; returns the number of mismatches (0 when consistent), -1 on error
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  virtual std::map<std::string, double> get_daily_spending(const std::string& date_from, const std::string& date_to) = 0;
+  virtual int check_summaries(std::vector<std::string>& mismatches) = 0;
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // reference data
+  // sorted lists of the filters and pickers of the views, read on every page: SQLite keeps them
+  // in an in-memory database attached to the connection and reloads it when the file changed,
+  // SQL Server reads the department summary view and the financial_records index
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  virtual std::vector<std::string> get_departments() = 0;
+  virtual std::vector<std::string> get_companies() = 0;
+
   /////////////////////////////////////////////////////////////////////////////////////////////////////
   // financial records and metrics
   /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -42,6 +71,40 @@ public:
   virtual std::vector<FinancialRecord> get_financial_records_by_company(const std::string& company_id) = 0;
   virtual int insert_financial_record(const FinancialRecord& record) = 0;
 
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // batch inserts
+  // all rows are sent through one prepared statement inside explicit transactions
+  // (SQLite: BEGIN/COMMIT per batch, SQL Server: ODBC parameter arrays); 0 on success
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  virtual int insert_financial_records(const std::vector<FinancialRecord>& records) = 0;
+  virtual int insert_transactions(const std::vector<transaction>& transactions) = 0;
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // get_transactions_page
+  // page_size transactions matching filter after cursor, latest first (date DESC, id DESC)
+  // the filter is compiled into the WHERE clause with bound parameters, only matching rows
+  // are read from the database
+  // keyset pagination: the query seeks to the cursor key in the date index instead of skipping
+  // rows with OFFSET, so every page costs the same however deep it is
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  virtual transaction_page get_transactions_page(const transaction_filter& filter, const transaction_cursor& after,
+    size_t page_size) = 0;
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // row visitors
+  // rows are passed to visit one at a time while the query runs, nothing is collected, so a
+  // caller can process any number of rows in constant memory; the text columns of a view are
+  // valid only during the call, copy what must outlive it. visit returns false to stop early.
+  // for_each_transaction: transactions matching filter, latest first
+  // for_each_financial_record: all records ordered by company_id, period
+  // return 0 on success (also when stopped), -1 on error
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  virtual int for_each_transaction(const transaction_filter& filter, const std::function<bool(const transaction_view&)>& visit) = 0;
+  virtual int for_each_financial_record(const std::function<bool(const financial_record_view&)>& visit) = 0;
+
   virtual DatabaseBackend get_backend() const = 0;
   virtual std::string get_backend_name() const = 0;
 };
@@ -56,7 +119,9 @@ public:
   // Create database based on backend type
   // For SQLite: connection_string is the filename (e.g., "finmart.db")
   // For SQL Server: connection_string is ODBC connection string
-  static IFinMartDatabase* create(DatabaseBackend backend, const std::string& connection_string);
+  // initialize = false skips schema creation (already done, e.g. by DatabasePool::initialize)
+  static IFinMartDatabase* create(DatabaseBackend backend, const std::string& connection_string,
+    bool initialize = true);
 };
 
 #endif
@@ -0,0 +1,258 @@
+#include "db_pool.hh"
+#include "odbc.hh"
+#include <algorithm>
+
+#define USE_SQLSERVER 0
+
+#if USE_SQLSERVER
+const DatabaseBackend DB_BACKEND = DatabaseBackend::SQLSERVER;
+const std::string DB_CONNECTION = make_conn("localhost", "finmart_db", "", "");
+#else
+const DatabaseBackend DB_BACKEND = DatabaseBackend::SQLITE;
+const std::string DB_CONNECTION = "finmart.db";
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// finmart_pool
+// up to one connection per Wt worker thread, requests beyond that wait for a release
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DatabasePool& finmart_pool()
+{
+  pool_options_t options;
+  options.min_size = 2;
+  options.max_size = 8;
+  static DatabasePool pool(DB_BACKEND, DB_CONNECTION, options);
+  return pool;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// DatabasePool
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DatabasePool::DatabasePool(DatabaseBackend backend, const std::string& connection_string, const pool_options_t& options) :
+  backend(backend),
+  connection_string(connection_string),
+  options(options),
+  nbr_opening(0)
+{
+  this->options.max_size = std::max<size_t>(options.max_size, 1);
+  this->options.min_size = std::max<size_t>(std::min(options.min_size, this->options.max_size), 1);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// initialize
+// opens min_size connections; only the first one runs schema creation and sample data checks
+// returns 0 if the pool is (already) open, -1 if a connection failed; the pool is left empty then
+// and the next acquire() tries again
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int DatabasePool::initialize()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return open_connections();
+}
+
+int DatabasePool::open_connections()
+{
+  if (!connections.empty())
+  {
+    return 0;
+  }
+
+  connections_t opened;
+  for (size_t idx = 0; idx < options.min_size; idx++)
+  {
+    std::unique_ptr<IFinMartDatabase> db(DatabaseFactory::create(backend, connection_string, idx == 0));
+    if (!db || !db->is_open())
+    {
+      return -1;
+    }
+    opened.push_back(std::move(db));
+  }
+
+  connections = std::move(opened);
+  counters.opened += connections.size();
+  clock_type::time_point now = clock_type::now();
+  for (size_t idx = 0; idx < connections.size(); idx++)
+  {
+    idle.push_back(idle_t{ connections[idx].get(), now });
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// acquire
+// borrow a validated connection: an idle one, else a new one if fewer than max_size are open,
+// else wait for one to be returned; the Lease is empty if the pool could not be opened
+// validation and opening run outside the lock, connections are closed after it is released
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DatabasePool::Lease DatabasePool::acquire()
+{
+  clock_type::time_point start = clock_type::now();
+  connections_t closed;
+  std::unique_lock<std::mutex> lock(mutex);
+  if (open_connections() < 0)
+  {
+    return Lease();
+  }
+
+  bool waited = false;
+  while (true)
+  {
+    clock_type::time_point now = clock_type::now();
+    evict_idle(now, closed);
+
+    if (!idle.empty())
+    {
+      idle_t entry = idle.back();
+      idle.pop_back();
+      bool round_trip = now - entry.since > options.validate_after;
+      lock.unlock();
+      bool alive = entry.db->is_alive(round_trip);
+      lock.lock();
+      if (alive)
+      {
+        count_acquire(start, waited);
+        return Lease(this, entry.db);
+      }
+      counters.invalid++;
+      close_connection(entry.db, closed);
+      continue;
+    }
+
+    if (connections.size() + nbr_opening < options.max_size)
+    {
+      nbr_opening++;
+      lock.unlock();
+      std::unique_ptr<IFinMartDatabase> db(DatabaseFactory::create(backend, connection_string, false));
+      lock.lock();
+      nbr_opening--;
+      if (db && db->is_open())
+      {
+        IFinMartDatabase* opened = db.get();
+        connections.push_back(std::move(db));
+        counters.opened++;
+        count_acquire(start, waited);
+        return Lease(this, opened);
+      }
+      if (connections.empty())
+      {
+        return Lease();
+      }
+    }
+
+    // a connection may have been returned while this thread was opening one
+    if (idle.empty())
+    {
+      waited = true;
+      available.wait(lock);
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// stats
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+pool_stats_t DatabasePool::stats()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  pool_stats_t result = counters;
+  result.open = connections.size();
+  result.idle = idle.size();
+  result.in_use = connections.size() - idle.size();
+  return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// give_back
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DatabasePool::give_back(IFinMartDatabase* db)
+{
+  connections_t closed;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    clock_type::time_point now = clock_type::now();
+    idle.push_back(idle_t{ db, now });
+    evict_idle(now, closed);
+  }
+  available.notify_one();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// evict_idle
+// closes the connections idle longer than idle_timeout while more than min_size are open;
+// the oldest are at the front of idle
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DatabasePool::evict_idle(clock_type::time_point now, connections_t& closed)
+{
+  while (!idle.empty() && connections.size() > options.min_size && now - idle.front().since > options.idle_timeout)
+  {
+    IFinMartDatabase* db = idle.front().db;
+    idle.erase(idle.begin());
+    counters.evicted++;
+    close_connection(db, closed);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// close_connection
+// moves db out of connections into closed, which the caller destroys after releasing the lock
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DatabasePool::close_connection(IFinMartDatabase* db, connections_t& closed)
+{
+  for (size_t idx = 0; idx < connections.size(); idx++)
+  {
+    if (connections[idx].get() == db)
+    {
+      closed.push_back(std::move(connections[idx]));
+      connections.erase(connections.begin() + idx);
+      return;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// count_acquire
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DatabasePool::count_acquire(clock_type::time_point start, bool waited)
+{
+  std::chrono::duration<double> wait = clock_type::now() - start;
+  counters.acquires++;
+  counters.waits += waited ? 1 : 0;
+  counters.wait_seconds += wait.count();
+  counters.max_wait_seconds = std::max(counters.max_wait_seconds, wait.count());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// Lease
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DatabasePool::Lease& DatabasePool::Lease::operator=(Lease&& other) noexcept
+{
+  if (this != &other)
+  {
+    release();
+    pool = other.pool;
+    db = other.db;
+    other.pool = nullptr;
+    other.db = nullptr;
+  }
+  return *this;
+}
+
+void DatabasePool::Lease::release()
+{
+  if (pool && db)
+  {
+    pool->give_back(db);
+  }
+  pool = nullptr;
+  db = nullptr;
+}
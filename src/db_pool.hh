@@ -0,0 +1,137 @@
+#ifndef DB_POOL_HH
+#define DB_POOL_HH
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include "db_interface.hh"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// pool_options_t
+// sizes and timeouts of a DatabasePool
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct pool_options_t
+{
+  size_t min_size = 2; // opened by initialize(), never closed for being idle
+  size_t max_size = 8; // acquire() waits while this many are in use
+  std::chrono::seconds idle_timeout = std::chrono::seconds(300); // connections above min_size idle longer are closed
+  std::chrono::seconds validate_after = std::chrono::seconds(30); // connections idle longer are checked with a query
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// pool_stats_t
+// counters of a DatabasePool since it was created; wait is the time acquire() took, including
+// opening or validating the connection it returned
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct pool_stats_t
+{
+  size_t open = 0;
+  size_t idle = 0;
+  size_t in_use = 0;
+  unsigned long long acquires = 0;
+  unsigned long long waits = 0; // acquires that waited for a release
+  unsigned long long opened = 0;
+  unsigned long long evicted = 0; // closed after idle_timeout
+  unsigned long long invalid = 0; // closed because is_alive failed on borrow
+  double wait_seconds = 0;
+  double max_wait_seconds = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// DatabasePool
+// open connections shared by all sessions, between options.min_size and options.max_size
+// initialize() creates the schema once, through the first connection, and opens min_size; more
+// are opened (without schema checks) when all are in use, up to max_size, after which acquire()
+// waits for a release. Views borrow a connection with acquire() and the Lease returns it when
+// it goes out of scope.
+//
+// borrowed connections are validated: is_alive() without a round trip, with a SELECT 1 when the
+// connection was idle longer than validate_after; a dead connection is closed and replaced.
+// idle connections are reused most recent first, so the ones beyond the load age and are closed
+// after idle_timeout (checked on acquire and release, there is no background thread)
+//
+// Usage:
+//   DatabasePool::Lease db = finmart_pool().acquire();
+//   if (!db) { ... }
+//   double total = db->get_total_spending();
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class DatabasePool
+{
+public:
+  class Lease
+  {
+  public:
+    Lease() : pool(nullptr), db(nullptr) {}
+    Lease(Lease&& other) noexcept : pool(other.pool), db(other.db) { other.pool = nullptr; other.db = nullptr; }
+    Lease& operator=(Lease&& other) noexcept;
+    ~Lease() { release(); }
+
+    IFinMartDatabase* get() const { return db; }
+    IFinMartDatabase* operator->() const { return db; }
+    explicit operator bool() const { return db != nullptr; }
+    void release();
+
+  private:
+    friend class DatabasePool;
+    Lease(DatabasePool* pool, IFinMartDatabase* db) : pool(pool), db(db) {}
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+    DatabasePool* pool;
+    IFinMartDatabase* db;
+  };
+
+  DatabasePool(DatabaseBackend backend, const std::string& connection_string,
+    const pool_options_t& options = pool_options_t());
+  int initialize();
+  Lease acquire();
+  pool_stats_t stats();
+
+  DatabaseBackend get_backend() const { return backend; }
+  const std::string& get_connection_string() const { return connection_string; }
+  const pool_options_t& get_options() const { return options; }
+
+private:
+  typedef std::chrono::steady_clock clock_type;
+  typedef std::vector<std::unique_ptr<IFinMartDatabase>> connections_t;
+
+  struct idle_t
+  {
+    IFinMartDatabase* db;
+    clock_type::time_point since;
+  };
+
+  DatabasePool(const DatabasePool&) = delete;
+  DatabasePool& operator=(const DatabasePool&) = delete;
+  int open_connections();
+  void give_back(IFinMartDatabase* db);
+  void evict_idle(clock_type::time_point now, connections_t& closed);
+  void close_connection(IFinMartDatabase* db, connections_t& closed);
+  void count_acquire(clock_type::time_point start, bool waited);
+
+  DatabaseBackend backend;
+  std::string connection_string;
+  pool_options_t options;
+  connections_t connections;
+  std::vector<idle_t> idle; // most recently returned last
+  size_t nbr_opening; // connections being opened by acquire() outside the lock
+  pool_stats_t counters;
+  std::mutex mutex;
+  std::condition_variable available;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// finmart_pool
+// process-wide FinMart pool; backend and connection are chosen at build time (USE_SQLSERVER)
+// with SQLite the views only read through it: ETL loads go to a staging copy and are published
+// into this file in one transaction (DataManager::run_etl)
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DatabasePool& finmart_pool();
+
+#endif
@@ -2,6 +2,12 @@
 #define FINMART_H
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <optional>
+#include <cmath>
+#include <algorithm>
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // transaction
@@ -19,4 +25,222 @@ struct transaction
   std::string source_system;  // PeopleSoft, Coupa, SAP, Legacy, MicroStrategy
 };
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// transaction_view
+// transaction whose text columns point into the database row buffers, passed to
+// IFinMartDatabase::for_each_transaction; valid only while the row is current
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct transaction_view
+{
+  int id;
+  std::string_view date;
+  std::string_view department;
+  std::string_view category;
+  std::string_view vendor;
+  double amount;
+  std::string_view status;
+  std::string_view source_system;
+
+  transaction_view() : id(0), amount(0) {}
+  transaction_view(const transaction& t) :
+    id(t.id), date(t.date), department(t.department), category(t.category), vendor(t.vendor),
+    amount(t.amount), status(t.status), source_system(t.source_system) {}
+
+  transaction to_transaction() const
+  {
+    return transaction{ id, std::string(date), std::string(department), std::string(category),
+      std::string(vendor), amount, std::string(status), std::string(source_system) };
+  }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// sql_value_t
+// value of a '?' parameter marker, bound by the backend as text or as a double
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct sql_value_t
+{
+  bool is_text;
+  std::string text;
+  double number;
+
+  static sql_value_t from_text(const std::string& value) { return sql_value_t{ true, value, 0 }; }
+  static sql_value_t from_number(double value) { return sql_value_t{ false, std::string(), value }; }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// transaction_filter
+// conditions on transactions, unset members do not filter; date and amount ranges are inclusive
+// where_clause() is the same SQL for SQLite and SQL Server, values are always bound as parameters
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct transaction_filter
+{
+  std::optional<std::string> department;
+  std::optional<std::string> category;
+  std::optional<std::string> status;
+  std::optional<std::string> source_system;
+  std::optional<std::string> date_from; // YYYY-MM-DD
+  std::optional<std::string> date_to;
+  std::optional<double> amount_min;
+  std::optional<double> amount_max;
+
+  bool operator==(const transaction_filter& other) const
+  {
+    return department == other.department && category == other.category && status == other.status &&
+      source_system == other.source_system && date_from == other.date_from && date_to == other.date_to &&
+      amount_min == other.amount_min && amount_max == other.amount_max;
+  }
+
+  // AND of the set conditions ("" when none) with '?' markers, their values appended to values
+  std::string where_clause(std::vector<sql_value_t>& values) const
+  {
+    std::string sql;
+    add_condition(sql, values, "department = ?", department);
+    add_condition(sql, values, "category = ?", category);
+    add_condition(sql, values, "status = ?", status);
+    add_condition(sql, values, "source_system = ?", source_system);
+    add_condition(sql, values, "date >= ?", date_from);
+    add_condition(sql, values, "date <= ?", date_to);
+    add_condition(sql, values, "amount >= ?", amount_min);
+    add_condition(sql, values, "amount <= ?", amount_max);
+    return sql;
+  }
+
+private:
+  static void add_condition(std::string& sql, std::vector<sql_value_t>& values, const char* condition,
+    const std::optional<std::string>& value)
+  {
+    if (!value) return;
+    sql += sql.empty() ? condition : std::string(" AND ") + condition;
+    values.push_back(sql_value_t::from_text(*value));
+  }
+
+  static void add_condition(std::string& sql, std::vector<sql_value_t>& values, const char* condition,
+    const std::optional<double>& value)
+  {
+    if (!value) return;
+    sql += sql.empty() ? condition : std::string(" AND ") + condition;
+    values.push_back(sql_value_t::from_number(*value));
+  }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// transaction_cursor
+// position in the (date DESC, id DESC) order of transactions: the key of the last row read
+// a default cursor (id 0) is the start, before the latest transaction
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct transaction_cursor
+{
+  std::string date;
+  int id = 0;
+
+  bool is_start() const { return id == 0; }
+  bool operator==(const transaction_cursor& other) const { return id == other.id && date == other.date; }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// transaction_page
+// one page of IFinMartDatabase::get_transactions_page; next is the cursor for the following page,
+// has_more is false on the last page
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct transaction_page
+{
+  std::vector<transaction> rows;
+  transaction_cursor next;
+  bool has_more = false;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// transaction_summary
+// amount and number of transactions of one group (a department, a source system or a day),
+// as kept in the summary tables and as recomputed from transactions by check_summaries
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct transaction_summary
+{
+  double amount = 0;
+  long long nbr = 0;
+};
+
+typedef std::map<std::string, transaction_summary> summary_map_t;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// compare_summaries
+// appends one line to mismatches for each group missing on one side or whose count differs;
+// amounts are sums of doubles added in a different order, they match within 1e-9 relative
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void compare_summaries(const std::string& name, const summary_map_t& base, const summary_map_t& summary,
+  std::vector<std::string>& mismatches)
+{
+  for (summary_map_t::const_iterator it = base.begin(); it != base.end(); ++it)
+  {
+    summary_map_t::const_iterator found = summary.find(it->first);
+    if (found == summary.end())
+    {
+      mismatches.push_back(name + " '" + it->first + "': missing, transactions have " + std::to_string(it->second.nbr) + " rows");
+    }
+    else if (found->second.nbr != it->second.nbr ||
+      std::fabs(found->second.amount - it->second.amount) > 1e-9 * std::max(1.0, std::fabs(it->second.amount)))
+    {
+      mismatches.push_back(name + " '" + it->first + "': " + std::to_string(found->second.nbr) + " rows " +
+        std::to_string(found->second.amount) + ", transactions have " + std::to_string(it->second.nbr) + " rows " +
+        std::to_string(it->second.amount));
+    }
+  }
+  for (summary_map_t::const_iterator it = summary.begin(); it != summary.end(); ++it)
+  {
+    if (base.find(it->first) == base.end())
+    {
+      mismatches.push_back(name + " '" + it->first + "': " + std::to_string(it->second.nbr) + " rows, none in transactions");
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// schema_migration_t
+// one schema change; a database at a lower version runs sql and records version, name and the
+// seconds sql took in its schema_version table
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct schema_migration_t
+{
+  int version;
+  const char* name;
+  const char* sql;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// online_index_option
+// value of {online} in a SQL Server migration for SERVERPROPERTY('EngineEdition'): "ON" where
+// index builds can run with ONLINE = ON, so that the table stays readable and writable while the
+// index is built: Enterprise and Developer (3), Azure SQL Database (5) and Managed Instance (8);
+// "OFF" on the other editions, which reject the option
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline std::string online_index_option(int engine_edition)
+{
+  return (engine_edition == 3 || engine_edition == 5 || engine_edition == 8) ? "ON" : "OFF";
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// migration_sql
+// sql of a migration with every {online} replaced by online
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline std::string migration_sql(const schema_migration_t& migration, const std::string& online)
+{
+  std::string sql = migration.sql;
+  const std::string placeholder = "{online}";
+  for (size_t pos = sql.find(placeholder); pos != std::string::npos; pos = sql.find(placeholder, pos + online.size()))
+  {
+    sql.replace(pos, placeholder.size(), online);
+  }
+  return sql;
+}
+
 #endif
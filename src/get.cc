@@ -165,7 +165,8 @@ int login(const std::string& base_url, const std::string& username, const std::s
 // Cookie: {cookies}
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-int get_projects(const std::string& base_url, const std::string& auth_token, const std::string& cookies)
+int get_projects(const std::string& base_url, const std::string& auth_token, const std::string& cookies,
+  std::string& response)
 {
   std::string host = base_url;
   std::string path = "/api/projects";
@@ -198,7 +199,6 @@ int get_projects(const std::string& base_url, const std::string& auth_token, con
 
   std::cout << "Request:\n" << http.str() << std::endl;
 
-  std::string response;
   std::vector<std::string> headers;
   ssl_read(host, port_num, http.str(), response, headers);
 
@@ -208,6 +208,21 @@ int get_projects(const std::string& base_url, const std::string& auth_token, con
   }
 
   std::cout << response << std::endl;
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_projects
+// same request, the response is saved to projects.json
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int get_projects(const std::string& base_url, const std::string& auth_token, const std::string& cookies)
+{
+  std::string response;
+  if (get_projects(base_url, auth_token, cookies, response) < 0)
+  {
+    return -1;
+  }
 
   std::ofstream ofs("projects.json");
   ofs << response;
@@ -226,7 +241,7 @@ int get_projects(const std::string& base_url, const std::string& auth_token, con
 
 int get_report_definition(const std::string& base_url, const std::string& auth_token,
   const std::string& cookies, const std::string& project_id,
-  const std::string& report_id)
+  const std::string& report_id, std::string& response)
 {
   std::string host = base_url;
   std::string path = "/api/model/reports/" + report_id + "?showExpressionAs=tree";
@@ -261,7 +276,6 @@ int get_report_definition(const std::string& base_url, const std::string& auth_t
 
   std::cout << "Request:\n" << http.str() << std::endl;
 
-  std::string response;
   std::vector<std::string> headers;
   ssl_read(host, port_num, http.str(), response, headers);
 
@@ -271,6 +285,23 @@ int get_report_definition(const std::string& base_url, const std::string& auth_t
   }
 
   std::cout << response << std::endl;
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_report_definition
+// same request, the response is saved to report_{reportId}.json
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int get_report_definition(const std::string& base_url, const std::string& auth_token,
+  const std::string& cookies, const std::string& project_id,
+  const std::string& report_id)
+{
+  std::string response;
+  if (get_report_definition(base_url, auth_token, cookies, project_id, report_id, response) < 0)
+  {
+    return -1;
+  }
 
   std::ofstream ofs("report_" + report_id + ".json");
   ofs << response;
@@ -290,7 +321,7 @@ int get_report_definition(const std::string& base_url, const std::string& auth_t
 
 int create_cube(const std::string& base_url, const std::string& auth_token,
   const std::string& cookies, const std::string& project_id,
-  const std::string& cube_id)
+  const std::string& cube_id, std::string& response)
 {
   std::string host = base_url;
   std::string path = "/api/cubes/" + cube_id + "/instances";
@@ -326,7 +357,6 @@ int create_cube(const std::string& base_url, const std::string& auth_token,
 
   std::cout << "Request:\n" << http.str() << std::endl;
 
-  std::string response;
   std::vector<std::string> headers;
   ssl_read(host, port_num, http.str(), response, headers);
 
@@ -336,6 +366,23 @@ int create_cube(const std::string& base_url, const std::string& auth_token,
   }
 
   std::cout << response << std::endl;
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// create_cube
+// same request, the response is saved to cube_instance_{cubeId}.json
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int create_cube(const std::string& base_url, const std::string& auth_token,
+  const std::string& cookies, const std::string& project_id,
+  const std::string& cube_id)
+{
+  std::string response;
+  if (create_cube(base_url, auth_token, cookies, project_id, cube_id, response) < 0)
+  {
+    return -1;
+  }
 
   std::ofstream ofs("cube_instance_" + cube_id + ".json");
   ofs << response;
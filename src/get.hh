@@ -6,17 +6,27 @@
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // REST API functions
+// the versions without a response argument save the response to a file in the current
+// directory (projects.json, report_{id}.json, cube_instance_{id}.json)
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 int login(const std::string& base_url, const std::string& username, const std::string& password,
   std::string& auth_token, std::string& cookies);
 int get_projects(const std::string& base_url, const std::string& auth_token, const std::string& cookies);
+int get_projects(const std::string& base_url, const std::string& auth_token, const std::string& cookies,
+  std::string& response);
 int get_report_definition(const std::string& base_url, const std::string& auth_token,
   const std::string& cookies, const std::string& project_id,
   const std::string& report_id);
+int get_report_definition(const std::string& base_url, const std::string& auth_token,
+  const std::string& cookies, const std::string& project_id,
+  const std::string& report_id, std::string& response);
 int create_cube(const std::string& base_url, const std::string& auth_token,
   const std::string& cookies, const std::string& project_id,
   const std::string& cube_id);
+int create_cube(const std::string& base_url, const std::string& auth_token,
+  const std::string& cookies, const std::string& project_id,
+  const std::string& cube_id, std::string& response);
 int logout(const std::string& base_url, const std::string& auth_token, const std::string& cookies);
 
 std::string extract_value(const std::string& content, const std::string& key);
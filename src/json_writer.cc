@@ -0,0 +1,258 @@
+#include "json_writer.hh"
+#include <charconv>
+#include <cstring>
+#include <cmath>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// json_writer
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+json_writer::json_writer(size_t capacity) :
+  buf(capacity > 0 ? capacity : 64),
+  len(0),
+  after_key(false)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// clear - reset contents, keep the allocated buffer
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void json_writer::clear()
+{
+  len = 0;
+  first.clear();
+  after_key = false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// drain
+// discard the bytes written so far but keep the nesting state, so that a document can be
+// produced in consecutive blocks through the same buffer
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void json_writer::drain()
+{
+  len = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// reserve - make room for count bytes at the end of the buffer
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+char* json_writer::reserve(size_t count)
+{
+  if (len + count > buf.size())
+  {
+    size_t new_size = buf.size() * 2;
+    if (new_size < len + count)
+    {
+      new_size = len + count;
+    }
+    buf.resize(new_size);
+  }
+  return buf.data() + len;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// append
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void json_writer::append(char c)
+{
+  *reserve(1) = c;
+  len++;
+}
+
+void json_writer::append(const char* str, size_t count)
+{
+  std::memcpy(reserve(count), str, count);
+  len += count;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// separator
+// writes the comma between elements; a value that follows a key needs none
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void json_writer::separator()
+{
+  if (after_key)
+  {
+    after_key = false;
+    return;
+  }
+  if (!first.empty())
+  {
+    if (first.back())
+    {
+      first.back() = false;
+    }
+    else
+    {
+      append(',');
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// objects and arrays
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void json_writer::begin_object()
+{
+  separator();
+  append('{');
+  first.push_back(true);
+}
+
+void json_writer::end_object()
+{
+  append('}');
+  first.pop_back();
+}
+
+void json_writer::begin_array()
+{
+  separator();
+  append('[');
+  first.push_back(true);
+}
+
+void json_writer::end_array()
+{
+  append(']');
+  first.pop_back();
+}
+
+void json_writer::key(std::string_view name)
+{
+  separator();
+  append_escaped(name);
+  append(':');
+  after_key = true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// append_escaped
+// quotes and escapes a string; bytes >= 0x80 (UTF-8) are copied as is
+// runs that need no escaping are copied in one block
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void json_writer::append_escaped(std::string_view value)
+{
+  static const char hex[] = "0123456789abcdef";
+
+  append('"');
+  const char* str = value.data();
+  size_t size = value.size();
+  size_t start = 0;
+
+  for (size_t idx = 0; idx < size; idx++)
+  {
+    unsigned char c = static_cast<unsigned char>(str[idx]);
+    if (c >= 0x20 && c != '"' && c != '\\')
+    {
+      continue;
+    }
+
+    append(str + start, idx - start);
+    start = idx + 1;
+
+    switch (c)
+    {
+    case '"': append("\\\"", 2); break;
+    case '\\': append("\\\\", 2); break;
+    case '\b': append("\\b", 2); break;
+    case '\f': append("\\f", 2); break;
+    case '\n': append("\\n", 2); break;
+    case '\r': append("\\r", 2); break;
+    case '\t': append("\\t", 2); break;
+    default:
+    {
+      char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0f] };
+      append(esc, 6);
+    }
+    break;
+    }
+  }
+
+  append(str + start, size - start);
+  append('"');
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// values
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void json_writer::value_string(std::string_view value)
+{
+  separator();
+  append_escaped(value);
+}
+
+void json_writer::value_int(long long value)
+{
+  separator();
+  char* out = reserve(24);
+  std::to_chars_result res = std::to_chars(out, out + 24, value);
+  len += res.ptr - out;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// value_double
+// shortest representation that round-trips; NaN and infinity are not valid JSON and become null
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void json_writer::value_double(double value)
+{
+  if (!std::isfinite(value))
+  {
+    value_null();
+    return;
+  }
+  separator();
+  char* out = reserve(32);
+  std::to_chars_result res = std::to_chars(out, out + 32, value);
+  len += res.ptr - out;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// value_double
+// fixed notation with the given number of decimals (same digits as std::fixed << setprecision)
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void json_writer::value_double(double value, int precision)
+{
+  if (!std::isfinite(value))
+  {
+    value_null();
+    return;
+  }
+  separator();
+
+  // 309 integer digits for DBL_MAX, sign, point and the decimals
+  size_t max_size = 312 + static_cast<size_t>(precision);
+  char* out = reserve(max_size);
+  std::to_chars_result res = std::to_chars(out, out + max_size, value, std::chars_format::fixed, precision);
+  len += res.ptr - out;
+}
+
+void json_writer::value_bool(bool value)
+{
+  separator();
+  if (value)
+  {
+    append("true", 4);
+  }
+  else
+  {
+    append("false", 5);
+  }
+}
+
+void json_writer::value_null()
+{
+  separator();
+  append("null", 4);
+}
@@ -0,0 +1,63 @@
+#ifndef JSON_WRITER_HH
+#define JSON_WRITER_HH
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// json_writer
+// compact JSON output over a growable byte buffer
+// numbers are formatted with std::to_chars (locale independent, no stream state)
+// strings are escaped per RFC 8259; clean ASCII runs are copied with a single memcpy
+//
+// Usage:
+//   json_writer json;
+//   json.begin_object();
+//   json.key("name");
+//   json.value_string("ACME \"Corp\"");
+//   json.key("revenue");
+//   json.value_double(1250000.5, 2);
+//   json.end_object();
+//   std::string out = json.str();
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class json_writer
+{
+public:
+  json_writer(size_t capacity = 4096);
+
+  void begin_object();
+  void end_object();
+  void begin_array();
+  void end_array();
+  void key(std::string_view name);
+
+  void value_string(std::string_view value);
+  void value_int(long long value);
+  void value_double(double value);
+  void value_double(double value, int precision);
+  void value_bool(bool value);
+  void value_null();
+
+  const char* data() const { return buf.data(); }
+  size_t size() const { return len; }
+  std::string str() const { return std::string(buf.data(), len); }
+  void clear();
+  void drain();
+
+private:
+  std::vector<char> buf;
+  size_t len;
+  std::vector<bool> first; // one entry per open object/array: no element written yet
+  bool after_key;
+
+  void separator();
+  char* reserve(size_t count);
+  void append(char c);
+  void append(const char* str, size_t count);
+  void append_escaped(std::string_view value);
+};
+
+#endif
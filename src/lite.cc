@@ -1,20 +1,345 @@
 #include "lite.hh"
+#include <chrono>
+
+const char* SQL_INSERT_TRANSACTION = "INSERT INTO transactions (date, department, category, vendor, amount, status, source_system) VALUES (?, ?, ?, ?, ?, ?, ?);";
+
+const char* SQL_INSERT_FINANCIAL_RECORD = R"(
+    INSERT INTO financial_records 
+    (period, company_id, revenue, cogs, operating_expenses, depreciation, amortization,
+     interest, taxes, current_assets, current_liabilities, inventory, total_assets, total_liabilities)
+    VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);
+  )";
+
+// rows per BEGIN/COMMIT in the batch inserts
+const size_t INSERT_BATCH_SIZE = 10000;
+
+// summary maintenance of insert_transactions and rebuild_summaries (see migration 3)
+const char* SQL_ADD_DEPARTMENT_SUMMARY = "INSERT INTO transactions_by_department VALUES (?, ?, ?) "
+  "ON CONFLICT(department) DO UPDATE SET amount = amount + excluded.amount, nbr = nbr + excluded.nbr;";
+const char* SQL_ADD_SOURCE_SYSTEM_SUMMARY = "INSERT INTO transactions_by_source_system VALUES (?, ?, ?) "
+  "ON CONFLICT(source_system) DO UPDATE SET amount = amount + excluded.amount, nbr = nbr + excluded.nbr;";
+const char* SQL_ADD_DAY_SUMMARY = "INSERT INTO transactions_by_day VALUES (?, ?, ?) "
+  "ON CONFLICT(date) DO UPDATE SET amount = amount + excluded.amount, nbr = nbr + excluded.nbr;";
+const char* SQL_REBUILD_SUMMARIES = R"(
+    DELETE FROM transactions_by_department;
+    DELETE FROM transactions_by_source_system;
+    DELETE FROM transactions_by_day;
+    INSERT INTO transactions_by_department SELECT department, SUM(amount), COUNT(*) FROM transactions GROUP BY department;
+    INSERT INTO transactions_by_source_system SELECT source_system, SUM(amount), COUNT(*) FROM transactions GROUP BY source_system;
+    INSERT INTO transactions_by_day SELECT date, SUM(amount), COUNT(*) FROM transactions GROUP BY date;
+  )";
+
+// reference data of get_departments and get_companies, in a private in-memory
+// database attached to each connection; departments come from the summary table (one row per
+// department) instead of a scan of transactions
+const char* SQL_ATTACH_REFERENCE = R"(
+    ATTACH DATABASE ':memory:' AS ref;
+    CREATE TABLE ref.departments (name TEXT PRIMARY KEY) WITHOUT ROWID;
+    CREATE TABLE ref.companies (company_id TEXT PRIMARY KEY) WITHOUT ROWID;
+  )";
+const char* SQL_REFRESH_REFERENCE = R"(
+    DELETE FROM ref.departments;
+    DELETE FROM ref.companies;
+    INSERT INTO ref.departments SELECT department FROM main.transactions_by_department WHERE nbr > 0;
+    INSERT INTO ref.companies SELECT DISTINCT company_id FROM main.financial_records;
+  )";
+
+// history of migrate_schema, one row per migration applied to this file; PRAGMA user_version
+// stays the schema version (databases migrated before this table have no rows for those)
+const char* SQL_CREATE_SCHEMA_VERSION = R"(
+    CREATE TABLE IF NOT EXISTS schema_version (
+        version INTEGER PRIMARY KEY,
+        name TEXT NOT NULL,
+        applied_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
+        seconds REAL NOT NULL
+    );
+  )";
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// SCHEMA_MIGRATIONS
+// applied in order by migrate_schema, the version is kept in PRAGMA user_version and each one is
+// recorded in schema_version
+// append new entries, never edit one that has shipped
+//
+// 1: indexes for the dashboard queries
+//   transactions(date)                      ORDER BY date DESC LIMIT 100 reads the last 100 index entries
+//   transactions(department, amount)        covering, GROUP BY department with SUM(amount)
+//   transactions(source_system)             covering, GROUP BY source_system with COUNT(*)
+//   financial_records(company_id, period)   WHERE company_id = ? ORDER BY period, and ORDER BY company_id, period
+// 2: transactions(department, date)        department filter of get_transactions_page, rows come in
+//                                           (date DESC, id DESC) order from the index
+// 3: summary tables transactions_by_department, transactions_by_source_system, transactions_by_day
+//    (amount and number of transactions per group), filled from transactions; the dashboard
+//    totals read one row per group instead of aggregating all transactions
+//    UPDATE and DELETE keep them current through triggers
+// 4: AFTER INSERT trigger on transactions, so rows inserted by any writer (other programs, the
+//    sqlite3 shell) reach the summaries; the summaries are rebuilt once to drop what earlier
+//    writers left out. an insert trigger, even one that does nothing, costs a bulk insert about
+//    40% of its rows/sec: insert_transactions in bulk load mode (the default, see set_bulk_load)
+//    turns triggers off on its own connection for the load and adds each batch to the summaries
+//    per group in the batch transaction
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const schema_migration_t SCHEMA_MIGRATIONS[] =
+{
+  { 1, "dashboard indexes", R"(
+      CREATE INDEX IF NOT EXISTS idx_transactions_date ON transactions(date);
+      CREATE INDEX IF NOT EXISTS idx_transactions_department_amount ON transactions(department, amount);
+      CREATE INDEX IF NOT EXISTS idx_transactions_source_system ON transactions(source_system);
+      CREATE INDEX IF NOT EXISTS idx_financial_records_company_period ON financial_records(company_id, period);
+  )" },
+  { 2, "department date index", R"(
+      CREATE INDEX IF NOT EXISTS idx_transactions_department_date ON transactions(department, date);
+  )" },
+  { 3, "summary tables", R"(
+      CREATE TABLE IF NOT EXISTS transactions_by_department (
+          department TEXT PRIMARY KEY,
+          amount REAL NOT NULL,
+          nbr INTEGER NOT NULL
+      ) WITHOUT ROWID;
+      CREATE TABLE IF NOT EXISTS transactions_by_source_system (
+          source_system TEXT PRIMARY KEY,
+          amount REAL NOT NULL,
+          nbr INTEGER NOT NULL
+      ) WITHOUT ROWID;
+      CREATE TABLE IF NOT EXISTS transactions_by_day (
+          date TEXT PRIMARY KEY,
+          amount REAL NOT NULL,
+          nbr INTEGER NOT NULL
+      ) WITHOUT ROWID;
+
+      DELETE FROM transactions_by_department;
+      DELETE FROM transactions_by_source_system;
+      DELETE FROM transactions_by_day;
+      INSERT INTO transactions_by_department SELECT department, SUM(amount), COUNT(*) FROM transactions GROUP BY department;
+      INSERT INTO transactions_by_source_system SELECT source_system, SUM(amount), COUNT(*) FROM transactions GROUP BY source_system;
+      INSERT INTO transactions_by_day SELECT date, SUM(amount), COUNT(*) FROM transactions GROUP BY date;
+
+      CREATE TRIGGER IF NOT EXISTS trg_transactions_delete AFTER DELETE ON transactions
+      BEGIN
+          UPDATE transactions_by_department SET amount = amount - OLD.amount, nbr = nbr - 1 WHERE department = OLD.department;
+          DELETE FROM transactions_by_department WHERE department = OLD.department AND nbr = 0;
+          UPDATE transactions_by_source_system SET amount = amount - OLD.amount, nbr = nbr - 1 WHERE source_system = OLD.source_system;
+          DELETE FROM transactions_by_source_system WHERE source_system = OLD.source_system AND nbr = 0;
+          UPDATE transactions_by_day SET amount = amount - OLD.amount, nbr = nbr - 1 WHERE date = OLD.date;
+          DELETE FROM transactions_by_day WHERE date = OLD.date AND nbr = 0;
+      END;
+
+      CREATE TRIGGER IF NOT EXISTS trg_transactions_update AFTER UPDATE OF date, department, amount, source_system ON transactions
+      BEGIN
+          UPDATE transactions_by_department SET amount = amount - OLD.amount, nbr = nbr - 1 WHERE department = OLD.department;
+          DELETE FROM transactions_by_department WHERE department = OLD.department AND nbr = 0;
+          UPDATE transactions_by_source_system SET amount = amount - OLD.amount, nbr = nbr - 1 WHERE source_system = OLD.source_system;
+          DELETE FROM transactions_by_source_system WHERE source_system = OLD.source_system AND nbr = 0;
+          UPDATE transactions_by_day SET amount = amount - OLD.amount, nbr = nbr - 1 WHERE date = OLD.date;
+          DELETE FROM transactions_by_day WHERE date = OLD.date AND nbr = 0;
+          INSERT INTO transactions_by_department VALUES (NEW.department, NEW.amount, 1)
+            ON CONFLICT(department) DO UPDATE SET amount = amount + excluded.amount, nbr = nbr + 1;
+          INSERT INTO transactions_by_source_system VALUES (NEW.source_system, NEW.amount, 1)
+            ON CONFLICT(source_system) DO UPDATE SET amount = amount + excluded.amount, nbr = nbr + 1;
+          INSERT INTO transactions_by_day VALUES (NEW.date, NEW.amount, 1)
+            ON CONFLICT(date) DO UPDATE SET amount = amount + excluded.amount, nbr = nbr + 1;
+      END;
+  )" },
+  { 4, "summary insert trigger", R"(
+      CREATE TRIGGER IF NOT EXISTS trg_transactions_insert AFTER INSERT ON transactions
+      BEGIN
+          INSERT INTO transactions_by_department VALUES (NEW.department, NEW.amount, 1)
+            ON CONFLICT(department) DO UPDATE SET amount = amount + excluded.amount, nbr = nbr + 1;
+          INSERT INTO transactions_by_source_system VALUES (NEW.source_system, NEW.amount, 1)
+            ON CONFLICT(source_system) DO UPDATE SET amount = amount + excluded.amount, nbr = nbr + 1;
+          INSERT INTO transactions_by_day VALUES (NEW.date, NEW.amount, 1)
+            ON CONFLICT(date) DO UPDATE SET amount = amount + excluded.amount, nbr = nbr + 1;
+      END;
+
+      DELETE FROM transactions_by_department;
+      DELETE FROM transactions_by_source_system;
+      DELETE FROM transactions_by_day;
+      INSERT INTO transactions_by_department SELECT department, SUM(amount), COUNT(*) FROM transactions GROUP BY department;
+      INSERT INTO transactions_by_source_system SELECT source_system, SUM(amount), COUNT(*) FROM transactions GROUP BY source_system;
+      INSERT INTO transactions_by_day SELECT date, SUM(amount), COUNT(*) FROM transactions GROUP BY date;
+  )" },
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// SUMMARY_CHECKS
+// for check_summaries: each summary table and the aggregate of transactions it must equal
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct summary_check_t
+{
+  const char* name;
+  const char* summary_sql;
+  const char* base_sql;
+};
+
+const summary_check_t SUMMARY_CHECKS[] =
+{
+  { "transactions_by_department", "SELECT department, amount, nbr FROM transactions_by_department;",
+    "SELECT department, SUM(amount), COUNT(*) FROM transactions GROUP BY department;" },
+  { "transactions_by_source_system", "SELECT source_system, amount, nbr FROM transactions_by_source_system;",
+    "SELECT source_system, SUM(amount), COUNT(*) FROM transactions GROUP BY source_system;" },
+  { "transactions_by_day", "SELECT date, amount, nbr FROM transactions_by_day;",
+    "SELECT date, SUM(amount), COUNT(*) FROM transactions GROUP BY date;" },
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// config_value - string value of "key" in a flat JSON object, empty if missing
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::string config_value(const std::string& content, const std::string& key)
+{
+  size_t pos_key = content.find("\"" + key + "\"");
+  if (pos_key == std::string::npos) return "";
+
+  size_t pos_colon = content.find(":", pos_key);
+  if (pos_colon == std::string::npos) return "";
+
+  size_t first = content.find("\"", pos_colon);
+  if (first == std::string::npos) return "";
+
+  size_t second = content.find("\"", first + 1);
+  if (second == std::string::npos) return "";
+
+  return content.substr(first + 1, second - first - 1);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// pragma_keyword
+// value if it is one of the accepted keywords (case insensitive), empty otherwise, so that
+// a config file can only select settings and never adds SQL to the PRAGMA statements
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::string pragma_keyword(const std::string& value, const std::vector<std::string>& accepted)
+{
+  std::string upper = value;
+  std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+  if (std::find(accepted.begin(), accepted.end(), upper) != accepted.end())
+  {
+    return upper;
+  }
+  return "";
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// sqlite_profile_t::load
+// missing file or keys keep the defaults, invalid values are ignored
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+sqlite_profile_t sqlite_profile_t::load(const std::string& config_file)
+{
+  sqlite_profile_t profile;
+  std::ifstream file(config_file);
+  if (!file.is_open())
+  {
+    return profile;
+  }
+  std::stringstream ss;
+  ss << file.rdbuf();
+  std::string buf = ss.str();
+
+  std::string value = pragma_keyword(config_value(buf, "SQLITE_JOURNAL_MODE"), { "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF" });
+  if (!value.empty()) profile.journal_mode = value;
+  value = pragma_keyword(config_value(buf, "SQLITE_SYNCHRONOUS"), { "OFF", "NORMAL", "FULL", "EXTRA" });
+  if (!value.empty()) profile.synchronous = value;
+  value = pragma_keyword(config_value(buf, "SQLITE_TEMP_STORE"), { "DEFAULT", "FILE", "MEMORY" });
+  if (!value.empty()) profile.temp_store = value;
+
+  value = config_value(buf, "SQLITE_MMAP_SIZE");
+  if (!value.empty()) profile.mmap_size = std::strtoll(value.c_str(), nullptr, 10);
+  value = config_value(buf, "SQLITE_CACHE_SIZE");
+  if (!value.empty()) profile.cache_size = std::strtoll(value.c_str(), nullptr, 10);
+  value = config_value(buf, "SQLITE_BUSY_TIMEOUT");
+  if (!value.empty()) profile.busy_timeout = std::atoi(value.c_str());
+  return profile;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// default_sqlite_profile
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const sqlite_profile_t& default_sqlite_profile()
+{
+  static const sqlite_profile_t profile = sqlite_profile_t::load("config.json");
+  return profile;
+}
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // finmart_db
+// initialize = false skips schema creation and sample data checks, for connections opened
+// after the schema is known to exist (see DatabasePool)
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-finmart_db::finmart_db(const std::string& db_path)
+finmart_db::finmart_db(const std::string& db_path, bool initialize, const sqlite_profile_t& profile) :
+  reference_version(-1),
+  reference_changes(-1),
+  bulk_load(true)
 {
   int rc = sqlite3_open(db_path.c_str(), &db);
   if (rc)
   {
+    sqlite3_close(db);
     db = nullptr;
+    return;
   }
-  else
+  apply_profile(profile);
+  if (initialize)
   {
     initialize_database();
   }
+
+  char* err_msg = nullptr;
+  if (sqlite3_exec(db, SQL_ATTACH_REFERENCE, nullptr, nullptr, &err_msg) != SQLITE_OK)
+  {
+    std::cerr << "attach reference data: " << (err_msg ? err_msg : "") << std::endl;
+    sqlite3_free(err_msg);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// apply_profile
+// the busy timeout goes first, switching to WAL needs a moment of exclusive access when other
+// connections are open; journal_mode is stored in the file, the other settings are per connection
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void finmart_db::apply_profile(const sqlite_profile_t& profile)
+{
+  if (profile.busy_timeout >= 0)
+  {
+    sqlite3_busy_timeout(db, profile.busy_timeout);
+  }
+
+  std::vector<std::string> pragmas;
+  if (!profile.journal_mode.empty())
+  {
+    pragmas.push_back("PRAGMA journal_mode=" + profile.journal_mode + ";");
+  }
+  if (!profile.synchronous.empty())
+  {
+    pragmas.push_back("PRAGMA synchronous=" + profile.synchronous + ";");
+  }
+  if (profile.mmap_size >= 0)
+  {
+    pragmas.push_back("PRAGMA mmap_size=" + std::to_string(profile.mmap_size) + ";");
+  }
+  if (profile.cache_size != 0)
+  {
+    pragmas.push_back("PRAGMA cache_size=" + std::to_string(profile.cache_size) + ";");
+  }
+  if (!profile.temp_store.empty())
+  {
+    pragmas.push_back("PRAGMA temp_store=" + profile.temp_store + ";");
+  }
+
+  for (size_t idx = 0; idx < pragmas.size(); idx++)
+  {
+    char* err_msg = nullptr;
+    if (sqlite3_exec(db, pragmas[idx].c_str(), nullptr, nullptr, &err_msg) != SQLITE_OK)
+    {
+      std::cerr << pragmas[idx] << " " << (err_msg ? err_msg : "") << std::endl;
+      sqlite3_free(err_msg);
+    }
+  }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -23,12 +348,51 @@ finmart_db::finmart_db(const std::string& db_path)
 
 finmart_db::~finmart_db()
 {
+  clear_statement_cache();
   if (db)
   {
     sqlite3_close(db);
   }
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// prepare
+// returns the cached statement for sql, preparing it on first use; nullptr on error
+// the statement stays owned by the cache, wrap it in a cached_stmt instead of finalizing it
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+sqlite3_stmt* finmart_db::prepare(const char* sql)
+{
+  std::string key(sql);
+  std::unordered_map<std::string, sqlite3_stmt*>::iterator it = stmt_cache.find(key);
+  if (it != stmt_cache.end())
+  {
+    return it->second;
+  }
+
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK)
+  {
+    sqlite3_finalize(stmt);
+    return nullptr;
+  }
+  stmt_cache.emplace(std::move(key), stmt);
+  return stmt;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// clear_statement_cache - finalize all cached statements
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void finmart_db::clear_statement_cache()
+{
+  for (std::unordered_map<std::string, sqlite3_stmt*>::iterator it = stmt_cache.begin(); it != stmt_cache.end(); ++it)
+  {
+    sqlite3_finalize(it->second);
+  }
+  stmt_cache.clear();
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // initialize_database
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -85,6 +449,8 @@ void finmart_db::initialize_database()
     sqlite3_free(err_msg);
   }
 
+  migrate_schema();
+
   /////////////////////////////////////////////////////////////////////////////////////////////////////
   // check if we need to populate sample data
   /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -119,6 +485,105 @@ void finmart_db::initialize_database()
   sqlite3_finalize(stmt);
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// migrate_schema
+// runs the SCHEMA_MIGRATIONS newer than the database, each in its own transaction together with
+// its user_version update and its schema_version row (name, time, seconds the SQL took), and
+// logs each one with its time; stops at the first failure, returns 0 if the schema is up to date
+// a migration holds the write lock while it runs, WAL readers are not blocked
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::migrate_schema()
+{
+  if (!db) return -1;
+  int version = get_schema_version();
+  if (version < 0) return -1;
+  if (sqlite3_exec(db, SQL_CREATE_SCHEMA_VERSION, nullptr, nullptr, nullptr) != SQLITE_OK) return -1;
+
+  for (size_t idx = 0; idx < sizeof(SCHEMA_MIGRATIONS) / sizeof(SCHEMA_MIGRATIONS[0]); idx++)
+  {
+    const schema_migration_t& migration = SCHEMA_MIGRATIONS[idx];
+    if (migration.version <= version)
+    {
+      continue;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string sql = std::string("BEGIN;") + migration.sql;
+    char* err_msg = nullptr;
+    int rc = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err_msg);
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    if (rc == SQLITE_OK)
+    {
+      rc = record_migration(migration, seconds.count());
+    }
+    if (rc != SQLITE_OK)
+    {
+      std::cerr << "schema migration " << migration.version << " (" << migration.name << ") failed: "
+        << (err_msg ? err_msg : sqlite3_errmsg(db)) << std::endl;
+      sqlite3_free(err_msg);
+      sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+      return -1;
+    }
+    std::cerr << "schema migration " << migration.version << " (" << migration.name << "): "
+      << seconds.count() << " s" << std::endl;
+    version = migration.version;
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// record_migration
+// inside the transaction of the migration: its schema_version row, user_version, then COMMIT
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::record_migration(const schema_migration_t& migration, double seconds)
+{
+  sqlite3_stmt* stmt = nullptr;
+  int rc = sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO schema_version (version, name, seconds) VALUES (?, ?, ?);",
+    -1, &stmt, nullptr);
+  if (rc == SQLITE_OK)
+  {
+    sqlite3_bind_int(stmt, 1, migration.version);
+    sqlite3_bind_text(stmt, 2, migration.name, -1, SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 3, seconds);
+    rc = sqlite3_step(stmt) == SQLITE_DONE ? SQLITE_OK : sqlite3_errcode(db);
+  }
+  sqlite3_finalize(stmt);
+  if (rc != SQLITE_OK)
+  {
+    return rc;
+  }
+  std::string sql = "PRAGMA user_version = " + std::to_string(migration.version) + ";COMMIT;";
+  return sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_schema_version - PRAGMA user_version, -1 on error
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::get_schema_version()
+{
+  if (!db) return -1;
+  sqlite3_stmt* stmt = nullptr;
+  int version = -1;
+  if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW)
+  {
+    version = sqlite3_column_int(stmt, 0);
+  }
+  sqlite3_finalize(stmt);
+  return version;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// latest_schema_version - version of the last entry in SCHEMA_MIGRATIONS
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::latest_schema_version()
+{
+  return SCHEMA_MIGRATIONS[sizeof(SCHEMA_MIGRATIONS) / sizeof(SCHEMA_MIGRATIONS[0]) - 1].version;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // populate_sample_data
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -130,28 +595,25 @@ void finmart_db::populate_sample_data()
   std::vector<std::string> vendors = { "Microsoft", "Dell", "AWS", "Oracle", "Cisco", "Adobe" };
   std::vector<std::string> systems = { "PeopleSoft", "Coupa", "SAP", "Legacy" };
 
-  const char* sql = "INSERT INTO transactions (date, department, category, vendor, amount, status, source_system) VALUES (?, ?, ?, ?, ?, ?, ?);";
-
-  for (int idx = 0; idx < 50; idx++)
+  std::vector<transaction> transactions(50);
+  for (size_t idx = 0; idx < transactions.size(); idx++)
   {
-    sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-
     std::stringstream date_str;
     date_str << "2025-" << std::setfill('0') << std::setw(2) << ((idx % 12) + 1)
       << "-" << std::setfill('0') << std::setw(2) << ((idx % 28) + 1);
 
-    sqlite3_bind_text(stmt, 1, date_str.str().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, departments[idx % departments.size()].c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, categories[idx % categories.size()].c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 4, vendors[idx % vendors.size()].c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_double(stmt, 5, (rand() % 50000 + 1000) / 100.0);
-    sqlite3_bind_text(stmt, 6, (idx % 10 == 0) ? "Pending" : "Approved", -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 7, systems[idx % systems.size()].c_str(), -1, SQLITE_TRANSIENT);
-
-    sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    transaction& t = transactions[idx];
+    t.id = 0;
+    t.date = date_str.str();
+    t.department = departments[idx % departments.size()];
+    t.category = categories[idx % categories.size()];
+    t.vendor = vendors[idx % vendors.size()];
+    t.amount = (rand() % 50000 + 1000) / 100.0;
+    t.status = (idx % 10 == 0) ? "Pending" : "Approved";
+    t.source_system = systems[idx % systems.size()];
   }
+
+  insert_transactions(transactions);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -165,8 +627,8 @@ std::vector<transaction> finmart_db::get_all_transactions()
 
   const char* query = "SELECT * FROM transactions ORDER BY date DESC LIMIT 100;";
 
-  sqlite3_stmt* stmt;
-  sqlite3_prepare_v2(db, query, -1, &stmt, nullptr);
+  cached_stmt stmt(prepare(query));
+  if (!stmt) return transactions;
 
   while (sqlite3_step(stmt) == SQLITE_ROW)
   {
@@ -182,12 +644,11 @@ std::vector<transaction> finmart_db::get_all_transactions()
     transactions.push_back(t);
   }
 
-  sqlite3_finalize(stmt);
   return transactions;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
-// get_department_spending
+// get_department_spending - one row per department from the summary table
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 std::map<std::string, double> finmart_db::get_department_spending()
@@ -195,10 +656,10 @@ std::map<std::string, double> finmart_db::get_department_spending()
   std::map<std::string, double> spending;
   if (!db) return spending;
 
-  const char* query = "SELECT department, SUM(amount) FROM transactions GROUP BY department;";
+  const char* query = "SELECT department, amount FROM transactions_by_department;";
 
-  sqlite3_stmt* stmt;
-  sqlite3_prepare_v2(db, query, -1, &stmt, nullptr);
+  cached_stmt stmt(prepare(query));
+  if (!stmt) return spending;
 
   while (sqlite3_step(stmt) == SQLITE_ROW)
   {
@@ -207,12 +668,11 @@ std::map<std::string, double> finmart_db::get_department_spending()
     spending[dept] = total;
   }
 
-  sqlite3_finalize(stmt);
   return spending;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
-// get_source_system_counts
+// get_source_system_counts - one row per source system from the summary table
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 std::map<std::string, int> finmart_db::get_source_system_counts()
@@ -220,10 +680,10 @@ std::map<std::string, int> finmart_db::get_source_system_counts()
   std::map<std::string, int> counts;
   if (!db) return counts;
 
-  const char* query = "SELECT source_system, COUNT(*) FROM transactions GROUP BY source_system;";
+  const char* query = "SELECT source_system, nbr FROM transactions_by_source_system;";
 
-  sqlite3_stmt* stmt;
-  sqlite3_prepare_v2(db, query, -1, &stmt, nullptr);
+  cached_stmt stmt(prepare(query));
+  if (!stmt) return counts;
 
   while (sqlite3_step(stmt) == SQLITE_ROW)
   {
@@ -232,21 +692,20 @@ std::map<std::string, int> finmart_db::get_source_system_counts()
     counts[system] = count;
   }
 
-  sqlite3_finalize(stmt);
   return counts;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
-// get_total_spending
+// get_total_spending - sum of the department summaries
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 double finmart_db::get_total_spending()
 {
   if (!db) return 0.0;
 
-  const char* query = "SELECT SUM(amount) FROM transactions;";
-  sqlite3_stmt* stmt;
-  sqlite3_prepare_v2(db, query, -1, &stmt, nullptr);
+  const char* query = "SELECT SUM(amount) FROM transactions_by_department;";
+  cached_stmt stmt(prepare(query));
+  if (!stmt) return 0.0;
 
   double total = 0.0;
   if (sqlite3_step(stmt) == SQLITE_ROW)
@@ -254,10 +713,218 @@ double finmart_db::get_total_spending()
     total = sqlite3_column_double(stmt, 0);
   }
 
-  sqlite3_finalize(stmt);
   return total;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_daily_spending - transactions_by_day between date_from and date_to (inclusive)
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::map<std::string, double> finmart_db::get_daily_spending(const std::string& date_from, const std::string& date_to)
+{
+  std::map<std::string, double> spending;
+  if (!db) return spending;
+
+  const char* query = "SELECT date, amount FROM transactions_by_day WHERE date >= ? AND date <= ?;";
+  cached_stmt stmt(prepare(query));
+  if (!stmt) return spending;
+  sqlite3_bind_text(stmt, 1, date_from.c_str(), static_cast<int>(date_from.size()), SQLITE_STATIC);
+  sqlite3_bind_text(stmt, 2, date_to.c_str(), static_cast<int>(date_to.size()), SQLITE_STATIC);
+
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+  {
+    spending[reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))] = sqlite3_column_double(stmt, 1);
+  }
+  return spending;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// check_summaries
+// recomputes every SUMMARY_CHECKS aggregate from transactions and compares it with its summary
+// table; both reads run in one read transaction, so a concurrent writer cannot make them differ
+// returns the number of mismatches (described in mismatches), -1 on error
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::check_summaries(std::vector<std::string>& mismatches)
+{
+  if (!db) return -1;
+  size_t first = mismatches.size();
+  if (sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr) != SQLITE_OK) return -1;
+
+  int ret = 0;
+  for (size_t idx = 0; idx < sizeof(SUMMARY_CHECKS) / sizeof(SUMMARY_CHECKS[0]) && ret == 0; idx++)
+  {
+    summary_map_t summary;
+    summary_map_t base;
+    ret = read_summary(SUMMARY_CHECKS[idx].summary_sql, summary);
+    if (ret == 0)
+    {
+      ret = read_summary(SUMMARY_CHECKS[idx].base_sql, base);
+    }
+    if (ret == 0)
+    {
+      compare_summaries(SUMMARY_CHECKS[idx].name, base, summary, mismatches);
+    }
+  }
+
+  sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+  return ret == 0 ? static_cast<int>(mismatches.size() - first) : -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// rebuild_summaries - recomputes the summary tables from transactions in one transaction
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::rebuild_summaries()
+{
+  if (!db) return -1;
+  std::string sql = std::string("BEGIN;") + SQL_REBUILD_SUMMARIES + "COMMIT;";
+  char* err_msg = nullptr;
+  if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err_msg) != SQLITE_OK)
+  {
+    std::cerr << "rebuild_summaries: " << (err_msg ? err_msg : "") << std::endl;
+    sqlite3_free(err_msg);
+    sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+    return -1;
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// restore_from
+// replaces the content of this database by a copy of source_path with the backup API, in one
+// write transaction on this connection: in WAL mode other connections keep reading the old
+// content until it commits and see the new one in their next read transaction. the source is
+// opened read-only and must have the page size of this database (both are created by
+// finmart_db); waits up to the busy timeout for another writer of this database
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::restore_from(const std::string& source_path)
+{
+  if (!db) return -1;
+  sqlite3* source = nullptr;
+  if (sqlite3_open_v2(source_path.c_str(), &source, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK)
+  {
+    std::cerr << "restore_from: cannot open " << source_path << std::endl;
+    sqlite3_close(source);
+    return -1;
+  }
+
+  int rc = SQLITE_ERROR;
+  sqlite3_backup* backup = sqlite3_backup_init(db, "main", source, "main");
+  if (backup)
+  {
+    rc = sqlite3_backup_step(backup, -1);
+    sqlite3_backup_finish(backup);
+  }
+  if (rc != SQLITE_DONE)
+  {
+    std::cerr << "restore_from: " << source_path << ": " << sqlite3_errmsg(db) << std::endl;
+  }
+  sqlite3_close(source);
+  return rc == SQLITE_DONE ? 0 : -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// refresh_reference_data
+// reloads the ref tables from the database in one transaction, and remembers the data version
+// it read them at
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::refresh_reference_data()
+{
+  if (!db) return -1;
+  std::string sql = std::string("BEGIN;") + SQL_REFRESH_REFERENCE;
+  char* err_msg = nullptr;
+  if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err_msg) != SQLITE_OK)
+  {
+    std::cerr << "refresh_reference_data: " << (err_msg ? err_msg : "") << std::endl;
+    sqlite3_free(err_msg);
+    sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+    return -1;
+  }
+  long long version = data_version();
+  if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK)
+  {
+    sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+    return -1;
+  }
+  reference_version = version;
+  reference_changes = sqlite3_total_changes64(db);
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// data_version
+// PRAGMA data_version of the main database: changes when another connection, of this process or
+// another one, commits to it (e.g. publish_staging into the replica); read from the WAL index,
+// without reading the database file
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+long long finmart_db::data_version()
+{
+  cached_stmt stmt(prepare("PRAGMA main.data_version;"));
+  if (!stmt || sqlite3_step(stmt) != SQLITE_ROW) return -1;
+  return sqlite3_column_int64(stmt, 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// read_reference
+// rows of a ref table, after a refresh if the database changed since the last one: committed
+// by another connection (data version) or written by this one (total changes)
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::string> finmart_db::read_reference(const char* sql)
+{
+  std::vector<std::string> values;
+  if (!db) return values;
+  if (data_version() != reference_version || sqlite3_total_changes64(db) != reference_changes)
+  {
+    refresh_reference_data();
+  }
+
+  cached_stmt stmt(prepare(sql));
+  if (!stmt) return values;
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+  {
+    values.push_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+  }
+  return values;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_departments, get_companies - sorted, from the ref tables
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::string> finmart_db::get_departments()
+{
+  return read_reference("SELECT name FROM ref.departments ORDER BY name;");
+}
+
+std::vector<std::string> finmart_db::get_companies()
+{
+  return read_reference("SELECT company_id FROM ref.companies ORDER BY company_id;");
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// read_summary - rows (key, amount, nbr) of sql into summary
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::read_summary(const char* sql, summary_map_t& summary)
+{
+  cached_stmt stmt(prepare(sql));
+  if (!stmt) return -1;
+
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+  {
+    transaction_summary& group = summary[reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))];
+    group.amount = sqlite3_column_double(stmt, 1);
+    group.nbr = sqlite3_column_int64(stmt, 2);
+  }
+  return rc == SQLITE_DONE ? 0 : -1;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // is_open - check if database opened successfully
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -276,14 +943,8 @@ void finmart_db::populate_financial_data()
   std::vector<std::string> companies = { "ACME Corp", "TechVentures", "GlobalTrade" };
   std::vector<std::string> periods = { "2024-Q1", "2024-Q2", "2024-Q3", "2024-Q4", "2025-Q1" };
 
-  const char* sql = R"(
-    INSERT INTO financial_records 
-    (period, company_id, revenue, cogs, operating_expenses, depreciation, amortization,
-     interest, taxes, current_assets, current_liabilities, inventory, total_assets, total_liabilities)
-    VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);
-  )";
-
   double base_revenue = 1000000.0;
+  std::vector<FinancialRecord> records;
 
   for (size_t cidx = 0; cidx < companies.size(); ++cidx)
   {
@@ -293,41 +954,26 @@ void finmart_db::populate_financial_data()
     {
       double growth = 1.0 + (pidx * 0.05);
 
-      sqlite3_stmt* stmt;
-      sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-
-      double revenue = base_revenue * company_factor * growth;
-      double cogs = revenue * (0.55 + (rand() % 10) / 100.0);
-      double opex = revenue * (0.20 + (rand() % 5) / 100.0);
-      double depr = revenue * 0.03;
-      double amort = revenue * 0.02;
-      double interest_exp = revenue * 0.02;
-      double taxes_exp = (revenue - cogs - opex - depr - amort - interest_exp) * 0.25;
-      double curr_assets = revenue * 0.4;
-      double curr_liab = revenue * 0.25;
-      double inv = revenue * 0.15;
-      double tot_assets = revenue * 2.0;
-      double tot_liab = revenue * 0.8;
-
-      sqlite3_bind_text(stmt, 1, periods[pidx].c_str(), -1, SQLITE_TRANSIENT);
-      sqlite3_bind_text(stmt, 2, companies[cidx].c_str(), -1, SQLITE_TRANSIENT);
-      sqlite3_bind_double(stmt, 3, revenue);
-      sqlite3_bind_double(stmt, 4, cogs);
-      sqlite3_bind_double(stmt, 5, opex);
-      sqlite3_bind_double(stmt, 6, depr);
-      sqlite3_bind_double(stmt, 7, amort);
-      sqlite3_bind_double(stmt, 8, interest_exp);
-      sqlite3_bind_double(stmt, 9, taxes_exp);
-      sqlite3_bind_double(stmt, 10, curr_assets);
-      sqlite3_bind_double(stmt, 11, curr_liab);
-      sqlite3_bind_double(stmt, 12, inv);
-      sqlite3_bind_double(stmt, 13, tot_assets);
-      sqlite3_bind_double(stmt, 14, tot_liab);
-
-      sqlite3_step(stmt);
-      sqlite3_finalize(stmt);
+      FinancialRecord r;
+      r.period = periods[pidx];
+      r.company_id = companies[cidx];
+      r.revenue = base_revenue * company_factor * growth;
+      r.cogs = r.revenue * (0.55 + (rand() % 10) / 100.0);
+      r.operating_expenses = r.revenue * (0.20 + (rand() % 5) / 100.0);
+      r.depreciation = r.revenue * 0.03;
+      r.amortization = r.revenue * 0.02;
+      r.interest = r.revenue * 0.02;
+      r.taxes = (r.revenue - r.cogs - r.operating_expenses - r.depreciation - r.amortization - r.interest) * 0.25;
+      r.current_assets = r.revenue * 0.4;
+      r.current_liabilities = r.revenue * 0.25;
+      r.inventory = r.revenue * 0.15;
+      r.total_assets = r.revenue * 2.0;
+      r.total_liabilities = r.revenue * 0.8;
+      records.push_back(r);
     }
   }
+
+  insert_financial_records(records);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -343,8 +989,8 @@ std::vector<FinancialRecord> finmart_db::get_financial_records()
     "depreciation, amortization, interest, taxes, current_assets, current_liabilities, "
     "inventory, total_assets, total_liabilities FROM financial_records ORDER BY company_id, period;";
 
-  sqlite3_stmt* stmt;
-  sqlite3_prepare_v2(db, query, -1, &stmt, nullptr);
+  cached_stmt stmt(prepare(query));
+  if (!stmt) return records;
 
   while (sqlite3_step(stmt) == SQLITE_ROW)
   {
@@ -366,7 +1012,6 @@ std::vector<FinancialRecord> finmart_db::get_financial_records()
     records.push_back(r);
   }
 
-  sqlite3_finalize(stmt);
   return records;
 }
 
@@ -383,8 +1028,8 @@ std::vector<FinancialRecord> finmart_db::get_financial_records_by_company(const
     "depreciation, amortization, interest, taxes, current_assets, current_liabilities, "
     "inventory, total_assets, total_liabilities FROM financial_records WHERE company_id = ? ORDER BY period;";
 
-  sqlite3_stmt* stmt;
-  sqlite3_prepare_v2(db, query, -1, &stmt, nullptr);
+  cached_stmt stmt(prepare(query));
+  if (!stmt) return records;
   sqlite3_bind_text(stmt, 1, company_id.c_str(), -1, SQLITE_TRANSIENT);
 
   while (sqlite3_step(stmt) == SQLITE_ROW)
@@ -407,10 +1052,192 @@ std::vector<FinancialRecord> finmart_db::get_financial_records_by_company(const
     records.push_back(r);
   }
 
-  sqlite3_finalize(stmt);
   return records;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// bind_values - binds values to the markers starting at index first, returns the next index
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static int bind_values(sqlite3_stmt* stmt, const std::vector<sql_value_t>& values, int first)
+{
+  int param = first;
+  for (size_t idx = 0; idx < values.size(); idx++)
+  {
+    if (values[idx].is_text)
+    {
+      sqlite3_bind_text(stmt, param++, values[idx].text.c_str(), static_cast<int>(values[idx].text.size()), SQLITE_STATIC);
+    }
+    else
+    {
+      sqlite3_bind_double(stmt, param++, values[idx].number);
+    }
+  }
+  return param;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_transactions_page
+// reads one row more than page_size to know whether another page follows; the row value
+// comparison is a range on idx_transactions_date, whose entries end with the rowid (id), or on
+// idx_transactions_department_date when the filter sets the department
+// the statement text depends only on which filter members are set, so the cache holds at most
+// one statement per combination
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+transaction_page finmart_db::get_transactions_page(const transaction_filter& filter, const transaction_cursor& after, size_t page_size)
+{
+  transaction_page page;
+  if (!db || page_size == 0) return page;
+
+  std::vector<sql_value_t> values;
+  std::string where = filter.where_clause(values);
+  if (!after.is_start())
+  {
+    where += where.empty() ? "(date, id) < (?, ?)" : " AND (date, id) < (?, ?)";
+  }
+  std::string query = "SELECT id, date, department, category, vendor, amount, status, source_system FROM transactions ";
+  if (!where.empty())
+  {
+    query += "WHERE " + where + " ";
+  }
+  query += "ORDER BY date DESC, id DESC LIMIT ?;";
+
+  cached_stmt stmt(prepare(query.c_str()));
+  if (!stmt) return page;
+  int param = bind_values(stmt, values, 1);
+  if (!after.is_start())
+  {
+    sqlite3_bind_text(stmt, param++, after.date.c_str(), static_cast<int>(after.date.size()), SQLITE_STATIC);
+    sqlite3_bind_int(stmt, param++, after.id);
+  }
+  sqlite3_bind_int64(stmt, param, static_cast<sqlite3_int64>(page_size) + 1);
+
+  page.rows.reserve(page_size);
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+  {
+    if (page.rows.size() == page_size)
+    {
+      page.has_more = true;
+      break;
+    }
+    transaction t;
+    t.id = sqlite3_column_int(stmt, 0);
+    t.date = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    t.department = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+    t.category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+    t.vendor = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+    t.amount = sqlite3_column_double(stmt, 5);
+    t.status = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
+    t.source_system = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7));
+    page.rows.push_back(t);
+  }
+
+  if (!page.rows.empty())
+  {
+    page.next.date = page.rows.back().date;
+    page.next.id = page.rows.back().id;
+  }
+  return page;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// column_view
+// text of a column without a copy; sqlite3_column_text before sqlite3_column_bytes, so the
+// length is the one of the UTF-8 text; valid until the next step or reset
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::string_view column_view(sqlite3_stmt* stmt, int col)
+{
+  const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+  if (!text) return std::string_view();
+  return std::string_view(text, static_cast<size_t>(sqlite3_column_bytes(stmt, col)));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// for_each_transaction
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::for_each_transaction(const transaction_filter& filter, const std::function<bool(const transaction_view&)>& visit)
+{
+  if (!db) return -1;
+
+  std::vector<sql_value_t> values;
+  std::string where = filter.where_clause(values);
+  std::string query = "SELECT id, date, department, category, vendor, amount, status, source_system FROM transactions ";
+  if (!where.empty())
+  {
+    query += "WHERE " + where + " ";
+  }
+  query += "ORDER BY date DESC, id DESC;";
+
+  cached_stmt stmt(prepare(query.c_str()));
+  if (!stmt) return -1;
+  bind_values(stmt, values, 1);
+
+  transaction_view t;
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+  {
+    t.id = sqlite3_column_int(stmt, 0);
+    t.date = column_view(stmt, 1);
+    t.department = column_view(stmt, 2);
+    t.category = column_view(stmt, 3);
+    t.vendor = column_view(stmt, 4);
+    t.amount = sqlite3_column_double(stmt, 5);
+    t.status = column_view(stmt, 6);
+    t.source_system = column_view(stmt, 7);
+    if (!visit(t))
+    {
+      return 0;
+    }
+  }
+
+  return rc == SQLITE_DONE ? 0 : -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// for_each_financial_record
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::for_each_financial_record(const std::function<bool(const financial_record_view&)>& visit)
+{
+  if (!db) return -1;
+
+  const char* query = "SELECT period, company_id, revenue, cogs, operating_expenses, "
+    "depreciation, amortization, interest, taxes, current_assets, current_liabilities, "
+    "inventory, total_assets, total_liabilities FROM financial_records ORDER BY company_id, period;";
+
+  cached_stmt stmt(prepare(query));
+  if (!stmt) return -1;
+
+  financial_record_view r;
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+  {
+    r.period = column_view(stmt, 0);
+    r.company_id = column_view(stmt, 1);
+    r.revenue = sqlite3_column_double(stmt, 2);
+    r.cogs = sqlite3_column_double(stmt, 3);
+    r.operating_expenses = sqlite3_column_double(stmt, 4);
+    r.depreciation = sqlite3_column_double(stmt, 5);
+    r.amortization = sqlite3_column_double(stmt, 6);
+    r.interest = sqlite3_column_double(stmt, 7);
+    r.taxes = sqlite3_column_double(stmt, 8);
+    r.current_assets = sqlite3_column_double(stmt, 9);
+    r.current_liabilities = sqlite3_column_double(stmt, 10);
+    r.inventory = sqlite3_column_double(stmt, 11);
+    r.total_assets = sqlite3_column_double(stmt, 12);
+    r.total_liabilities = sqlite3_column_double(stmt, 13);
+    if (!visit(r))
+    {
+      return 0;
+    }
+  }
+
+  return rc == SQLITE_DONE ? 0 : -1;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // insert_financial_record
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -419,18 +1246,200 @@ int finmart_db::insert_financial_record(const FinancialRecord& record)
 {
   if (!db) return -1;
 
-  const char* sql = R"(
-    INSERT INTO financial_records 
-    (period, company_id, revenue, cogs, operating_expenses, depreciation, amortization,
-     interest, taxes, current_assets, current_liabilities, inventory, total_assets, total_liabilities)
-    VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);
-  )";
+  cached_stmt stmt(prepare(SQL_INSERT_FINANCIAL_RECORD));
+  if (!stmt) return -1;
 
-  sqlite3_stmt* stmt;
-  sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+  bind_financial_record(stmt, record);
+  int rc = sqlite3_step(stmt);
+
+  return (rc == SQLITE_DONE) ? 0 : -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// insert_financial_records
+// batch insert: one prepared statement, BEGIN/COMMIT every INSERT_BATCH_SIZE rows
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::insert_financial_records(const std::vector<FinancialRecord>& records)
+{
+  return insert_batch(SQL_INSERT_FINANCIAL_RECORD, records.size(), [&records](sqlite3_stmt* stmt, size_t idx)
+    {
+      bind_financial_record(stmt, records[idx]);
+    });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// insert_transactions
+// batch insert, the id column is assigned by the database
+// in bulk load mode the insert trigger is off on this connection while the rows are inserted and
+// the summaries are added per batch instead; otherwise the trigger maintains them row by row
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::insert_transactions(const std::vector<transaction>& transactions)
+{
+  auto bind = [&transactions](sqlite3_stmt* stmt, size_t idx)
+  {
+    bind_transaction(stmt, transactions[idx]);
+  };
+  if (!bulk_load)
+  {
+    return insert_batch(SQL_INSERT_TRANSACTION, transactions.size(), bind);
+  }
 
-  sqlite3_bind_text(stmt, 1, record.period.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 2, record.company_id.c_str(), -1, SQLITE_TRANSIENT);
+  if (!db || sqlite3_db_config(db, SQLITE_DBCONFIG_ENABLE_TRIGGER, 0, nullptr) != SQLITE_OK)
+  {
+    return -1;
+  }
+  int ret = insert_batch(SQL_INSERT_TRANSACTION, transactions.size(), bind,
+    [this, &transactions](size_t first, size_t end)
+    {
+      return add_to_summaries(transactions, first, end);
+    });
+  sqlite3_db_config(db, SQLITE_DBCONFIG_ENABLE_TRIGGER, 1, nullptr);
+  return ret;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// set_bulk_load
+// true (the default): ETL loads through insert_transactions skip the per-row insert trigger
+// false: insert_transactions leaves summary maintenance to the trigger, as for any other writer
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void finmart_db::set_bulk_load(bool enable)
+{
+  bulk_load = enable;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// insert_batch
+// steps the cached statement for rows [0, nbr_rows), binding each row with bind
+// if the caller already has a transaction open, the rows join it and no BEGIN/COMMIT is issued;
+// otherwise a failed batch is rolled back (earlier committed batches stay)
+// summarize(first, end), when given, runs after the rows of each batch, in the same transaction
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::insert_batch(const char* sql, size_t nbr_rows, const std::function<void(sqlite3_stmt*, size_t)>& bind,
+  const std::function<int(size_t, size_t)>& summarize)
+{
+  if (!db) return -1;
+
+  cached_stmt stmt(prepare(sql));
+  if (!stmt) return -1;
+
+  bool own_transaction = sqlite3_get_autocommit(db) != 0;
+  size_t row = 0;
+  while (row < nbr_rows)
+  {
+    size_t first = row;
+    size_t end = std::min(row + INSERT_BATCH_SIZE, nbr_rows);
+    if (own_transaction && sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+      return -1;
+    }
+
+    int rc = SQLITE_DONE;
+    for (; row < end && rc == SQLITE_DONE; row++)
+    {
+      bind(stmt, row);
+      rc = sqlite3_step(stmt);
+      sqlite3_reset(stmt);
+    }
+    if (rc == SQLITE_DONE && summarize && summarize(first, end) != 0)
+    {
+      rc = SQLITE_ERROR;
+    }
+    if (rc != SQLITE_DONE)
+    {
+      if (own_transaction)
+      {
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+      }
+      return -1;
+    }
+
+    if (own_transaction && sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+      sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// add_to_summaries
+// adds transactions [first, end) to the summary tables, one upsert per group of the batch
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::add_to_summaries(const std::vector<transaction>& transactions, size_t first, size_t end)
+{
+  summary_map_t by_department;
+  summary_map_t by_source_system;
+  summary_map_t by_day;
+  for (size_t idx = first; idx < end; idx++)
+  {
+    const transaction& t = transactions[idx];
+    transaction_summary& department = by_department[t.department];
+    department.amount += t.amount;
+    department.nbr++;
+    transaction_summary& source_system = by_source_system[t.source_system];
+    source_system.amount += t.amount;
+    source_system.nbr++;
+    transaction_summary& day = by_day[t.date];
+    day.amount += t.amount;
+    day.nbr++;
+  }
+
+  if (add_summary(SQL_ADD_DEPARTMENT_SUMMARY, by_department) != 0) return -1;
+  if (add_summary(SQL_ADD_SOURCE_SYSTEM_SUMMARY, by_source_system) != 0) return -1;
+  return add_summary(SQL_ADD_DAY_SUMMARY, by_day);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// add_summary - runs the upsert sql (key, amount, nbr) for each group
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int finmart_db::add_summary(const char* sql, const summary_map_t& groups)
+{
+  cached_stmt stmt(prepare(sql));
+  if (!stmt) return -1;
+
+  for (summary_map_t::const_iterator it = groups.begin(); it != groups.end(); ++it)
+  {
+    sqlite3_bind_text(stmt, 1, it->first.c_str(), static_cast<int>(it->first.size()), SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 2, it->second.amount);
+    sqlite3_bind_int64(stmt, 3, it->second.nbr);
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (rc != SQLITE_DONE) return -1;
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// bind_transaction - parameters of SQL_INSERT_TRANSACTION
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void finmart_db::bind_transaction(sqlite3_stmt* stmt, const transaction& t)
+{
+  sqlite3_bind_text(stmt, 1, t.date.c_str(), static_cast<int>(t.date.size()), SQLITE_STATIC);
+  sqlite3_bind_text(stmt, 2, t.department.c_str(), static_cast<int>(t.department.size()), SQLITE_STATIC);
+  sqlite3_bind_text(stmt, 3, t.category.c_str(), static_cast<int>(t.category.size()), SQLITE_STATIC);
+  sqlite3_bind_text(stmt, 4, t.vendor.c_str(), static_cast<int>(t.vendor.size()), SQLITE_STATIC);
+  sqlite3_bind_double(stmt, 5, t.amount);
+  sqlite3_bind_text(stmt, 6, t.status.c_str(), static_cast<int>(t.status.size()), SQLITE_STATIC);
+  sqlite3_bind_text(stmt, 7, t.source_system.c_str(), static_cast<int>(t.source_system.size()), SQLITE_STATIC);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// bind_financial_record - parameters of SQL_INSERT_FINANCIAL_RECORD
+// strings are bound SQLITE_STATIC, the record must outlive the sqlite3_step
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void finmart_db::bind_financial_record(sqlite3_stmt* stmt, const FinancialRecord& record)
+{
+  sqlite3_bind_text(stmt, 1, record.period.c_str(), static_cast<int>(record.period.size()), SQLITE_STATIC);
+  sqlite3_bind_text(stmt, 2, record.company_id.c_str(), static_cast<int>(record.company_id.size()), SQLITE_STATIC);
   sqlite3_bind_double(stmt, 3, record.revenue);
   sqlite3_bind_double(stmt, 4, record.cogs);
   sqlite3_bind_double(stmt, 5, record.operating_expenses);
@@ -443,10 +1452,4 @@ int finmart_db::insert_financial_record(const FinancialRecord& record)
   sqlite3_bind_double(stmt, 12, record.inventory);
   sqlite3_bind_double(stmt, 13, record.total_assets);
   sqlite3_bind_double(stmt, 14, record.total_liabilities);
-
-  int rc = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
-
-  return (rc == SQLITE_DONE) ? 0 : -1;
 }
-
@@ -5,27 +5,112 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <sstream>
 #include <ctime>
 #include <cstring>
 #include <sqlite3.h>
 #include <iomanip>
 #include <algorithm>
+#include <functional>
+#include <fstream>
+#include <cstdlib>
 
 #include "finmart.h"
 #include "metrics.hh"
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// cached_stmt
+// statement borrowed from the finmart_db cache for the length of a query
+// reset and cleared on scope exit so the next user starts from a fresh state and the
+// connection does not keep a read transaction open
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class cached_stmt
+{
+public:
+  cached_stmt(sqlite3_stmt* stmt) : stmt(stmt) {}
+  ~cached_stmt()
+  {
+    if (stmt)
+    {
+      sqlite3_reset(stmt);
+      sqlite3_clear_bindings(stmt);
+    }
+  }
+  operator sqlite3_stmt*() const { return stmt; }
+
+private:
+  cached_stmt(const cached_stmt&) = delete;
+  cached_stmt& operator=(const cached_stmt&) = delete;
+  sqlite3_stmt* stmt;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// sqlite_profile_t
+// connection settings applied by finmart_db at open
+// the defaults let dashboard readers run while an ETL load writes (WAL) and read pages through
+// a memory map instead of read() calls; an empty string, a negative mmap_size or busy_timeout and
+// a cache_size of 0 keep the SQLite default
+// load() overrides the defaults with the SQLITE_* keys of a config.json file:
+//   "SQLITE_JOURNAL_MODE": "WAL",      DELETE, TRUNCATE, PERSIST, MEMORY, WAL, OFF
+//   "SQLITE_SYNCHRONOUS": "NORMAL",    OFF, NORMAL, FULL, EXTRA
+//   "SQLITE_MMAP_SIZE": "268435456",   bytes, 0 disables memory mapped I/O
+//   "SQLITE_CACHE_SIZE": "-65536",     pages, or KiB when negative
+//   "SQLITE_TEMP_STORE": "MEMORY",     DEFAULT, FILE, MEMORY
+//   "SQLITE_BUSY_TIMEOUT": "5000"      milliseconds a connection waits on a lock
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct sqlite_profile_t
+{
+  std::string journal_mode = "WAL";
+  std::string synchronous = "NORMAL";
+  long long mmap_size = 256LL * 1024 * 1024;
+  long long cache_size = -64 * 1024;
+  std::string temp_store = "MEMORY";
+  int busy_timeout = 5000;
+
+  static sqlite_profile_t load(const std::string& config_file);
+};
+
+// process-wide profile, loaded once from config.json in the working directory
+const sqlite_profile_t& default_sqlite_profile();
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // database manager
+// query methods take their statements from a per-connection cache keyed by SQL text;
+// each statement is prepared once and reused with sqlite3_reset / sqlite3_clear_bindings
+// reference data (departments, companies) is copied into an in-memory database attached as
+// "ref" and read from there; it is reloaded on the next read after the database changed, so a
+// page that only reads it does no disk I/O. FinMartSnapshot takes its lists from here when it
+// loads, at startup and after each ETL publish
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 class finmart_db
 {
 private:
   sqlite3* db;
+  std::unordered_map<std::string, sqlite3_stmt*> stmt_cache;
+  long long reference_version; // data_version and total changes at the last refresh_reference_data
+  long long reference_changes;
+  bool bulk_load; // insert_transactions maintains the summaries itself, see set_bulk_load
+
+  sqlite3_stmt* prepare(const char* sql);
+  void apply_profile(const sqlite_profile_t& profile);
+  int migrate_schema();
+  int record_migration(const schema_migration_t& migration, double seconds);
+  int read_summary(const char* sql, summary_map_t& summary);
+  long long data_version();
+  std::vector<std::string> read_reference(const char* sql);
+  int insert_batch(const char* sql, size_t nbr_rows, const std::function<void(sqlite3_stmt*, size_t)>& bind,
+    const std::function<int(size_t, size_t)>& summarize = nullptr);
+  int add_to_summaries(const std::vector<transaction>& transactions, size_t first, size_t end);
+  int add_summary(const char* sql, const summary_map_t& groups);
+  static void bind_transaction(sqlite3_stmt* stmt, const transaction& t);
+  static void bind_financial_record(sqlite3_stmt* stmt, const FinancialRecord& record);
 
 public:
-  finmart_db(const std::string& db_path);
+  finmart_db(const std::string& db_path, bool initialize = true, const sqlite_profile_t& profile = default_sqlite_profile());
   ~finmart_db();
   void initialize_database();
   void populate_sample_data();
@@ -34,7 +119,18 @@ public:
   std::map<std::string, double> get_department_spending();
   std::map<std::string, int> get_source_system_counts();
   double get_total_spending();
+  std::map<std::string, double> get_daily_spending(const std::string& date_from, const std::string& date_to);
+  int check_summaries(std::vector<std::string>& mismatches);
+  int rebuild_summaries();
+  void set_bulk_load(bool enable);
+  int restore_from(const std::string& source_path);
+  int refresh_reference_data();
+  std::vector<std::string> get_departments();
+  std::vector<std::string> get_companies();
   bool is_open() const;
+  void clear_statement_cache();
+  int get_schema_version();
+  static int latest_schema_version();
 
   /////////////////////////////////////////////////////////////////////////////////////////////////////
   // financial records
@@ -43,6 +139,17 @@ public:
   std::vector<FinancialRecord> get_financial_records();
   std::vector<FinancialRecord> get_financial_records_by_company(const std::string& company_id);
   int insert_financial_record(const FinancialRecord& record);
+  int insert_financial_records(const std::vector<FinancialRecord>& records);
+  int insert_transactions(const std::vector<transaction>& transactions);
+  transaction_page get_transactions_page(const transaction_filter& filter, const transaction_cursor& after, size_t page_size);
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // row visitors (see IFinMartDatabase), text columns are views of sqlite3_column_text
+  // visit must not run the same query on this connection, the statement is in use
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  int for_each_transaction(const transaction_filter& filter, const std::function<bool(const transaction_view&)>& visit);
+  int for_each_financial_record(const std::function<bool(const financial_record_view&)>& visit);
 };
 
 #endif
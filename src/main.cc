@@ -1,6 +1,9 @@
 #include <Wt/WApplication.h>
 #include <Wt/WServer.h>
 #include "app.hh"
+#include "db_pool.hh"
+#include "snapshot.hh"
+#include <iostream>
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // create_application
@@ -23,7 +26,28 @@ int main(int argc, char** argv)
 
     server.addEntryPoint(Wt::EntryPointType::Application, create_application);
 
+    // schema creation and sample data run once here, sessions borrow open connections
+    if (finmart_pool().initialize() < 0)
+    {
+      std::cerr << "FinMart database not available, views will retry on load" << std::endl;
+    }
+    else
+    {
+      // dashboards read the in-memory snapshot, "Run ETL" in the data view reloads it
+      DatabasePool::Lease db = finmart_pool().acquire();
+      if (refresh_finmart_snapshot(db.get()) < 0)
+      {
+        std::cerr << "FinMart snapshot not loaded, views will read the database" << std::endl;
+      }
+    }
+
     server.run();
+
+    pool_stats_t stats = finmart_pool().stats();
+    std::cout << "database pool: " << stats.acquires << " acquires, " << stats.waits << " waited, wait "
+      << (stats.acquires ? 1000.0 * stats.wait_seconds / stats.acquires : 0.0) << " ms mean, "
+      << 1000.0 * stats.max_wait_seconds << " ms max; " << stats.opened << " opened, "
+      << stats.evicted << " evicted, " << stats.invalid << " invalid" << std::endl;
   }
   catch (Wt::WServer::Exception& e)
   {
@@ -1,15 +1,21 @@
 #include "manager.hh"
 #include "ssl_read.hh"
+#include "json_writer.hh"
+#include "metrics_schema.hh"
+#include "columnar.hh"
+#include "snapshot.hh"
+#include "lite.hh"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <mutex>
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // DataManager
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-DataManager::DataManager() : db_(nullptr)
+DataManager::DataManager() : pool_(nullptr)
 {
   session_.authenticated = false;
 }
@@ -30,8 +36,34 @@ DataManager::~DataManager()
 int DataManager::connect_db(DatabaseBackend backend, const std::string& connection_string)
 {
   disconnect_db();
-  db_.reset(DatabaseFactory::create(backend, connection_string));
-  return (db_ && db_->is_open()) ? 0 : -1;
+  pool_options_t options;
+  options.min_size = 1;
+  options.max_size = 1;
+  std::unique_ptr<DatabasePool> pool(new DatabasePool(backend, connection_string, options));
+  if (pool->initialize() < 0)
+  {
+    return -1;
+  }
+  own_pool_ = std::move(pool);
+  pool_ = own_pool_.get();
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// connect_pool
+// borrow connections from pool, e.g. finmart_pool() shared with the views; pool must outlive
+// the manager or the next connect/disconnect call
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int DataManager::connect_pool(DatabasePool& pool)
+{
+  disconnect_db();
+  if (pool.initialize() < 0)
+  {
+    return -1;
+  }
+  pool_ = &pool;
+  return 0;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -43,6 +75,140 @@ int DataManager::connect_sqlite(const std::string& db_path)
   return connect_db(DatabaseBackend::SQLITE, db_path);
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// connect_staging
+// the copy is made before the staging connection runs schema checks, so that it starts from the
+// published content and not from sample data
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int DataManager::connect_staging(const std::string& staging_path, const std::string& replica_path)
+{
+  disconnect_db();
+  {
+    finmart_db replica(replica_path, false);
+    finmart_db staging(staging_path, false);
+    if (!replica.is_open() || staging.restore_from(replica_path) < 0)
+    {
+      return -1;
+    }
+  }
+  if (connect_sqlite(staging_path) < 0)
+  {
+    return -1;
+  }
+  staging_path_ = staging_path;
+  replica_path_ = replica_path;
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// publish_staging
+// readers of the replica are not blocked while it is written (WAL), they see the new content
+// from their next query; -1 if not connected with connect_staging or the copy failed, the
+// replica then keeps its content
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int DataManager::publish_staging()
+{
+  if (staging_path_.empty() || !pool_)
+  {
+    return -1;
+  }
+  {
+    finmart_db replica(replica_path_, false);
+    if (!replica.is_open() || replica.restore_from(staging_path_) < 0)
+    {
+      return -1;
+    }
+  }
+  return refresh_snapshot();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// etl_mutex
+// one per database (connection string) for the life of the process: run_etl holds it from the
+// staging copy to the export, a second run on the same database waits and then stages the
+// published result of the first
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::mutex& etl_mutex(const std::string& connection_string)
+{
+  static std::mutex mutex;
+  static std::map<std::string, std::mutex> mutexes;
+  std::lock_guard<std::mutex> lock(mutex);
+  return mutexes[connection_string];
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// run_etl
+// SQLite: the load writes a staging copy of the pool's database, which must pass
+// check_summaries before it is published over the original; the pool's readers never see a
+// partial load and a failed one changes nothing. SQL Server: the load writes through the pool.
+// finmart_snapshot() is reloaded and the columnar export rewritten in both cases; a failed
+// export is logged, the load is published anyway. load may be empty
+// runs on the same database are serialized (etl_mutex), the UI starts them from any session
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int DataManager::run_etl(DatabasePool& pool, const std::function<int(IFinMartDatabase*)>& load)
+{
+  std::lock_guard<std::mutex> lock(etl_mutex(pool.get_connection_string()));
+  if (pool.get_backend() != DatabaseBackend::SQLITE)
+  {
+    if (connect_pool(pool) < 0)
+    {
+      return -1;
+    }
+    {
+      DatabasePool::Lease db = acquire_db();
+      if (!db || (load && load(db.get()) < 0))
+      {
+        return -1;
+      }
+    }
+    if (refresh_snapshot() < 0)
+    {
+      return -1;
+    }
+    if (export_columnar("finmart.") < 0)
+    {
+      std::cerr << "ETL columnar export failed" << std::endl;
+    }
+    return 0;
+  }
+
+  // the pool creates the schema of the replica, the staging copy then only reads it
+  const std::string& replica_path = pool.get_connection_string();
+  if (pool.initialize() < 0 || connect_staging(replica_path + ".staging", replica_path) < 0)
+  {
+    return -1;
+  }
+  {
+    DatabasePool::Lease db = acquire_db();
+    if (!db || (load && load(db.get()) < 0))
+    {
+      return -1;
+    }
+    std::vector<std::string> mismatches;
+    if (db->check_summaries(mismatches) != 0)
+    {
+      for (size_t idx = 0; idx < mismatches.size(); idx++)
+      {
+        std::cerr << "ETL not published: " << mismatches[idx] << std::endl;
+      }
+      return -1;
+    }
+  }
+  if (publish_staging() < 0)
+  {
+    return -1;
+  }
+  if (export_columnar(replica_path + ".") < 0)
+  {
+    std::cerr << "ETL columnar export failed" << std::endl;
+  }
+  return 0;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // connect_sqlserver
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -72,10 +238,35 @@ int DataManager::connect_sqlserver(const std::string& server, const std::string&
 
 int DataManager::disconnect_db()
 {
-  db_.reset();
+  pool_ = nullptr;
+  own_pool_.reset();
+  staging_path_.clear();
+  replica_path_.clear();
   return 0;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// acquire_db - empty Lease when not connected
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DatabasePool::Lease DataManager::acquire_db()
+{
+  return pool_ ? pool_->acquire() : DatabasePool::Lease();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_db_backend_name
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string DataManager::get_db_backend_name() const
+{
+  if (!pool_)
+  {
+    return "None";
+  }
+  return pool_->get_backend() == DatabaseBackend::SQLSERVER ? "SQL Server" : "SQLite";
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // connect_mstr
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -126,11 +317,12 @@ int DataManager::set_project(const std::string& project_id)
 
 std::vector<transaction> DataManager::fetch_transactions()
 {
-  if (!is_db_connected())
+  DatabasePool::Lease db = acquire_db();
+  if (!db)
   {
     return std::vector<transaction>();
   }
-  return db_->get_all_transactions();
+  return db->get_all_transactions();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -139,11 +331,12 @@ std::vector<transaction> DataManager::fetch_transactions()
 
 std::map<std::string, double> DataManager::fetch_department_spending()
 {
-  if (!is_db_connected())
+  DatabasePool::Lease db = acquire_db();
+  if (!db)
   {
     return std::map<std::string, double>();
   }
-  return db_->get_department_spending();
+  return db->get_department_spending();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -152,11 +345,12 @@ std::map<std::string, double> DataManager::fetch_department_spending()
 
 std::map<std::string, int> DataManager::fetch_source_system_counts()
 {
-  if (!is_db_connected())
+  DatabasePool::Lease db = acquire_db();
+  if (!db)
   {
     return std::map<std::string, int>();
   }
-  return db_->get_source_system_counts();
+  return db->get_source_system_counts();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -165,11 +359,26 @@ std::map<std::string, int> DataManager::fetch_source_system_counts()
 
 double DataManager::fetch_total_spending()
 {
-  if (!is_db_connected())
+  DatabasePool::Lease db = acquire_db();
+  if (!db)
   {
     return 0.0;
   }
-  return db_->get_total_spending();
+  return db->get_total_spending();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// refresh_snapshot
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int DataManager::refresh_snapshot()
+{
+  DatabasePool::Lease db = acquire_db();
+  if (!db)
+  {
+    return -1;
+  }
+  return refresh_finmart_snapshot(db.get());
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -296,31 +505,24 @@ void DataManager::build_auth_headers(std::stringstream& http, const std::string&
 std::string DataManager::dataset_definition_json(const std::string& name,
   const std::string& description)
 {
-  std::stringstream json;
-  json << "{\n";
-  json << "  \"name\": \"" << name << "\",\n";
-  json << "  \"description\": \"" << description << "\",\n";
-  json << "  \"tables\": [{\n";
-  json << "    \"name\": \"FinancialMetrics\",\n";
-  json << "    \"columnHeaders\": [\n";
-  json << "      {\"name\": \"Period\", \"dataType\": \"STRING\"},\n";
-  json << "      {\"name\": \"CompanyID\", \"dataType\": \"STRING\"},\n";
-  json << "      {\"name\": \"Revenue\", \"dataType\": \"DOUBLE\"},\n";
-  json << "      {\"name\": \"GrossProfit\", \"dataType\": \"DOUBLE\"},\n";
-  json << "      {\"name\": \"GrossMargin\", \"dataType\": \"DOUBLE\"},\n";
-  json << "      {\"name\": \"EBITDA\", \"dataType\": \"DOUBLE\"},\n";
-  json << "      {\"name\": \"EBIT\", \"dataType\": \"DOUBLE\"},\n";
-  json << "      {\"name\": \"NetIncome\", \"dataType\": \"DOUBLE\"},\n";
-  json << "      {\"name\": \"NetMargin\", \"dataType\": \"DOUBLE\"},\n";
-  json << "      {\"name\": \"WorkingCapital\", \"dataType\": \"DOUBLE\"},\n";
-  json << "      {\"name\": \"CurrentRatio\", \"dataType\": \"DOUBLE\"},\n";
-  json << "      {\"name\": \"QuickRatio\", \"dataType\": \"DOUBLE\"},\n";
-  json << "      {\"name\": \"DebtToEquity\", \"dataType\": \"DOUBLE\"},\n";
-  json << "      {\"name\": \"ROA\", \"dataType\": \"DOUBLE\"},\n";
-  json << "      {\"name\": \"ROE\", \"dataType\": \"DOUBLE\"}\n";
-  json << "    ]\n";
-  json << "  }]\n";
-  json << "}";
+  json_writer json(1024);
+  json.begin_object();
+  json.key("name");
+  json.value_string(name);
+  json.key("description");
+  json.value_string(description);
+  json.key("tables");
+  json.begin_array();
+  json.begin_object();
+  json.key("name");
+  json.value_string("FinancialMetrics");
+  json.key("columnHeaders");
+  json.begin_array();
+  write_metrics_columns(json);
+  json.end_array();
+  json.end_object();
+  json.end_array();
+  json.end_object();
   return json.str();
 }
 
@@ -330,105 +532,278 @@ std::string DataManager::dataset_definition_json(const std::string& name,
 
 std::string DataManager::dataset_data_json(const std::vector<FinancialMetrics>& metrics)
 {
-  std::stringstream json;
-  json << std::fixed << std::setprecision(4);
-  json << "{\n";
-  json << "  \"data\": [\n";
+  json_writer json(64 + metrics.size() * 256);
+  json.begin_object();
+  json.key("data");
+  json.begin_array();
 
   for (size_t idx = 0; idx < metrics.size(); ++idx)
   {
-    const FinancialMetrics& m = metrics[idx];
-    json << "    [\"" << m.period << "\", \"" << m.company_id << "\", "
-         << m.revenue << ", " << m.gross_profit() << ", " << m.gross_margin() << ", "
-         << m.ebitda() << ", " << m.ebit() << ", " << m.net_income() << ", "
-         << m.net_margin() << ", " << m.working_capital() << ", "
-         << m.current_ratio() << ", " << m.quick_ratio() << ", "
-         << m.debt_to_equity() << ", " << m.return_on_assets() << ", "
-         << m.return_on_equity() << "]";
-    if (idx < metrics.size() - 1) json << ",";
-    json << "\n";
+    write_metrics_row(json, metrics[idx]);
   }
 
-  json << "  ]\n";
-  json << "}";
+  json.end_array();
+  json.end_object();
   return json.str();
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// DatasetDataStream
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DatasetDataStream::DatasetDataStream(const std::vector<FinancialMetrics>& metrics, size_t block_size) :
+  metrics_(metrics),
+  block_size_(block_size),
+  row_(0),
+  started_(false),
+  finished_(false),
+  json_(block_size + 1024)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// DatasetDataStream::next
+// formats rows until the block is full; the last block closes the document
+// returns false once the whole payload has been produced
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DatasetDataStream::next(const char*& data, size_t& size)
+{
+  if (finished_)
+  {
+    return false;
+  }
+
+  json_.drain();
+
+  if (!started_)
+  {
+    json_.begin_object();
+    json_.key("data");
+    json_.begin_array();
+    started_ = true;
+  }
+
+  while (row_ < metrics_.size() && json_.size() < block_size_)
+  {
+    write_metrics_row(json_, metrics_[row_]);
+    row_++;
+  }
+
+  if (row_ == metrics_.size())
+  {
+    json_.end_array();
+    json_.end_object();
+    finished_ = true;
+  }
+
+  data = json_.data();
+  size = json_.size();
+  return true;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // metrics_to_json
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 std::string DataManager::metrics_to_json(const std::vector<FinancialMetrics>& metrics)
 {
-  std::stringstream json;
-  json << std::fixed << std::setprecision(4);
-  json << "{\n";
-  json << "  \"metrics\": [\n";
+  json_writer json(64 + metrics.size() * 512);
+  json.begin_object();
+  json.key("metrics");
+  json.begin_array();
 
   for (size_t idx = 0; idx < metrics.size(); ++idx)
   {
-    const FinancialMetrics& m = metrics[idx];
-    json << "    {\n";
-    json << "      \"period\": \"" << m.period << "\",\n";
-    json << "      \"company_id\": \"" << m.company_id << "\",\n";
-    json << "      \"revenue\": " << m.revenue << ",\n";
-    json << "      \"gross_profit\": " << m.gross_profit() << ",\n";
-    json << "      \"gross_margin\": " << m.gross_margin() << ",\n";
-    json << "      \"ebitda\": " << m.ebitda() << ",\n";
-    json << "      \"ebit\": " << m.ebit() << ",\n";
-    json << "      \"net_income\": " << m.net_income() << ",\n";
-    json << "      \"net_margin\": " << m.net_margin() << ",\n";
-    json << "      \"operating_margin\": " << m.operating_margin() << ",\n";
-    json << "      \"working_capital\": " << m.working_capital() << ",\n";
-    json << "      \"current_ratio\": " << m.current_ratio() << ",\n";
-    json << "      \"quick_ratio\": " << m.quick_ratio() << ",\n";
-    json << "      \"debt_to_equity\": " << m.debt_to_equity() << ",\n";
-    json << "      \"debt_ratio\": " << m.debt_ratio() << ",\n";
-    json << "      \"roa\": " << m.return_on_assets() << ",\n";
-    json << "      \"roe\": " << m.return_on_equity() << "\n";
-    json << "    }";
-    if (idx < metrics.size() - 1) json << ",";
-    json << "\n";
-  }
-
-  json << "  ]\n";
-  json << "}";
+    write_metrics_object(json, metrics[idx]);
+  }
+
+  json.end_array();
+  json.end_object();
   return json.str();
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// write_transaction - one element of the "transactions" array
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void write_transaction(json_writer& json, const transaction_view& t)
+{
+  json.begin_object();
+  json.key("id");
+  json.value_int(t.id);
+  json.key("date");
+  json.value_string(t.date);
+  json.key("department");
+  json.value_string(t.department);
+  json.key("category");
+  json.value_string(t.category);
+  json.key("vendor");
+  json.value_string(t.vendor);
+  json.key("amount");
+  json.value_double(t.amount, 2);
+  json.key("status");
+  json.value_string(t.status);
+  json.key("source_system");
+  json.value_string(t.source_system);
+  json.end_object();
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // transactions_to_json
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 std::string DataManager::transactions_to_json(const std::vector<transaction>& transactions)
 {
-  std::stringstream json;
-  json << std::fixed << std::setprecision(2);
-  json << "{\n";
-  json << "  \"transactions\": [\n";
+  json_writer json(64 + transactions.size() * 192);
+  json.begin_object();
+  json.key("transactions");
+  json.begin_array();
 
   for (size_t idx = 0; idx < transactions.size(); ++idx)
   {
-    const transaction& t = transactions[idx];
-    json << "    {\n";
-    json << "      \"id\": " << t.id << ",\n";
-    json << "      \"date\": \"" << t.date << "\",\n";
-    json << "      \"department\": \"" << t.department << "\",\n";
-    json << "      \"category\": \"" << t.category << "\",\n";
-    json << "      \"vendor\": \"" << t.vendor << "\",\n";
-    json << "      \"amount\": " << t.amount << ",\n";
-    json << "      \"status\": \"" << t.status << "\",\n";
-    json << "      \"source_system\": \"" << t.source_system << "\"\n";
-    json << "    }";
-    if (idx < transactions.size() - 1) json << ",";
-    json << "\n";
-  }
-
-  json << "  ]\n";
-  json << "}";
+    write_transaction(json, transactions[idx]);
+  }
+
+  json.end_array();
+  json.end_object();
   return json.str();
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// write_transactions_json
+// same document as transactions_to_json for the transactions matching filter, streamed from
+// for_each_transaction to out in blocks of about block_size bytes; memory use does not depend
+// on the number of rows
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int DataManager::write_transactions_json(std::ostream& out, const transaction_filter& filter, size_t block_size)
+{
+  DatabasePool::Lease db = acquire_db();
+  if (!db)
+  {
+    return -1;
+  }
+
+  json_writer json(block_size + 1024);
+  json.begin_object();
+  json.key("transactions");
+  json.begin_array();
+
+  int ret = db->for_each_transaction(filter, [&json, &out, block_size](const transaction_view& t)
+    {
+      write_transaction(json, t);
+      if (json.size() >= block_size)
+      {
+        out.write(json.data(), json.size());
+        json.drain();
+      }
+      return out.good();
+    });
+
+  json.end_array();
+  json.end_object();
+  out.write(json.data(), json.size());
+  return (ret == 0 && out.good()) ? 0 : -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// metrics_to_columnar
+// one column per field table entry, named by its JSON key
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int DataManager::metrics_to_columnar(const std::vector<FinancialMetrics>& metrics, const std::string& path)
+{
+  columnar_writer writer(metrics.size());
+  for_each_metrics_field([&writer, &metrics](const auto& field)
+    {
+      if constexpr (std::is_same<metrics_field_type<std::decay_t<decltype(field)>>, std::string>::value)
+      {
+        std::vector<std::string_view> values(metrics.size());
+        for (size_t idx = 0; idx < metrics.size(); ++idx)
+        {
+          values[idx] = std::invoke(field.accessor, metrics[idx]);
+        }
+        writer.add_string(field.key, values);
+      }
+      else
+      {
+        std::vector<double> values(metrics.size());
+        for (size_t idx = 0; idx < metrics.size(); ++idx)
+        {
+          values[idx] = std::invoke(field.accessor, metrics[idx]);
+        }
+        writer.add_double(field.key, values);
+      }
+    });
+  return writer.write(path);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// transactions_to_columnar
+// same column names as transactions_to_json
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int DataManager::transactions_to_columnar(const std::vector<transaction>& transactions, const std::string& path)
+{
+  size_t nbr_rows = transactions.size();
+  columnar_writer writer(nbr_rows);
+
+  std::vector<int32_t> ids(nbr_rows);
+  std::vector<double> amounts(nbr_rows);
+  for (size_t idx = 0; idx < nbr_rows; ++idx)
+  {
+    ids[idx] = transactions[idx].id;
+    amounts[idx] = transactions[idx].amount;
+  }
+
+  auto add_string = [&writer, &transactions, nbr_rows](const char* name, std::string transaction::* member)
+  {
+    std::vector<std::string_view> values(nbr_rows);
+    for (size_t idx = 0; idx < nbr_rows; ++idx)
+    {
+      values[idx] = transactions[idx].*member;
+    }
+    writer.add_string(name, values);
+  };
+
+  writer.add_int32("id", ids);
+  add_string("date", &transaction::date);
+  add_string("department", &transaction::department);
+  add_string("category", &transaction::category);
+  add_string("vendor", &transaction::vendor);
+  writer.add_double("amount", amounts);
+  add_string("status", &transaction::status);
+  add_string("source_system", &transaction::source_system);
+  return writer.write(path);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// export_columnar
+// each file is written under a temporary name and renamed (columnar_writer), consumers that map
+// it meanwhile keep the previous one
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int DataManager::export_columnar(const std::string& prefix)
+{
+  std::vector<transaction> transactions;
+  std::vector<FinancialRecord> records;
+  {
+    DatabasePool::Lease db = acquire_db();
+    if (!db)
+    {
+      return -1;
+    }
+    transactions = db->get_all_transactions();
+    records = db->get_financial_records();
+  }
+  if (transactions_to_columnar(transactions, prefix + "transactions.col") < 0)
+  {
+    return -1;
+  }
+  return metrics_to_columnar(calculate_metrics(records), prefix + "metrics.col");
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // create_dataset
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -465,10 +840,9 @@ int DataManager::push_to_dataset(const std::string& dataset_id,
     return -1;
   }
 
-  std::string json_data = dataset_data_json(metrics);
   std::string response;
   if (upload_data(session_, dataset_id, upload_id, "FinancialMetrics",
-    json_data, response) != 0)
+    metrics, response) != 0)
   {
     return -1;
   }
@@ -649,6 +1023,64 @@ int upload_data(const Session& session, const std::string& dataset_id,
   return ssl_read(host, port_num, http.str(), response, headers);
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// upload_data
+// streaming version: rows are serialized by DatasetDataStream while the request is sent
+// with chunked transfer encoding, the payload is never held in memory as a whole
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int upload_data(const Session& session, const std::string& dataset_id,
+  const std::string& upload_id, const std::string& table_name,
+  const std::vector<FinancialMetrics>& metrics, std::string& response)
+{
+  std::string host = session.base_url;
+  std::string path = "/api/datasets/" + dataset_id + "/uploadSessions/" + upload_id +
+    "?tableName=" + table_name;
+
+  size_t pos = host.find("://");
+  if (pos != std::string::npos)
+  {
+    host = host.substr(pos + 3);
+  }
+
+  pos = host.find("/");
+  if (pos != std::string::npos)
+  {
+    std::string base_path = host.substr(pos);
+    host = host.substr(0, pos);
+    path = base_path + "/api/datasets/" + dataset_id + "/uploadSessions/" + upload_id +
+      "?tableName=" + table_name;
+  }
+
+  const std::string port_num = "443";
+
+  std::stringstream http;
+  http << "PUT " << path << " HTTP/1.1\r\n";
+  http << "Host: " << host << "\r\n";
+  http << "Accept: application/json\r\n";
+  http << "Content-Type: application/json\r\n";
+  http << "X-MSTR-AuthToken: " << session.auth_token << "\r\n";
+  if (!session.project_id.empty())
+  {
+    http << "X-MSTR-ProjectID: " << session.project_id << "\r\n";
+  }
+  if (!session.cookies.empty())
+  {
+    http << "Cookie: " << session.cookies << "\r\n";
+  }
+  http << "Transfer-Encoding: chunked\r\n";
+  http << "Connection: close\r\n\r\n";
+
+  DatasetDataStream stream(metrics);
+  body_producer_t producer = [&stream](const char*& data, size_t& size)
+    {
+      return stream.next(data, size);
+    };
+
+  std::vector<std::string> headers;
+  return ssl_read_chunked(host, port_num, http.str(), producer, response, headers);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // publish_dataset
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -2,9 +2,11 @@
 #define MANAGER_HH
 
 #include "db_interface.hh"
+#include "db_pool.hh"
 #include "api.hh"
 #include "get.hh"
 #include "metrics.hh"
+#include "json_writer.hh"
 #include <string>
 #include <vector>
 #include <map>
@@ -15,18 +17,23 @@
 // DataManager
 //
 // Central manager class for the ETL pipeline that coordinates:
-//   - Database connections (SQLite and SQL Server backends)
+//   - Database connections (SQLite and SQL Server backends), borrowed from a DatabasePool per
+//     call: its own single connection pool (connect_db), or one shared with the views
+//     (connect_pool(finmart_pool()))
 //   - MicroStrategy REST API integration
 //   - Financial metrics calculation and transformation
 //   - Data serialization to JSON format
 //
 // Usage:
 //   DataManager manager;
-//   manager.connect_sqlite("finmart.db");
+//   manager.connect_sqlite("finmart.db");   or connect_staging("finmart.staging.db", "finmart.db")
 //   manager.connect_mstr("https://mstr.example.com", "user", "pass");
 //   manager.set_project("PROJECT_ID");
 //   std::vector<FinancialMetrics> metrics = manager.calculate_metrics(records);
 //   manager.push_to_dataset(dataset_id, metrics);
+//   manager.publish_staging();              after a staged load
+//
+//   or, for the views: manager.run_etl(finmart_pool(), load)
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -41,7 +48,23 @@ public:
   /////////////////////////////////////////////////////////////////////////////////////////////////////
 
   int connect_db(DatabaseBackend backend, const std::string& connection_string);
+  int connect_pool(DatabasePool& pool);
   int connect_sqlite(const std::string& db_path);
+
+  // staged ETL (SQLite): connect_staging copies replica_path, the database the views read, into
+  // staging_path and connects to the copy; loads write there without blocking or slowing readers,
+  // publish_staging copies the result back over replica_path in one transaction and reloads
+  // finmart_snapshot(). One staged ETL at a time per replica, its changes made meanwhile by others
+  // are overwritten; run_etl enforces this, callers of these two directly must serialize
+  int connect_staging(const std::string& staging_path, const std::string& replica_path);
+  int publish_staging();
+
+  // run_etl: the ETL entry point of the views; runs load on a connection of the database behind
+  // pool, staged (connect_staging, publish_staging, staging file <database>.staging) with SQLite,
+  // through the pool (connect_pool) with SQL Server, reloads finmart_snapshot() and writes the
+  // columnar export (export_columnar, prefix <database>. with SQLite, finmart. with SQL Server);
+  // runs on the same database wait for each other; 0 on success
+  int run_etl(DatabasePool& pool, const std::function<int(IFinMartDatabase*)>& load);
   int connect_sqlserver(const std::string& server, const std::string& database,
     const std::string& user = "", const std::string& password = "");
   int disconnect_db();
@@ -67,6 +90,10 @@ public:
   std::map<std::string, int> fetch_source_system_counts();
   double fetch_total_spending();
 
+  // refresh_snapshot: reloads finmart_snapshot() (see snapshot.hh) from this connection, to be
+  // called after an ETL load; 0 on success
+  int refresh_snapshot();
+
   /////////////////////////////////////////////////////////////////////////////////////////////////////
   // Metrics calculation methods
   /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -92,25 +119,72 @@ public:
   std::string dataset_definition_json(const std::string& name, const std::string& description);
   std::string dataset_data_json(const std::vector<FinancialMetrics>& metrics);
   std::string transactions_to_json(const std::vector<transaction>& transactions);
+  int write_transactions_json(std::ostream& out, const transaction_filter& filter = transaction_filter(),
+    size_t block_size = 64 * 1024);
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Columnar export (see columnar.hh), memory-mapped by local consumers
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  int metrics_to_columnar(const std::vector<FinancialMetrics>& metrics, const std::string& path);
+  int transactions_to_columnar(const std::vector<transaction>& transactions, const std::string& path);
+
+  // export_columnar: <prefix>transactions.col and <prefix>metrics.col (metrics of every financial
+  // record) from the connected database; run_etl calls it after each published load
+  int export_columnar(const std::string& prefix);
 
   /////////////////////////////////////////////////////////////////////////////////////////////////////
   // Accessor methods
   /////////////////////////////////////////////////////////////////////////////////////////////////////
 
   const Session& get_session() const { return session_; }
-  bool is_db_connected() const { return db_ != nullptr && db_->is_open(); }
+  bool is_db_connected() const { return pool_ != nullptr; }
   bool is_mstr_connected() const { return session_.authenticated; }
-  DatabaseBackend get_db_backend() const { return db_ ? db_->get_backend() : DatabaseBackend::SQLITE; }
-  std::string get_db_backend_name() const { return db_ ? db_->get_backend_name() : "None"; }
+  DatabaseBackend get_db_backend() const { return pool_ ? pool_->get_backend() : DatabaseBackend::SQLITE; }
+  std::string get_db_backend_name() const;
 
 private:
-  std::unique_ptr<IFinMartDatabase> db_;
+  std::unique_ptr<DatabasePool> own_pool_;
+  DatabasePool* pool_;
+  std::string staging_path_;
+  std::string replica_path_;
+  DatabasePool::Lease acquire_db();
   Session session_;
 
   void parse_url(const std::string& url, std::string& host, std::string& path);
   void build_auth_headers(std::stringstream& http, const std::string& host);
 };
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// DatasetDataStream
+//
+// Produces the dataset_data_json() payload in blocks of about block_size bytes, formatting rows
+// only when the next block is requested. Used as the body producer of a chunked upload, so the
+// memory needed to send a dataset is one block whatever the number of rows.
+//
+// Usage:
+//   DatasetDataStream stream(metrics);
+//   const char* data;
+//   size_t size;
+//   while (stream.next(data, size)) { write(data, size); }
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class DatasetDataStream
+{
+public:
+  DatasetDataStream(const std::vector<FinancialMetrics>& metrics, size_t block_size = 64 * 1024);
+  bool next(const char*& data, size_t& size);
+
+private:
+  const std::vector<FinancialMetrics>& metrics_;
+  size_t block_size_;
+  size_t row_;
+  bool started_;
+  bool finished_;
+  json_writer json_;
+};
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // MicroStrategy Push API functions
 //
@@ -133,6 +207,10 @@ int upload_data(const Session& session, const std::string& dataset_id,
   const std::string& upload_id, const std::string& table_name,
   const std::string& json_data, std::string& response);
 
+int upload_data(const Session& session, const std::string& dataset_id,
+  const std::string& upload_id, const std::string& table_name,
+  const std::vector<FinancialMetrics>& metrics, std::string& response);
+
 int publish_dataset(const Session& session, const std::string& dataset_id,
   const std::string& upload_id, std::string& response);
 
@@ -2,6 +2,7 @@
 #define METRICS_HH
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cmath>
 
@@ -27,6 +28,37 @@ struct FinancialRecord
   double total_liabilities;
 };
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// financial_record_view
+// FinancialRecord whose text columns point into the database row buffers, passed to
+// IFinMartDatabase::for_each_financial_record; valid only while the row is current
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct financial_record_view
+{
+  std::string_view period;
+  std::string_view company_id;
+  double revenue = 0;
+  double cogs = 0;
+  double operating_expenses = 0;
+  double depreciation = 0;
+  double amortization = 0;
+  double interest = 0;
+  double taxes = 0;
+  double current_assets = 0;
+  double current_liabilities = 0;
+  double inventory = 0;
+  double total_assets = 0;
+  double total_liabilities = 0;
+
+  FinancialRecord to_record() const
+  {
+    return FinancialRecord{ std::string(period), std::string(company_id), revenue, cogs, operating_expenses,
+      depreciation, amortization, interest, taxes, current_assets, current_liabilities, inventory,
+      total_assets, total_liabilities };
+  }
+};
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // FinancialMetrics
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,167 @@
+#ifndef METRICS_SCHEMA_HH
+#define METRICS_SCHEMA_HH
+
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <functional>
+#include "metrics.hh"
+#include "json_writer.hh"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// FinancialMetrics field table
+//
+// Single description of the FinancialMetrics columns exported to MicroStrategy and JSON.
+// Each entry has the dataset column name, the JSON object key and an accessor (data member or
+// const member function). The MicroStrategy dataType is deduced from the accessor return type.
+//
+// The table is a constexpr tuple and the writers below expand it with fold expressions, so
+// each writer compiles to a fixed sequence of json_writer calls with no lookup at run time.
+//
+// To add a column, add one entry here: dataset definition, dataset rows and metrics_to_json
+// objects all follow.
+//
+// published is the MicroStrategy dataset/cube schema: datasets and cubes already published
+// have exactly the published columns below (15), in this order, so an entry added with
+// published = true changes the wire shape and needs a new dataset. Derived values that are
+// not part of it (OperatingMargin, DebtRatio) are published = false: they are written by
+// metrics_to_json and the columnar export only, and computed from the record when read.
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename Accessor>
+struct metrics_field
+{
+  const char* name; // dataset column header
+  const char* key; // metrics_to_json object key
+  Accessor accessor;
+  bool published; // column of the dataset definition and rows
+};
+
+template <typename Accessor>
+constexpr metrics_field<Accessor> make_metrics_field(const char* name, const char* key, Accessor accessor, bool published = true)
+{
+  return metrics_field<Accessor>{ name, key, accessor, published };
+}
+
+inline constexpr auto financial_metrics_fields = std::make_tuple(
+  make_metrics_field("Period", "period", &FinancialMetrics::period),
+  make_metrics_field("CompanyID", "company_id", &FinancialMetrics::company_id),
+  make_metrics_field("Revenue", "revenue", &FinancialMetrics::revenue),
+  make_metrics_field("GrossProfit", "gross_profit", &FinancialMetrics::gross_profit),
+  make_metrics_field("GrossMargin", "gross_margin", &FinancialMetrics::gross_margin),
+  make_metrics_field("EBITDA", "ebitda", &FinancialMetrics::ebitda),
+  make_metrics_field("EBIT", "ebit", &FinancialMetrics::ebit),
+  make_metrics_field("NetIncome", "net_income", &FinancialMetrics::net_income),
+  make_metrics_field("NetMargin", "net_margin", &FinancialMetrics::net_margin),
+  make_metrics_field("OperatingMargin", "operating_margin", &FinancialMetrics::operating_margin, false),
+  make_metrics_field("WorkingCapital", "working_capital", &FinancialMetrics::working_capital),
+  make_metrics_field("CurrentRatio", "current_ratio", &FinancialMetrics::current_ratio),
+  make_metrics_field("QuickRatio", "quick_ratio", &FinancialMetrics::quick_ratio),
+  make_metrics_field("DebtToEquity", "debt_to_equity", &FinancialMetrics::debt_to_equity),
+  make_metrics_field("DebtRatio", "debt_ratio", &FinancialMetrics::debt_ratio, false),
+  make_metrics_field("ROA", "roa", &FinancialMetrics::return_on_assets),
+  make_metrics_field("ROE", "roe", &FinancialMetrics::return_on_equity)
+);
+
+inline constexpr size_t financial_metrics_field_count = std::tuple_size<decltype(financial_metrics_fields)>::value;
+
+// columns of the published dataset definition
+inline constexpr size_t financial_metrics_published_count = std::apply([](const auto&... field)
+  {
+    return (static_cast<size_t>(field.published ? 1 : 0) + ...);
+  }, financial_metrics_fields);
+static_assert(financial_metrics_published_count == 15, "the published dataset schema has 15 columns, a new one needs a new dataset");
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// metrics_field_type - value type returned by a field accessor
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename Field>
+using metrics_field_type = std::decay_t<std::invoke_result_t<decltype(std::declval<Field>().accessor), const FinancialMetrics&>>;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// metrics_data_type - MicroStrategy dataType of a field
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename Field>
+constexpr const char* metrics_data_type()
+{
+  static_assert(std::is_same<metrics_field_type<Field>, std::string>::value ||
+    std::is_same<metrics_field_type<Field>, double>::value, "FinancialMetrics field must be std::string or double");
+  return std::is_same<metrics_field_type<Field>, std::string>::value ? "STRING" : "DOUBLE";
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// write_metrics_value - doubles keep 4 decimals
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void write_metrics_value(json_writer& json, const std::string& value)
+{
+  json.value_string(value);
+}
+
+inline void write_metrics_value(json_writer& json, double value)
+{
+  json.value_double(value, 4);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// for_each_metrics_field - calls fn(field) for every table entry, in order
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename Fn>
+inline void for_each_metrics_field(Fn&& fn)
+{
+  std::apply([&fn](const auto&... field) { (fn(field), ...); }, financial_metrics_fields);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// write_metrics_columns - dataset columnHeaders entries: {"name": ..., "dataType": ...}, published
+// fields only
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void write_metrics_columns(json_writer& json)
+{
+  for_each_metrics_field([&json](const auto& field)
+    {
+      if (!field.published) return;
+      json.begin_object();
+      json.key("name");
+      json.value_string(field.name);
+      json.key("dataType");
+      json.value_string(metrics_data_type<std::decay_t<decltype(field)>>());
+      json.end_object();
+    });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// write_metrics_row - dataset data row, values of the published fields in column order
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void write_metrics_row(json_writer& json, const FinancialMetrics& m)
+{
+  json.begin_array();
+  for_each_metrics_field([&json, &m](const auto& field)
+    {
+      if (!field.published) return;
+      write_metrics_value(json, std::invoke(field.accessor, m));
+    });
+  json.end_array();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// write_metrics_object - one metrics_to_json object
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void write_metrics_object(json_writer& json, const FinancialMetrics& m)
+{
+  json.begin_object();
+  for_each_metrics_field([&json, &m](const auto& field)
+    {
+      json.key(field.key);
+      write_metrics_value(json, std::invoke(field.accessor, m));
+    });
+  json.end_object();
+}
+
+#endif
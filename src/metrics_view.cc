@@ -1,20 +1,13 @@
 #include "metrics_view.hh"
 #include "app.hh"
 #include "db_interface.hh"
+#include "db_executor.hh"
+#include "snapshot.hh"
 #include "metrics.hh"
 #include <Wt/WBreak.h>
 #include <sstream>
 #include <iomanip>
-
-#define USE_SQLSERVER 0
-
-#if USE_SQLSERVER
-const DatabaseBackend METRICS_DB_BACKEND = DatabaseBackend::SQLSERVER;
-const std::string METRICS_DB_CONNECTION = "";
-#else
-const DatabaseBackend METRICS_DB_BACKEND = DatabaseBackend::SQLITE;
-const std::string METRICS_DB_CONNECTION = "finmart.db";
-#endif
+#include <algorithm>
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // WidgetMetrics
@@ -37,10 +30,7 @@ WidgetMetrics::WidgetMetrics(WApplicationStrategy* app)
   toolbar->addWidget(std::make_unique<Wt::WText>(" Company: "));
 
   company_combo = toolbar->addWidget(std::make_unique<Wt::WComboBox>());
-  company_combo->addItem("All Companies");
-  company_combo->addItem("ACME Corp");
-  company_combo->addItem("TechVentures");
-  company_combo->addItem("GlobalTrade");
+  company_combo->addItem("All Companies"); // companies are added by show_companies
   company_combo->changed().connect(this, &WidgetMetrics::on_company_changed);
 
   status_text = toolbar->addWidget(std::make_unique<Wt::WText>());
@@ -93,58 +83,104 @@ void WidgetMetrics::on_company_changed()
 
 void WidgetMetrics::load_metrics()
 {
-  IFinMartDatabase* db = DatabaseFactory::create(METRICS_DB_BACKEND, METRICS_DB_CONNECTION);
+  std::string company = company_combo->currentText().toUTF8();
 
-  if (!db)
+  std::shared_ptr<const FinMartSnapshot> snapshot = finmart_snapshot();
+  if (snapshot)
   {
-    status_text->setText("Error: Could not create database instance");
+    show_metrics(ready_result(read_metrics(*snapshot, company)));
     return;
   }
 
-  std::string backend_name = db->get_backend_name();
-  status_text->setText("Loading metrics from " + backend_name + "...");
+  status_text->setText("Loading metrics...");
+  app->run_query<metrics_result_t>(this, [company](IFinMartDatabase* db)
+    {
+      return read_metrics(*db, company);
+    }, &WidgetMetrics::show_metrics);
+}
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// read_metrics - S is IFinMartDatabase or FinMartSnapshot
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename S>
+WidgetMetrics::metrics_result_t WidgetMetrics::read_metrics(S& source, const std::string& company)
+{
+  metrics_result_t result;
+  result.backend_name = source.get_backend_name();
+  result.company = company;
+  result.companies = source.get_companies();
+  if (company == "All Companies")
+  {
+    result.records = source.get_financial_records();
+  }
+  else
+  {
+    result.records = source.get_financial_records_by_company(company);
+  }
+  return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// show_metrics
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WidgetMetrics::show_metrics(std::shared_future<metrics_result_t> result)
+{
   try
   {
-    if (!db->is_open())
+    const metrics_result_t& metrics = result.get();
+    show_companies(metrics.companies);
+    if (metrics.company != company_combo->currentText().toUTF8())
     {
-      status_text->setText("Error: Database not connected");
-      delete db;
       return;
     }
+    show_financial_records(metrics.records);
+    show_calculated_metrics(metrics.records);
 
-    show_financial_records(db);
-    show_calculated_metrics(db);
-
-    app->set_status("Financial metrics loaded from " + backend_name);
-    delete db;
+    app->set_status("Financial metrics loaded from " + metrics.backend_name);
   }
   catch (const std::exception& e)
   {
     status_text->setText("Error: " + std::string(e.what()));
     app->set_status("Database error", true);
-    delete db;
   }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
-// show_financial_records
+// show_companies
+// fills the picker after "All Companies" with the reference list, keeping the selection; the
+// combo is left alone when the list did not change
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void WidgetMetrics::show_financial_records(IFinMartDatabase* db)
+void WidgetMetrics::show_companies(const std::vector<std::string>& companies)
 {
-  std::string filter = company_combo->currentText().toUTF8();
-  std::vector<FinancialRecord> records;
-
-  if (filter == "All Companies")
+  bool same = company_combo->count() == static_cast<int>(companies.size()) + 1;
+  for (size_t idx = 0; same && idx < companies.size(); idx++)
   {
-    records = db->get_financial_records();
+    same = company_combo->itemText(static_cast<int>(idx) + 1).toUTF8() == companies[idx];
   }
-  else
+  if (same)
   {
-    records = db->get_financial_records_by_company(filter);
+    return;
   }
 
+  Wt::WString selected = company_combo->currentText();
+  company_combo->clear();
+  company_combo->addItem("All Companies");
+  for (size_t idx = 0; idx < companies.size(); idx++)
+  {
+    company_combo->addItem(companies[idx]);
+  }
+  company_combo->setCurrentIndex(std::max(company_combo->findText(selected), 0));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// show_financial_records
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WidgetMetrics::show_financial_records(const std::vector<FinancialRecord>& records)
+{
   records_table->clear();
 
   records_table->elementAt(0, 0)->addWidget(std::make_unique<Wt::WText>("<b>Period</b>"));
@@ -200,20 +236,8 @@ void WidgetMetrics::show_financial_records(IFinMartDatabase* db)
 // show_calculated_metrics
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void WidgetMetrics::show_calculated_metrics(IFinMartDatabase* db)
+void WidgetMetrics::show_calculated_metrics(const std::vector<FinancialRecord>& records)
 {
-  std::string filter = company_combo->currentText().toUTF8();
-  std::vector<FinancialRecord> records;
-
-  if (filter == "All Companies")
-  {
-    records = db->get_financial_records();
-  }
-  else
-  {
-    records = db->get_financial_records_by_company(filter);
-  }
-
   metrics_table->clear();
 
   /////////////////////////////////////////////////////////////////////////////////////////////////////
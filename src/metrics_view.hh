@@ -6,12 +6,19 @@
 #include <Wt/WTable.h>
 #include <Wt/WPushButton.h>
 #include <Wt/WComboBox.h>
+#include <future>
+#include <string>
+#include <vector>
+#include "metrics.hh"
 
 class WApplicationStrategy;
-class IFinMartDatabase;
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // WidgetMetrics
+// the records of the selected company are read once, from finmart_snapshot() or on
+// finmart_executor(), and shown in both tables; a result pushed back for another company than
+// the one now selected is dropped; the company picker lists the reference companies of the
+// last result
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 class WidgetMetrics : public Wt::WContainerWidget
@@ -22,6 +29,14 @@ public:
   void load_metrics();
 
 private:
+  struct metrics_result_t
+  {
+    std::string backend_name;
+    std::string company;
+    std::vector<std::string> companies;
+    std::vector<FinancialRecord> records;
+  };
+
   WApplicationStrategy* app;
   Wt::WText* status_text;
   Wt::WPushButton* refresh_btn;
@@ -29,8 +44,12 @@ private:
   Wt::WTable* metrics_table;
   Wt::WComboBox* company_combo;
 
-  void show_financial_records(IFinMartDatabase* db);
-  void show_calculated_metrics(IFinMartDatabase* db);
+  template<typename S>
+  static metrics_result_t read_metrics(S& source, const std::string& company);
+  void show_metrics(std::shared_future<metrics_result_t> result);
+  void show_companies(const std::vector<std::string>& companies);
+  void show_financial_records(const std::vector<FinancialRecord>& records);
+  void show_calculated_metrics(const std::vector<FinancialRecord>& records);
   void on_company_changed();
 };
 
@@ -1,5 +1,7 @@
 ﻿#include "odbc.hh"
 #include <sstream>
+#include <iostream>
+#include <string.h>
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -9,7 +11,8 @@
 
 odbc::odbc() :
   m_henv(0),
-  m_hdbc(0)
+  m_hdbc(0),
+  fetch_rows(ODBC::FETCH_BLOCK_ROWS)
 {
   if (!SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_ENV, SQL_NULL_HANDLE, &m_henv)))
   {
@@ -73,7 +76,6 @@ int odbc::connect(const std::string& conn)
     break;
   }
 
-  get_version();
   return 0;
 }
 
@@ -89,35 +91,23 @@ int odbc::disconnect()
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
-//odbc::get_version
+//odbc::is_alive
+//false if the driver reports the connection dead (SQL_ATTR_CONNECTION_DEAD, no round trip);
+//with round_trip also runs SELECT 1, which finds connections the server or network dropped
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-int odbc::get_version()
+bool odbc::is_alive(bool round_trip)
 {
-  SQLHSTMT hstmt;
-  SQLCHAR str[256];
-
-  if (!SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_STMT, m_hdbc, &hstmt)))
-  {
-
-  }
-
-  if (!SQL_SUCCEEDED(SQLExecDirect(hstmt, (SQLCHAR*)"SELECT @@Version", SQL_NTS)))
+  SQLUINTEGER dead = SQL_CD_TRUE;
+  if (!SQL_SUCCEEDED(SQLGetConnectAttr(m_hdbc, SQL_ATTR_CONNECTION_DEAD, &dead, 0, NULL)) || dead == SQL_CD_TRUE)
   {
-
+    return false;
   }
-
-  if (!SQL_SUCCEEDED(SQLBindCol(hstmt, 1, SQL_C_CHAR, &str, 256, 0)))
+  if (round_trip)
   {
-
+    return exec_direct("SELECT 1") == 0;
   }
-
-  while (SQL_SUCCEEDED(SQLFetch(hstmt)))
-  {
-
-  }
-  SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
-  return 0;
+  return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -218,6 +208,192 @@ int odbc::exec_direct(const std::string& sql)
   return 0;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//odbc::exec_array
+//prepares sql and executes it once for nbr_rows parameter sets, see statement_t::execute
+//to execute the same SQL again use a statement_t, which is prepared only once
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int odbc::exec_array(const std::string& sql, std::vector<param_array_t>& params, size_t nbr_rows)
+{
+  if (nbr_rows == 0)
+  {
+    return 0;
+  }
+
+  statement_t stmt;
+  if (stmt.prepare(*this, sql) < 0)
+  {
+    return -1;
+  }
+  return stmt.execute(params, nbr_rows);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//bind_params
+//binds params[idx] to '?' marker idx + 1 of a prepared statement
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static int bind_params(SQLHSTMT hstmt, std::vector<param_array_t>& params)
+{
+  for (size_t idx = 0; idx < params.size(); idx++)
+  {
+    param_array_t& param = params[idx];
+    if (!SQL_SUCCEEDED(SQLBindParameter(
+      hstmt,
+      static_cast<SQLUSMALLINT>(idx + 1),
+      SQL_PARAM_INPUT,
+      param.c_type,
+      param.sql_type,
+      param.column_size,
+      0,
+      param.data.data(),
+      param.width,
+      param.ind.data())))
+    {
+      extract_error(hstmt, SQL_HANDLE_STMT);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//statement_t::prepare
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int statement_t::prepare(odbc& db, const std::string& sql)
+{
+  close();
+  if (!SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_STMT, db.m_hdbc, &hstmt)))
+  {
+    extract_error(db.m_hdbc, SQL_HANDLE_DBC);
+    hstmt = SQL_NULL_HSTMT;
+    return -1;
+  }
+
+  if (!SQL_SUCCEEDED(SQLPrepare(hstmt, (SQLCHAR*)sql.c_str(), SQL_NTS)))
+  {
+    extract_error(hstmt, SQL_HANDLE_STMT);
+    close();
+    return -1;
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//statement_t::execute
+//executes the prepared statement once for nbr_rows parameter sets (ODBC parameter arrays)
+//the driver sends all rows in one round trip; params holds one array per '?' marker
+//returns -1 if the statement fails or any row reports SQL_PARAM_ERROR
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int statement_t::execute(std::vector<param_array_t>& params, size_t nbr_rows)
+{
+  if (!is_prepared())
+  {
+    return -1;
+  }
+  if (nbr_rows == 0)
+  {
+    return 0;
+  }
+
+  status.assign(nbr_rows, SQL_PARAM_UNUSED);
+  nbr_processed = 0;
+  SQLSetStmtAttr(hstmt, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN, 0);
+  SQLSetStmtAttr(hstmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)nbr_rows, 0);
+  SQLSetStmtAttr(hstmt, SQL_ATTR_PARAM_STATUS_PTR, status.data(), 0);
+  SQLSetStmtAttr(hstmt, SQL_ATTR_PARAMS_PROCESSED_PTR, &nbr_processed, 0);
+
+  if (bind_params(hstmt, params) < 0)
+  {
+    return -1;
+  }
+
+  SQLRETURN rc = SQLExecute(hstmt);
+  int ret = 0;
+  if (!SQL_SUCCEEDED(rc))
+  {
+    extract_error(hstmt, SQL_HANDLE_STMT);
+    ret = -1;
+  }
+  else
+  {
+    for (size_t idx = 0; idx < nbr_processed && idx < nbr_rows; idx++)
+    {
+      if (status[idx] == SQL_PARAM_ERROR)
+      {
+        extract_error(hstmt, SQL_HANDLE_STMT);
+        ret = -1;
+        break;
+      }
+    }
+  }
+
+  SQLFreeStmt(hstmt, SQL_CLOSE);
+  SQLFreeStmt(hstmt, SQL_RESET_PARAMS);
+  return ret;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//statement_t::close
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void statement_t::close()
+{
+  if (hstmt != SQL_NULL_HSTMT)
+  {
+    SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+    hstmt = SQL_NULL_HSTMT;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//param_array_t
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+param_array_t::param_array_t(SQLSMALLINT c_type, SQLSMALLINT sql_type, SQLULEN column_size, SQLLEN width, size_t nbr_rows) :
+  c_type(c_type),
+  sql_type(sql_type),
+  column_size(column_size),
+  width(width),
+  data(nbr_rows * width),
+  ind(nbr_rows, 0)
+{
+}
+
+param_array_t param_array_t::text(SQLULEN column_size, size_t nbr_rows)
+{
+  return param_array_t(SQL_C_CHAR, SQL_VARCHAR, column_size, static_cast<SQLLEN>(column_size + 1), nbr_rows);
+}
+
+param_array_t param_array_t::real(size_t nbr_rows)
+{
+  return param_array_t(SQL_C_DOUBLE, SQL_DOUBLE, 0, sizeof(double), nbr_rows);
+}
+
+int param_array_t::set(size_t row, const std::string& value)
+{
+  if (value.size() > column_size)
+  {
+    std::cerr << "parameter value of " << value.size() << " characters exceeds column size " << column_size << std::endl;
+    return -1;
+  }
+  char* dst = data.data() + row * width;
+  memcpy(dst, value.data(), value.size());
+  dst[value.size()] = '\0';
+  ind[row] = static_cast<SQLLEN>(value.size());
+  return 0;
+}
+
+int param_array_t::set(size_t row, double value)
+{
+  memcpy(data.data() + row * width, &value, sizeof(double));
+  ind[row] = 0;
+  return 0;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 //extract_error
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -252,41 +428,262 @@ void extract_error(SQLHANDLE handle, SQLSMALLINT type)
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 //odbc::fetch
+//the table is filled one block at a time, each row is built from the column arrays of the block
+//only SQL_NO_DATA ends the result, any other SQLFetch failure returns -1
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 int odbc::fetch(const std::string& sql, table_t& table)
 {
   table.remove();
   SQLHSTMT hstmt;
-  SQLSMALLINT nbr_cols;
   SQLCHAR* sqlstr = (SQLCHAR*)sql.c_str();
-  struct bind_column_data_t* bind_data = NULL;
 
   if (!SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_STMT, m_hdbc, &hstmt)))
   {
-
+    extract_error(m_hdbc, SQL_HANDLE_DBC);
+    return -1;
   }
 
   if (!SQL_SUCCEEDED(SQLExecDirect(hstmt, sqlstr, SQL_NTS)))
   {
     extract_error(hstmt, SQL_HANDLE_STMT);
+    SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
     return -1;
   }
 
-  if (!SQL_SUCCEEDED(SQLNumResultCols(hstmt, &nbr_cols)))
+  block_t block;
+  if (describe_columns(hstmt, table.cols) < 0 || bind_block(hstmt, table.cols, false, block) < 0)
   {
+    SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+    return -1;
+  }
 
+  SQLRETURN rc;
+  while ((rc = SQLFetch(hstmt)) != SQL_NO_DATA)
+  {
+    if (!SQL_SUCCEEDED(rc))
+    {
+      extract_error(hstmt, SQL_HANDLE_STMT);
+      SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+      return -1;
+    }
+    for (size_t idx_row = 0; idx_row < block.nbr_fetched; idx_row++)
+    {
+      if (!block.has_row(idx_row))
+      {
+        continue;
+      }
+      table.rows.emplace_back();
+      row_t& row = table.rows.back();
+      row.col.reserve(table.cols.size());
+      for (size_t idx_col = 0; idx_col < table.cols.size(); idx_col++)
+      {
+        row.col.emplace_back(block.value(idx_col, idx_row));
+      }
+    }
   }
 
-  bind_data = (bind_column_data_t*)malloc(nbr_cols * sizeof(bind_column_data_t));
-  for (SQLUSMALLINT idx = 0; idx < nbr_cols; idx++)
+  SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//odbc::fetch
+//typed variant: the columns are bound with the C type of their SQL type (see typed_column_t)
+//and each block is appended to the column vectors
+//params holds one single-row param_array_t per '?' marker in sql
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int odbc::fetch(const std::string& sql, typed_table_t& table)
+{
+  std::vector<param_array_t> params;
+  return fetch(sql, params, table);
+}
+
+int odbc::fetch(const std::string& sql, std::vector<param_array_t>& params, typed_table_t& table)
+{
+  table.remove();
+  SQLHSTMT hstmt;
+
+  if (!SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_STMT, m_hdbc, &hstmt)))
+  {
+    extract_error(m_hdbc, SQL_HANDLE_DBC);
+    return -1;
+  }
+
+  SQLRETURN rc = params.empty() ? SQLExecDirect(hstmt, (SQLCHAR*)sql.c_str(), SQL_NTS) : SQLPrepare(hstmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+  if (SQL_SUCCEEDED(rc) && !params.empty())
+  {
+    rc = bind_params(hstmt, params) == 0 ? SQLExecute(hstmt) : SQL_ERROR;
+  }
+  if (!SQL_SUCCEEDED(rc))
+  {
+    extract_error(hstmt, SQL_HANDLE_STMT);
+    SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+    return -1;
+  }
+
+  std::vector<column_t> cols;
+  block_t block;
+  if (describe_columns(hstmt, cols) < 0 || bind_block(hstmt, cols, true, block) < 0)
+  {
+    SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+    return -1;
+  }
+
+  for (size_t idx_col = 0; idx_col < cols.size(); idx_col++)
+  {
+    table.add_column(cols[idx_col], block.c_type[idx_col]);
+  }
+
+  while ((rc = SQLFetch(hstmt)) != SQL_NO_DATA)
+  {
+    if (!SQL_SUCCEEDED(rc))
+    {
+      extract_error(hstmt, SQL_HANDLE_STMT);
+      SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+      return -1;
+    }
+    for (size_t idx_row = 0; idx_row < block.nbr_fetched; idx_row++)
+    {
+      if (!block.has_row(idx_row))
+      {
+        continue;
+      }
+      for (size_t idx_col = 0; idx_col < cols.size(); idx_col++)
+      {
+        typed_column_t& col = table.cols[idx_col];
+        bool is_null = block.ind[idx_col][idx_row] == SQL_NULL_DATA;
+        const char* value = &block.data[idx_col][idx_row * block.width[idx_col]];
+        switch (col.c_type)
+        {
+        case SQL_C_DOUBLE:
+          col.doubles.push_back(is_null ? 0.0 : *reinterpret_cast<const double*>(value));
+          col.null.push_back(is_null ? 1 : 0);
+          break;
+        case SQL_C_SBIGINT:
+          col.integers.push_back(is_null ? 0 : *reinterpret_cast<const SQLBIGINT*>(value));
+          col.null.push_back(is_null ? 1 : 0);
+          break;
+        case SQL_C_TYPE_TIMESTAMP:
+          col.timestamps.push_back(is_null ? SQL_TIMESTAMP_STRUCT() : *reinterpret_cast<const SQL_TIMESTAMP_STRUCT*>(value));
+          col.null.push_back(is_null ? 1 : 0);
+          break;
+        default:
+          if (is_null)
+          {
+            col.append_null_text();
+          }
+          else
+          {
+            col.append_text(block.value(idx_col, idx_row));
+          }
+          break;
+        }
+      }
+      table.nbr_rows++;
+    }
+  }
+
+  SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//odbc::fetch_each
+//executes sql and passes each fetched row to visit, without collecting a table
+//values longer than 1024 bytes are truncated, as in fetch, and a NULL cell is ODBC::SQL_NULL;
+//visit returns false to stop early
+//params holds one single-row param_array_t per '?' marker in sql
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int odbc::fetch_each(const std::string& sql, const std::function<bool(const row_view_t&)>& visit)
+{
+  std::vector<param_array_t> params;
+  return fetch_each(sql, params, visit);
+}
+
+int odbc::fetch_each(const std::string& sql, std::vector<param_array_t>& params, const std::function<bool(const row_view_t&)>& visit)
+{
+  SQLHSTMT hstmt;
+
+  if (!SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_STMT, m_hdbc, &hstmt)))
+  {
+    extract_error(m_hdbc, SQL_HANDLE_DBC);
+    return -1;
+  }
+
+  if (!SQL_SUCCEEDED(SQLPrepare(hstmt, (SQLCHAR*)sql.c_str(), SQL_NTS)))
   {
-    bind_data[idx].target_value_ptr = NULL;
+    extract_error(hstmt, SQL_HANDLE_STMT);
+    SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+    return -1;
   }
 
-  /////////////////////////////////////////////////////////////////////////////////////////////////////
-  //get column names
-  /////////////////////////////////////////////////////////////////////////////////////////////////////
+  if (bind_params(hstmt, params) < 0)
+  {
+    SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+    return -1;
+  }
+
+  if (!SQL_SUCCEEDED(SQLExecute(hstmt)))
+  {
+    extract_error(hstmt, SQL_HANDLE_STMT);
+    SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+    return -1;
+  }
+
+  std::vector<column_t> cols;
+  block_t block;
+  if (describe_columns(hstmt, cols) < 0 || bind_block(hstmt, cols, false, block) < 0)
+  {
+    SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+    return -1;
+  }
+
+  row_view_t row;
+  row.col.resize(cols.size());
+  bool done = false;
+  SQLRETURN rc;
+  while (!done && (rc = SQLFetch(hstmt)) != SQL_NO_DATA)
+  {
+    if (!SQL_SUCCEEDED(rc))
+    {
+      extract_error(hstmt, SQL_HANDLE_STMT);
+      SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+      return -1;
+    }
+    for (size_t idx_row = 0; idx_row < block.nbr_fetched && !done; idx_row++)
+    {
+      if (!block.has_row(idx_row))
+      {
+        continue;
+      }
+      for (size_t idx_col = 0; idx_col < cols.size(); idx_col++)
+      {
+        row.col[idx_col] = block.value(idx_col, idx_row);
+      }
+      done = !visit(row);
+    }
+  }
+
+  SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//odbc::describe_columns
+//name, SQL type and size of each result column
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int odbc::describe_columns(SQLHSTMT hstmt, std::vector<column_t>& cols)
+{
+  SQLSMALLINT nbr_cols = 0;
+  if (!SQL_SUCCEEDED(SQLNumResultCols(hstmt, &nbr_cols)))
+  {
+    extract_error(hstmt, SQL_HANDLE_STMT);
+    return -1;
+  }
 
   for (SQLUSMALLINT idx = 0; idx < nbr_cols; idx++)
   {
@@ -296,6 +693,7 @@ int odbc::fetch(const std::string& sql, table_t& table)
     SQLSMALLINT nullable = 0;
     SQLSMALLINT len = 0;
     SQLULEN sqlsize = 0;
+    buf[0] = 0;
 
     if (!SQL_SUCCEEDED(SQLDescribeCol(
       hstmt,
@@ -314,73 +712,137 @@ int odbc::fetch(const std::string& sql, table_t& table)
     column_t col;
     col.name = (char*)buf;
     col.sqltype = sqltype;
-    table.cols.push_back(col);
+    col.sqlsize = sqlsize;
+    cols.push_back(col);
   }
+  return 0;
+}
 
-  for (SQLUSMALLINT idx = 0; idx < nbr_cols; idx++)
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//odbc::bind_block
+//binds every column to an array of fetch_rows values and sets the statement to column-wise
+//binding with a row array of fetch_rows rows
+//typed: numbers and timestamps are bound with their C type (see typed_column_t), the rest and
+//all columns when not typed as SQL_C_CHAR
+//the width of a text value is the text size of its SQL type: the declared size for character
+//columns (4 bytes per character for wide ones, converted to UTF-8), 64 bytes for numbers and
+//dates, never more than 1024 + 1 so that the arrays stay small and long values truncate as before
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int odbc::bind_block(SQLHSTMT hstmt, const std::vector<column_t>& cols, bool typed, block_t& block)
+{
+  const SQLLEN max_len = 1024;
+  size_t nbr_rows = fetch_rows;
+
+  block.c_type.assign(cols.size(), SQL_C_CHAR);
+  block.width.resize(cols.size());
+  block.data.resize(cols.size());
+  block.ind.resize(cols.size());
+  block.status.assign(nbr_rows, SQL_ROW_NOROW);
+  block.nbr_fetched = 0;
+
+  if (!SQL_SUCCEEDED(SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_BIND_TYPE, (SQLPOINTER)SQL_BIND_BY_COLUMN, 0)) ||
+    !SQL_SUCCEEDED(SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)nbr_rows, 0)) ||
+    !SQL_SUCCEEDED(SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_STATUS_PTR, block.status.data(), 0)) ||
+    !SQL_SUCCEEDED(SQLSetStmtAttr(hstmt, SQL_ATTR_ROWS_FETCHED_PTR, &block.nbr_fetched, 0)))
   {
-    bind_data[idx].target_type = SQL_C_CHAR;
-    bind_data[idx].buf_len = (1024 + 1);
-    bind_data[idx].target_value_ptr = malloc(sizeof(unsigned char) * bind_data[idx].buf_len);
+    extract_error(hstmt, SQL_HANDLE_STMT);
+    return -1;
   }
 
-  /////////////////////////////////////////////////////////////////////////////////////////////////////
-  //SQLBindCol assigns the storage and data type for a column in a result set,
-  //including:
-  //a storage buffer that will receive the contents of a column of data
-  //the length of the storage buffer
-  //a storage location that will receive the actual length of the column of data
-  //returned by the fetch operation data type conversion
-  /////////////////////////////////////////////////////////////////////////////////////////////////////
-
-  for (SQLUSMALLINT idx = 0; idx < nbr_cols; idx++)
+  for (size_t idx = 0; idx < cols.size(); idx++)
   {
-    if (!SQL_SUCCEEDED(SQLBindCol(
-      hstmt,
-      idx + 1,
-      bind_data[idx].target_type,
-      bind_data[idx].target_value_ptr,
-      bind_data[idx].buf_len,
-      &(bind_data[idx].strlen_or_ind))))
+    SQLLEN len = max_len;
+    switch (cols[idx].sqltype)
     {
-      extract_error(hstmt, SQL_HANDLE_STMT);
+    case SQL_CHAR:
+    case SQL_VARCHAR:
+      if (cols[idx].sqlsize > 0) len = std::min<SQLLEN>(max_len, cols[idx].sqlsize);
+      break;
+    case SQL_WCHAR:
+    case SQL_WVARCHAR:
+      if (cols[idx].sqlsize > 0) len = std::min<SQLLEN>(max_len, cols[idx].sqlsize * 4);
+      break;
+    case SQL_TINYINT:
+    case SQL_SMALLINT:
+    case SQL_INTEGER:
+    case SQL_BIGINT:
+    case SQL_BIT:
+    case SQL_REAL:
+    case SQL_FLOAT:
+    case SQL_DOUBLE:
+    case SQL_NUMERIC:
+    case SQL_DECIMAL:
+    case SQL_TYPE_DATE:
+    case SQL_TYPE_TIME:
+    case SQL_TYPE_TIMESTAMP:
+      len = 64;
+      break;
     }
-  }
+    block.width[idx] = len + 1;
 
-  size_t nbr_rows = 0;
-  while (SQL_SUCCEEDED(SQLFetch(hstmt)))
-  {
-    row_t row;
-    for (int idx_col = 0; idx_col < nbr_cols; idx_col++)
+    if (typed)
     {
-      std::string str;
-      if (bind_data[idx_col].strlen_or_ind != SQL_NULL_DATA)
+      switch (cols[idx].sqltype)
       {
-        str = (char*)bind_data[idx_col].target_value_ptr;
+      case SQL_REAL:
+      case SQL_FLOAT:
+      case SQL_DOUBLE:
+      case SQL_NUMERIC:
+      case SQL_DECIMAL:
+        block.c_type[idx] = SQL_C_DOUBLE;
+        block.width[idx] = sizeof(double);
+        break;
+      case SQL_BIT:
+      case SQL_TINYINT:
+      case SQL_SMALLINT:
+      case SQL_INTEGER:
+      case SQL_BIGINT:
+        block.c_type[idx] = SQL_C_SBIGINT;
+        block.width[idx] = sizeof(SQLBIGINT);
+        break;
+      case SQL_TYPE_DATE:
+      case SQL_TYPE_TIMESTAMP:
+        block.c_type[idx] = SQL_C_TYPE_TIMESTAMP;
+        block.width[idx] = sizeof(SQL_TIMESTAMP_STRUCT);
+        break;
       }
-      else
-      {
-        str = ODBC::SQL_NULL;
-      }
-      row.col.push_back(str);
     }
-    table.rows.push_back(row);
-    nbr_rows++;
-  }
 
-  for (SQLUSMALLINT idx_col = 0; idx_col < nbr_cols; idx_col++)
-  {
-    if (bind_data[idx_col].target_value_ptr != NULL)
+    //vector<char> storage is aligned for any fundamental type and every width above is a
+    //multiple of the alignment of its type, so each typed value is aligned
+    block.data[idx].resize(nbr_rows * block.width[idx]);
+    block.ind[idx].resize(nbr_rows);
+
+    if (!SQL_SUCCEEDED(SQLBindCol(hstmt, static_cast<SQLUSMALLINT>(idx + 1), block.c_type[idx], block.data[idx].data(),
+      block.width[idx], block.ind[idx].data())))
     {
-      free(bind_data[idx_col].target_value_ptr);
+      extract_error(hstmt, SQL_HANDLE_STMT);
+      return -1;
     }
   }
-  if (bind_data != NULL)
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//odbc::block_t::value
+//text of a cell in the block, ODBC::SQL_NULL for NULL; the indicator is the full length of the
+//value, a truncated value is cut at the end of its buffer
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string_view odbc::block_t::value(size_t col, size_t row) const
+{
+  SQLLEN ind_value = ind[col][row];
+  if (ind_value == SQL_NULL_DATA)
   {
-    free(bind_data);
+    return ODBC::SQL_NULL;
   }
-  SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
-  return 0;
+  const char* text = &data[col][row * width[col]];
+  if (ind_value == SQL_NO_TOTAL || ind_value < 0 || ind_value > width[col] - 1)
+  {
+    return std::string_view(text, strlen(text));
+  }
+  return std::string_view(text, static_cast<size_t>(ind_value));
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -397,6 +859,158 @@ void table_t::remove()
   rows.clear();
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//typed_table_t::remove
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void typed_table_t::remove()
+{
+  cols.clear();
+  index.clear();
+  nbr_rows = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//typed_table_t::add_column
+//appends an empty column; with duplicate names column_index finds the first one
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void typed_table_t::add_column(const column_t& col, SQLSMALLINT c_type)
+{
+  typed_column_t column;
+  column.name = col.name;
+  column.sqltype = col.sqltype;
+  column.c_type = c_type;
+  index.emplace(col.name, cols.size());
+  cols.push_back(std::move(column));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//typed_table_t::column_index
+//index of the column named col_name, -1 if there is none
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int typed_table_t::column_index(const std::string& col_name) const
+{
+  std::unordered_map<std::string, size_t>::const_iterator it = index.find(col_name);
+  if (it == index.end())
+  {
+    return -1;
+  }
+  return static_cast<int>(it->second);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//typed_column_t::text
+//value of a text column, a view of the column storage; empty for NULL
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string_view typed_column_t::text(size_t row) const
+{
+  if (null[row])
+  {
+    return std::string_view();
+  }
+  if (dictionary_encoded)
+  {
+    return dictionary[codes[row]];
+  }
+  return std::string_view(bytes.data() + offsets[row], offsets[row + 1] - offsets[row]);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//typed_column_t::append_text
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void typed_column_t::append_text(std::string_view value)
+{
+  if (dictionary_encoded)
+  {
+    uint32_t code = dictionary_code(value);
+    if (code != ODBC::NULL_CODE)
+    {
+      codes.push_back(code);
+      null.push_back(0);
+      return;
+    }
+    decode_dictionary();
+  }
+  bytes.append(value.data(), value.size());
+  offsets.push_back(bytes.size());
+  null.push_back(0);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//typed_column_t::append_null_text
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void typed_column_t::append_null_text()
+{
+  if (dictionary_encoded)
+  {
+    codes.push_back(ODBC::NULL_CODE);
+  }
+  else
+  {
+    offsets.push_back(bytes.size());
+  }
+  null.push_back(1);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//typed_column_t::dictionary_code
+//code of value, added to the dictionary if new; ODBC::NULL_CODE when the dictionary is full
+//slots is a linear probing table of twice ODBC::DICTIONARY_MAX_VALUES entries, never more
+//than half full, so a lookup hashes the view and compares one or two strings, no allocation
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t typed_column_t::dictionary_code(std::string_view value)
+{
+  if (slots.empty())
+  {
+    slots.assign(2 * ODBC::DICTIONARY_MAX_VALUES, ODBC::NULL_CODE);
+  }
+  size_t slot = std::hash<std::string_view>()(value) % slots.size();
+  while (slots[slot] != ODBC::NULL_CODE)
+  {
+    if (dictionary[slots[slot]] == value)
+    {
+      return slots[slot];
+    }
+    slot = (slot + 1) % slots.size();
+  }
+  if (dictionary.size() == ODBC::DICTIONARY_MAX_VALUES)
+  {
+    return ODBC::NULL_CODE;
+  }
+  slots[slot] = static_cast<uint32_t>(dictionary.size());
+  dictionary.emplace_back(value);
+  return slots[slot];
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//typed_column_t::decode_dictionary
+//moves the values read so far from codes to offsets and bytes, releases the dictionary
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void typed_column_t::decode_dictionary()
+{
+  offsets.assign(1, 0);
+  offsets.reserve(codes.size() + 1);
+  for (size_t idx = 0; idx < codes.size(); idx++)
+  {
+    if (codes[idx] != ODBC::NULL_CODE)
+    {
+      bytes.append(dictionary[codes[idx]]);
+    }
+    offsets.push_back(bytes.size());
+  }
+  std::vector<uint32_t>().swap(codes);
+  std::vector<std::string>().swap(dictionary);
+  std::vector<uint32_t>().swap(slots);
+  dictionary_encoded = false;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 //table_t::get_row_col_value
 /////////////////////////////////////////////////////////////////////////////////////////////////////
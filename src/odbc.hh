@@ -10,6 +10,10 @@
 #include <sqlext.h>
 #include <string>
 #include <vector>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
 #include <assert.h>
 
 #ifndef _MSC_VER
@@ -25,6 +29,15 @@ namespace ODBC
 {
   //return value for a cell that is SQL_NULL_DATA as a string
   const std::string SQL_NULL = "SQL_NULL_DATA";
+
+  //default rows per SQLFetch call of fetch and fetch_each (SQL_ATTR_ROW_ARRAY_SIZE)
+  const size_t FETCH_BLOCK_ROWS = 1000;
+
+  //distinct values a text column of a typed_table_t keeps dictionary-encoded
+  const size_t DICTIONARY_MAX_VALUES = 1024;
+
+  //dictionary code of a SQL NULL text value
+  const uint32_t NULL_CODE = 0xFFFFFFFF;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -39,13 +52,14 @@ struct row_t
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 //column_t
-//a column has a name and a SQL type
+//a column has a name, a SQL type and a size (characters, or precision of a number)
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 struct column_t
 {
   std::string name;
   SQLSMALLINT sqltype;
+  SQLULEN sqlsize;
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -66,8 +80,106 @@ public:
   std::string get_row_col_value(int row, const std::string& col_name);
 };
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//typed_column_t
+//a column of a typed_table_t, bound with the C type of its SQL type (see odbc::fetch):
+//  SQL_C_DOUBLE           FLOAT, REAL, DOUBLE, NUMERIC, DECIMAL    doubles
+//  SQL_C_SBIGINT          BIT, TINYINT, SMALLINT, INTEGER, BIGINT  integers
+//  SQL_C_TYPE_TIMESTAMP   DATE, DATETIME, DATETIME2                timestamps
+//  SQL_C_CHAR             everything else                          text(row)
+//only the storage of c_type is filled; null[row] is 1 for a SQL NULL, its value is 0 or empty
+//
+//text is dictionary-encoded while the column has at most ODBC::DICTIONARY_MAX_VALUES distinct
+//values (department, source_system): codes[row] indexes dictionary, ODBC::NULL_CODE for NULL.
+//past that the column switches to one buffer: value row is bytes[offsets[row], offsets[row + 1])
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class typed_column_t
+{
+public:
+  typed_column_t() : sqltype(0), c_type(SQL_C_CHAR), dictionary_encoded(true) {}
+  std::string name;
+  SQLSMALLINT sqltype;
+  SQLSMALLINT c_type;
+  std::vector<double> doubles;
+  std::vector<SQLBIGINT> integers;
+  std::vector<SQL_TIMESTAMP_STRUCT> timestamps;
+  bool dictionary_encoded;
+  std::vector<uint32_t> codes;
+  std::vector<std::string> dictionary;
+  std::vector<size_t> offsets;
+  std::string bytes;
+  std::vector<char> null;
+
+  std::string_view text(size_t row) const;
+  void append_text(std::string_view value);
+  void append_null_text();
+
+private:
+  uint32_t dictionary_code(std::string_view value);
+  void decode_dictionary();
+  std::vector<uint32_t> slots; //open addressing hash of dictionary, codes by hash of the value
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//typed_table_t
+//a table stored by column, each column in a contiguous array of its C type, so numbers go from
+//the driver buffers to the caller without a text conversion and text without a string per cell;
+//column_index is a hash lookup of the column name
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class typed_table_t
+{
+public:
+  typed_table_t() : nbr_rows(0) {}
+  std::vector<typed_column_t> cols;
+  size_t nbr_rows;
+  void remove();
+  void add_column(const column_t& col, SQLSMALLINT c_type);
+  int column_index(const std::string& col_name) const;
+
+private:
+  std::unordered_map<std::string, size_t> index;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//row_view_t
+//a row of odbc::fetch_each, views of the bound column buffers, valid during the visitor call
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct row_view_t
+{
+  std::vector<std::string_view> col;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//param_array_t
+//column-wise parameter array for odbc::exec_array, one element per row
+//text elements are fixed width (column_size + 1); set() rejects a longer value with -1 instead
+//of truncating it, size the array from the longest value to be bound
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct param_array_t
+{
+  param_array_t(SQLSMALLINT c_type, SQLSMALLINT sql_type, SQLULEN column_size, SQLLEN width, size_t nbr_rows);
+  static param_array_t text(SQLULEN column_size, size_t nbr_rows);
+  static param_array_t real(size_t nbr_rows);
+  int set(size_t row, const std::string& value);
+  int set(size_t row, double value);
+
+  SQLSMALLINT c_type; //C type of the buffer (SQL_C_CHAR, SQL_C_DOUBLE)
+  SQLSMALLINT sql_type; //SQL type of the parameter (SQL_VARCHAR, SQL_DOUBLE)
+  SQLULEN column_size;
+  SQLLEN width; //bytes per element
+  std::vector<char> data;
+  std::vector<SQLLEN> ind;
+};
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 //odbc
+//fetch and fetch_each read results in blocks: the columns are bound column-wise to arrays of
+//fetch_rows values and each SQLFetch returns up to fetch_rows rows (a block cursor), instead of
+//one driver call per row; set_fetch_rows(1) fetches one row per call
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 class odbc
@@ -77,26 +189,71 @@ public:
   ~odbc();
   int connect(const std::string& conn);
   int disconnect();
+  bool is_alive(bool round_trip);
   int exec_direct(const std::string& sql);
+  int exec_array(const std::string& sql, std::vector<param_array_t>& params, size_t nbr_rows);
   int fetch(const std::string& sql, table_t& table);
+  int fetch(const std::string& sql, typed_table_t& table);
+  int fetch(const std::string& sql, std::vector<param_array_t>& params, typed_table_t& table);
+  int fetch_each(const std::string& sql, const std::function<bool(const row_view_t&)>& visit);
+  int fetch_each(const std::string& sql, std::vector<param_array_t>& params, const std::function<bool(const row_view_t&)>& visit);
   int set_auto_commit();
   int set_manual();
   int commit_transaction();
   int rollback_transaction();
+  void set_fetch_rows(size_t nbr_rows) { fetch_rows = nbr_rows > 0 ? nbr_rows : 1; }
+  size_t get_fetch_rows() const { return fetch_rows; }
   SQLHENV m_henv; //environment handle
   SQLHDBC m_hdbc; //connection handle
 
 private:
-  int get_version();
-
-  struct bind_column_data_t
+  //column-wise result buffers of one block: per column, fetch_rows values of width bytes
+  //and their length/indicator; status and nbr_fetched are set by each SQLFetch
+  struct block_t
   {
-    SQLSMALLINT target_type; //the C data type of the result data
-    SQLPOINTER target_value_ptr; //pointer to storage for the data
-    SQLINTEGER buf_len; //maximum length of the buffer being bound for data (including null-termination byte for char)
-    SQLLEN strlen_or_ind; //number of bytes(excluding the null termination byte for character data) available
-    //to return in the buffer prior to calling SQLFetch
+    std::vector<SQLSMALLINT> c_type;
+    std::vector<SQLLEN> width;
+    std::vector<std::vector<char>> data;
+    std::vector<std::vector<SQLLEN>> ind;
+    std::vector<SQLUSMALLINT> status;
+    SQLULEN nbr_fetched;
+    bool has_row(size_t row) const { return status[row] == SQL_ROW_SUCCESS || status[row] == SQL_ROW_SUCCESS_WITH_INFO; }
+    std::string_view value(size_t col, size_t row) const;
   };
+
+  int describe_columns(SQLHSTMT hstmt, std::vector<column_t>& cols);
+  int bind_block(SQLHSTMT hstmt, const std::vector<column_t>& cols, bool typed, block_t& block);
+  size_t fetch_rows;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//statement_t
+//a statement prepared once on a connection (SQLPrepare) and executed many times, each time
+//with new parameter arrays of any number of rows; the server parses the SQL only at prepare
+//the statement must be closed before its odbc connection is disconnected
+//
+//Usage:
+//  statement_t stmt;
+//  if (stmt.prepare(db, "INSERT INTO t (a, b) VALUES (?, ?)") < 0) { ... }
+//  stmt.execute(params, nbr_rows);
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class statement_t
+{
+public:
+  statement_t() : hstmt(SQL_NULL_HSTMT), nbr_processed(0) {}
+  ~statement_t() { close(); }
+  int prepare(odbc& db, const std::string& sql);
+  int execute(std::vector<param_array_t>& params, size_t nbr_rows);
+  void close();
+  bool is_prepared() const { return hstmt != SQL_NULL_HSTMT; }
+
+private:
+  statement_t(const statement_t&) = delete;
+  statement_t& operator=(const statement_t&) = delete;
+  SQLHSTMT hstmt;
+  std::vector<SQLUSMALLINT> status;
+  SQLULEN nbr_processed;
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
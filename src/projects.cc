@@ -2,7 +2,8 @@
 #include "app.hh"
 #include "get.hh"
 #include "api.hh"
-#include "lite.hh"
+#include "db_pool.hh"
+#include "manager.hh"
 #include <Wt/WBreak.h>
 #include <fstream>
 #include <sstream>
@@ -151,15 +152,50 @@ void WidgetProjects::select_project(const std::string& project_id, const std::st
   status_text->setText("Running ETL for: " + project_name + "...");
   run_etl(project_id, project_name);
   load_projects();
-  app->show_data();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 // run_etl - Extract, Transform, Load from MicroStrategy to SQLite
+// DataManager::run_etl on the views' pool, on the executor like WidgetView::run_etl: with SQLite
+// the load is staged and published, then the snapshot the dashboards read is reloaded
+// the MicroStrategy extract is not part of this tree yet, the load step is empty
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WidgetProjects::run_etl(const std::string&, const std::string& project_name)
+{
+  app->run_query<etl_result_t>(this, [project_name](IFinMartDatabase*)
+    {
+      DataManager manager;
+      etl_result_t result;
+      result.ret = manager.run_etl(finmart_pool(), nullptr);
+      result.project_name = project_name;
+      result.backend_name = manager.get_db_backend_name();
+      return result;
+    }, &WidgetProjects::show_etl_result);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// show_etl_result - the data view is shown once the run is over, from the new snapshot if it
+// was published
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void WidgetProjects::run_etl(const std::string& project_id, const std::string& project_name)
+void WidgetProjects::show_etl_result(std::shared_future<etl_result_t> result)
 {
-  finmart_db db("finmart.db");
-  app->set_status("ETL Complete: Loaded data for " + project_name + " to finmart.db");
+  etl_result_t etl;
+  etl.ret = -1;
+  try
+  {
+    etl = result.get();
+  }
+  catch (const std::exception&)
+  {
+  }
+  app->show_data();
+  if (etl.ret < 0)
+  {
+    app->set_status(etl.project_name.empty() ? "ETL failed, the previous data is kept" :
+      "ETL failed: nothing published for " + etl.project_name, true);
+    return;
+  }
+  app->set_status("ETL Complete: Loaded data for " + etl.project_name + " to " + etl.backend_name);
 }
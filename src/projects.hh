@@ -5,6 +5,8 @@
 #include <Wt/WTable.h>
 #include <Wt/WPushButton.h>
 #include <Wt/WText.h>
+#include <future>
+#include <string>
 
 class WApplicationStrategy;
 
@@ -16,9 +18,18 @@ public:
   void refresh();
 
 private:
+  // result of an ETL run on the executor, rendered by show_etl_result
+  struct etl_result_t
+  {
+    int ret;
+    std::string project_name;
+    std::string backend_name;
+  };
+
   void load_projects();
   void select_project(const std::string& project_id, const std::string& project_name);
   void run_etl(const std::string& project_id, const std::string& project_name);
+  void show_etl_result(std::shared_future<etl_result_t> result);
 
   WApplicationStrategy* app;
   Wt::WTable* table;
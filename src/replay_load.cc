@@ -0,0 +1,335 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include <zlib.h>
+#include "ssl_read.hh"
+#include "get.hh"
+#include "api.hh"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// replay_load
+// load driver for replay_server: calls each REST API function repeatedly and reports
+// requests/sec, p50 and p99 latency per function
+//
+// Usage:
+//   replay_load [base_url] [--requests N] [--threads T] [--report id] [--cube id] [--project id]
+//
+//   base_url defaults to https://localhost:8443/MicroStrategyLibrary, an IPv6 server is given
+//   as https://[::1]:8443/MicroStrategyLibrary
+//   every response is kept in memory by the calling thread, nothing is written to disk
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct load_result_t
+{
+  std::string name;
+  size_t requests = 0;
+  size_t errors = 0;
+  double seconds = 0;
+  double p50_ms = 0;
+  double p99_ms = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// null_buffer - swallows the request/response logging of the API functions while measuring
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class null_buffer : public std::streambuf
+{
+protected:
+  int overflow(int c) override { return c; }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// percentile - value at fraction p of the sorted samples
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+  if (sorted.empty())
+  {
+    return 0;
+  }
+  size_t idx = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+  return sorted[idx];
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// run
+// nbr_requests calls of fn spread over nbr_threads threads; fn returns 0 on success
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static load_result_t run(const std::string& name, size_t nbr_requests, size_t nbr_threads, const std::function<int()>& fn)
+{
+  std::vector<std::vector<double>> latency(nbr_threads);
+  std::atomic<size_t> errors(0);
+  std::vector<std::thread> threads;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t thread = 0; thread < nbr_threads; thread++)
+  {
+    size_t count = nbr_requests / nbr_threads + (thread < nbr_requests % nbr_threads ? 1 : 0);
+    threads.emplace_back([&fn, &latency, &errors, thread, count]()
+      {
+        for (size_t idx = 0; idx < count; idx++)
+        {
+          std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+          if (fn() != 0)
+          {
+            errors++;
+          }
+          std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - t0;
+          latency[thread].push_back(elapsed.count());
+        }
+      });
+  }
+  for (size_t idx = 0; idx < threads.size(); idx++)
+  {
+    threads[idx].join();
+  }
+  std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+
+  std::vector<double> all;
+  for (size_t idx = 0; idx < latency.size(); idx++)
+  {
+    all.insert(all.end(), latency[idx].begin(), latency[idx].end());
+  }
+  std::sort(all.begin(), all.end());
+
+  load_result_t result;
+  result.name = name;
+  result.requests = all.size();
+  result.errors = errors;
+  result.seconds = wall.count();
+  result.p50_ms = percentile(all, 0.50);
+  result.p99_ms = percentile(all, 0.99);
+  return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// gzip_decompress
+// inflate a gzip container; -1 if the data is not a complete gzip stream
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static int gzip_decompress(const std::string& data, std::string& out)
+{
+  z_stream zs = {};
+  if (inflateInit2(&zs, 15 + 16) != Z_OK)
+  {
+    return -1;
+  }
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  zs.avail_in = static_cast<uInt>(data.size());
+
+  out.clear();
+  char buf[16384];
+  int ret = Z_OK;
+  while (ret == Z_OK)
+  {
+    zs.next_out = reinterpret_cast<Bytef*>(buf);
+    zs.avail_out = sizeof(buf);
+    ret = inflate(&zs, Z_NO_FLUSH);
+    out.append(buf, sizeof(buf) - zs.avail_out);
+    if (ret == Z_BUF_ERROR && zs.avail_in == 0)
+    {
+      break;
+    }
+  }
+  inflateEnd(&zs);
+  return ret == Z_STREAM_END ? 0 : -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// has_header - true if a response header line starts with name (lower case) and contains value
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool has_header(const std::vector<std::string>& headers, const std::string& name, const std::string& value)
+{
+  for (size_t idx = 0; idx < headers.size(); idx++)
+  {
+    std::string header = headers[idx];
+    std::transform(header.begin(), header.end(), header.begin(), ::tolower);
+    if (header.find(name) == 0 && header.find(value) != std::string::npos)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+  std::string base_url = "https://localhost:8443/MicroStrategyLibrary";
+  size_t nbr_requests = 200;
+  size_t nbr_threads = 1;
+  std::string report_id = "report";
+  std::string cube_id = "cube";
+  std::string project_id = "project";
+
+  for (int idx = 1; idx < argc; idx++)
+  {
+    std::string arg = argv[idx];
+    if (arg == "--requests" && idx + 1 < argc) nbr_requests = std::strtoul(argv[++idx], nullptr, 10);
+    else if (arg == "--threads" && idx + 1 < argc) nbr_threads = std::max<size_t>(1, std::strtoul(argv[++idx], nullptr, 10));
+    else if (arg == "--report" && idx + 1 < argc) report_id = argv[++idx];
+    else if (arg == "--cube" && idx + 1 < argc) cube_id = argv[++idx];
+    else if (arg == "--project" && idx + 1 < argc) project_id = argv[++idx];
+    else base_url = arg;
+  }
+
+  std::string host = base_url;
+  std::string base_path;
+  size_t pos = host.find("://");
+  if (pos != std::string::npos)
+  {
+    host = host.substr(pos + 3);
+  }
+  pos = host.find("/");
+  if (pos != std::string::npos)
+  {
+    base_path = host.substr(pos);
+    host = host.substr(0, pos);
+  }
+
+  null_buffer null_buf;
+  std::streambuf* cout_buf = std::cout.rdbuf(&null_buf);
+
+  Session session;
+  session.base_url = base_url;
+  session.project_id = project_id;
+  if (login(base_url, "replay", "replay", session.auth_token, session.cookies) != 0)
+  {
+    std::cout.rdbuf(cout_buf);
+    std::cerr << "login failed against " << base_url << std::endl;
+    return -1;
+  }
+  session.authenticated = true;
+
+  std::vector<load_result_t> results;
+
+  results.push_back(run("login", nbr_requests, nbr_threads, [&]()
+    {
+      std::string auth_token, cookies;
+      return login(base_url, "replay", "replay", auth_token, cookies);
+    }));
+
+  results.push_back(run("get_projects", nbr_requests, nbr_threads, [&]()
+    {
+      std::string response;
+      return get_projects(base_url, session.auth_token, session.cookies, response);
+    }));
+
+  results.push_back(run("get_report_definition", nbr_requests, nbr_threads, [&]()
+    {
+      std::string response;
+      return get_report_definition(base_url, session.auth_token, session.cookies, project_id, report_id, response);
+    }));
+
+  results.push_back(run("create_cube", nbr_requests, nbr_threads, [&]()
+    {
+      std::string response;
+      return create_cube(base_url, session.auth_token, session.cookies, project_id, cube_id, response);
+    }));
+
+  results.push_back(run("search", nbr_requests, nbr_threads, [&]()
+    {
+      std::string response;
+      return search(session, "", MSTR_REPORT, 100, response);
+    }));
+
+  results.push_back(run("get_library", nbr_requests, nbr_threads, [&]()
+    {
+      std::string response;
+      return get_library(session, 100, response);
+    }));
+
+  results.push_back(run("get_report", nbr_requests, nbr_threads, [&]()
+    {
+      std::string response;
+      return get_report(session, report_id, response);
+    }));
+
+  results.push_back(run("get_cube", nbr_requests, nbr_threads, [&]()
+    {
+      std::string response;
+      return get_cube(session, cube_id, "instance", 0, 1000, response);
+    }));
+
+  results.push_back(run("get_dossiers", nbr_requests, nbr_threads, [&]()
+    {
+      std::string response;
+      return get_dossiers(session, response);
+    }));
+
+  // parsers only, on responses fetched once and kept in memory
+  std::string projects;
+  get_projects(base_url, session.auth_token, session.cookies, projects);
+
+  // same resource as get_projects, asking for a compressed body (start replay_server with --gzip)
+  // the body must come back gzip encoded and inflate to the plain response
+  results.push_back(run("get_projects gzip", nbr_requests, nbr_threads, [&]()
+    {
+      std::stringstream http;
+      http << "GET " << base_path << "/api/projects HTTP/1.1\r\n";
+      http << "Host: " << host << "\r\n";
+      http << "Accept: application/json\r\n";
+      http << "Accept-Encoding: gzip\r\n";
+      http << "X-MSTR-AuthToken: " << session.auth_token << "\r\n";
+      http << "Connection: close\r\n\r\n";
+      std::string response;
+      std::vector<std::string> headers;
+      if (ssl_read(host, "443", http.str(), response, headers) != 0 || !has_header(headers, "content-encoding:", "gzip"))
+      {
+        return -1;
+      }
+      std::string body;
+      if (gzip_decompress(response, body) < 0 || body != projects)
+      {
+        return -1;
+      }
+      return 0;
+    }));
+
+  results.push_back(run("parse_projects", nbr_requests, nbr_threads, [&]()
+    {
+      return parse_projects(projects).empty() ? -1 : 0;
+    }));
+
+  std::string library;
+  get_library(session, 100, library);
+  results.push_back(run("parse_library_items", nbr_requests, nbr_threads, [&]()
+    {
+      return parse_library_items(library).empty() ? -1 : 0;
+    }));
+
+  results.push_back(run("logout", nbr_requests, nbr_threads, [&]()
+    {
+      return logout(base_url, session.auth_token, session.cookies);
+    }));
+
+  std::cout.rdbuf(cout_buf);
+
+  std::cout << base_url << ", " << nbr_requests << " requests, " << nbr_threads << " threads" << std::endl;
+  char line[160];
+  snprintf(line, sizeof(line), "%-24s %8s %7s %10s %9s %9s", "function", "requests", "errors", "req/sec", "p50 ms", "p99 ms");
+  std::cout << line << std::endl;
+  for (size_t idx = 0; idx < results.size(); idx++)
+  {
+    const load_result_t& r = results[idx];
+    snprintf(line, sizeof(line), "%-24s %8zu %7zu %10.1f %9.3f %9.3f", r.name.c_str(), r.requests, r.errors,
+      r.seconds > 0 ? r.requests / r.seconds : 0.0, r.p50_ms, r.p99_ms);
+    std::cout << line << std::endl;
+  }
+  return 0;
+}
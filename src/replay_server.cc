@@ -0,0 +1,433 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <zlib.h>
+#include "asio.hpp"
+#include "asio/ssl.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// replay_server
+// local TLS stand-in for the MicroStrategy REST API, serves recorded responses so that ssl_read
+// and the parsers can be benchmarked offline (see replay_load.cc)
+//
+// Recordings are the files the client already writes:
+//   POST /api/auth/login                 login_response.json (plus auth token and cookie headers)
+//   GET  /api/projects                   projects.json
+//   GET  /api/model/reports/{id}         report_{id}.json
+//   POST /api/cubes/{id}/instances       cube_instance_{id}.json
+//   POST /api/auth/logout                204, no body
+// any other path is served from its path below /api/ with '/' replaced by '_',
+// e.g. GET /api/library?limit=10 -> library.json; a missing recording is a 404
+//
+// Usage:
+//   openssl req -x509 -newkey rsa:2048 -nodes -days 365 -subj /CN=localhost -keyout key.pem -out cert.pem
+//   replay_server --cert cert.pem --key key.pem [--port 8443] [--dir .]
+//     [--latency ms] [--bandwidth bytes_per_sec] [--chunked [chunk_size]] [--gzip]
+//
+//   --latency     delay before each response
+//   --bandwidth   pace the response bytes to this rate (0 = unlimited)
+//   --chunked     send bodies with Transfer-Encoding: chunked
+//   --gzip        compress bodies when the request has Accept-Encoding: gzip
+//
+// Point the client at https://localhost:8443/MicroStrategyLibrary
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef asio::ssl::stream<asio::ip::tcp::socket> ssl_socket_t;
+
+struct replay_config_t
+{
+  std::string port = "8443";
+  std::string dir = ".";
+  std::string cert;
+  std::string key;
+  int latency_ms = 0;
+  size_t bandwidth = 0;
+  bool chunked = false;
+  size_t chunk_size = 16384;
+  bool gzip = false;
+};
+
+static replay_config_t config;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// recording cache
+// files are read once; the gzip variant is built on first use
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct recording_t
+{
+  bool found = false;
+  std::string body;
+  std::string body_gzip;
+};
+
+static std::mutex cache_mutex;
+static std::map<std::string, recording_t> cache;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// gzip_compress - gzip container (deflate with a gzip header), default compression level
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::string gzip_compress(const std::string& data)
+{
+  z_stream zs = {};
+  if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+  {
+    return "";
+  }
+
+  std::string out;
+  out.resize(deflateBound(&zs, static_cast<uLong>(data.size())));
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  zs.avail_in = static_cast<uInt>(data.size());
+  zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+  zs.avail_out = static_cast<uInt>(out.size());
+  deflate(&zs, Z_FINISH);
+  out.resize(zs.total_out);
+  deflateEnd(&zs);
+  return out;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_recording
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static const recording_t& get_recording(const std::string& file_name, bool gzip)
+{
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  std::map<std::string, recording_t>::iterator it = cache.find(file_name);
+  if (it == cache.end())
+  {
+    recording_t recording;
+    std::ifstream ifs(config.dir + "/" + file_name, std::ios::binary);
+    if (ifs.is_open())
+    {
+      std::stringstream buf;
+      buf << ifs.rdbuf();
+      recording.body = buf.str();
+      recording.found = true;
+    }
+    it = cache.emplace(file_name, std::move(recording)).first;
+  }
+  if (gzip && it->second.found && it->second.body_gzip.empty())
+  {
+    it->second.body_gzip = gzip_compress(it->second.body);
+  }
+  return it->second;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// route
+// maps method + path to a recording file name; empty for a response without body
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::string segment(const std::string& path, size_t pos)
+{
+  size_t end = path.find('/', pos);
+  return path.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+}
+
+static std::string route(const std::string& method, const std::string& target)
+{
+  std::string path = target.substr(0, target.find('?'));
+  size_t pos = path.find("/api/");
+  if (pos == std::string::npos)
+  {
+    return "not_recorded";
+  }
+  path = path.substr(pos + 5);
+
+  if (method == "POST" && path == "auth/login")
+  {
+    return "login_response.json";
+  }
+  if (method == "POST" && path == "auth/logout")
+  {
+    return "";
+  }
+  if (method == "GET" && path == "projects")
+  {
+    return "projects.json";
+  }
+  if (method == "GET" && path.find("model/reports/") == 0)
+  {
+    return "report_" + segment(path, 14) + ".json";
+  }
+  if (method == "POST" && path.find("cubes/") == 0 && path.size() > 16 &&
+    path.compare(path.size() - 10, 10, "/instances") == 0)
+  {
+    return "cube_instance_" + segment(path, 6) + ".json";
+  }
+
+  std::replace(path.begin(), path.end(), '/', '_');
+  return path + ".json";
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// write_paced
+// writes data in slices, sleeping so that the average rate stays at --bandwidth
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void write_paced(ssl_socket_t& sock, const char* data, size_t size,
+  std::chrono::steady_clock::time_point start, size_t& sent)
+{
+  if (config.bandwidth == 0)
+  {
+    asio::write(sock, asio::buffer(data, size));
+    sent += size;
+    return;
+  }
+
+  const size_t slice = std::max<size_t>(1024, std::min<size_t>(16384, config.bandwidth / 20));
+  size_t pos = 0;
+  while (pos < size)
+  {
+    size_t count = std::min(slice, size - pos);
+    asio::write(sock, asio::buffer(data + pos, count));
+    pos += count;
+    sent += count;
+    std::chrono::duration<double> due(static_cast<double>(sent) / config.bandwidth);
+    std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(due));
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// read_request
+// reads the request line and headers, then discards the body (Content-Length or chunked)
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void read_request(ssl_socket_t& sock, std::string& method, std::string& target, std::vector<std::string>& headers)
+{
+  asio::streambuf sbuf;
+  asio::read_until(sock, sbuf, "\r\n\r\n");
+  std::istream is(&sbuf);
+  std::string line;
+  std::getline(is, line);
+  std::stringstream request_line(line);
+  request_line >> method >> target;
+
+  size_t content_length = 0;
+  bool chunked = false;
+  while (std::getline(is, line) && line != "\r")
+  {
+    std::string lower = line;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower.find("content-length:") == 0)
+    {
+      content_length = std::strtoul(line.c_str() + 15, nullptr, 10);
+    }
+    else if (lower.find("transfer-encoding:") == 0 && lower.find("chunked") != std::string::npos)
+    {
+      chunked = true;
+    }
+    headers.push_back(lower);
+  }
+
+  if (chunked)
+  {
+    while (true)
+    {
+      asio::read_until(sock, sbuf, "\r\n");
+      std::getline(is, line);
+      size_t size = std::strtoul(line.c_str(), nullptr, 16);
+      if (size == 0)
+      {
+        asio::read_until(sock, sbuf, "\r\n");
+        std::getline(is, line);
+        break;
+      }
+      if (sbuf.size() < size + 2)
+      {
+        asio::read(sock, sbuf, asio::transfer_exactly(size + 2 - sbuf.size()));
+      }
+      sbuf.consume(size + 2);
+    }
+  }
+  else if (sbuf.size() < content_length)
+  {
+    asio::read(sock, sbuf, asio::transfer_exactly(content_length - sbuf.size()));
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// serve - one request per connection (clients send Connection: close)
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void serve(ssl_socket_t* sock)
+{
+  try
+  {
+    sock->handshake(ssl_socket_t::server);
+
+    std::string method;
+    std::string target;
+    std::vector<std::string> request_headers;
+    read_request(*sock, method, target, request_headers);
+
+    bool accept_gzip = false;
+    for (size_t idx = 0; idx < request_headers.size(); idx++)
+    {
+      if (request_headers[idx].find("accept-encoding:") == 0 && request_headers[idx].find("gzip") != std::string::npos)
+      {
+        accept_gzip = true;
+      }
+    }
+    bool gzip = config.gzip && accept_gzip;
+
+    std::string file_name = route(method, target);
+    const std::string* body = nullptr;
+    std::stringstream http;
+    if (file_name.empty())
+    {
+      http << "HTTP/1.1 204 No Content\r\n";
+    }
+    else
+    {
+      const recording_t& recording = get_recording(file_name, gzip);
+      if (recording.found)
+      {
+        http << "HTTP/1.1 200 OK\r\n";
+        body = gzip ? &recording.body_gzip : &recording.body;
+        if (gzip)
+        {
+          http << "Content-Encoding: gzip\r\n";
+        }
+      }
+      else
+      {
+        http << "HTTP/1.1 404 Not Found\r\n";
+      }
+    }
+
+    if (file_name == "login_response.json")
+    {
+      http << "X-MSTR-AuthToken: replay-token\r\n";
+      http << "Set-Cookie: JSESSIONID=replay; Path=/; Secure\r\n";
+    }
+    http << "Content-Type: application/json\r\n";
+    if (body && config.chunked)
+    {
+      http << "Transfer-Encoding: chunked\r\n";
+    }
+    else
+    {
+      http << "Content-Length: " << (body ? body->size() : 0) << "\r\n";
+    }
+    http << "Connection: close\r\n\r\n";
+
+    std::cout << method << " " << target << " -> " << (file_name.empty() ? "204" : file_name) << std::endl;
+
+    if (config.latency_ms > 0)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(config.latency_ms));
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t sent = 0;
+    std::string header = http.str();
+    write_paced(*sock, header.data(), header.size(), start, sent);
+
+    if (body && config.chunked)
+    {
+      for (size_t pos = 0; pos < body->size(); pos += config.chunk_size)
+      {
+        size_t size = std::min(config.chunk_size, body->size() - pos);
+        char size_line[20];
+        int len = snprintf(size_line, sizeof(size_line), "%zx\r\n", size);
+        write_paced(*sock, size_line, len, start, sent);
+        write_paced(*sock, body->data() + pos, size, start, sent);
+        write_paced(*sock, "\r\n", 2, start, sent);
+      }
+      write_paced(*sock, "0\r\n\r\n", 5, start, sent);
+    }
+    else if (body)
+    {
+      write_paced(*sock, body->data(), body->size(), start, sent);
+    }
+
+    std::error_code ec;
+    sock->shutdown(ec);
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "Connection error: " << e.what() << std::endl;
+  }
+  delete sock;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+  for (int idx = 1; idx < argc; idx++)
+  {
+    std::string arg = argv[idx];
+    bool has_value = idx + 1 < argc && argv[idx + 1][0] != '-';
+    if (arg == "--port" && has_value) config.port = argv[++idx];
+    else if (arg == "--dir" && has_value) config.dir = argv[++idx];
+    else if (arg == "--cert" && has_value) config.cert = argv[++idx];
+    else if (arg == "--key" && has_value) config.key = argv[++idx];
+    else if (arg == "--latency" && has_value) config.latency_ms = std::atoi(argv[++idx]);
+    else if (arg == "--bandwidth" && has_value) config.bandwidth = std::strtoul(argv[++idx], nullptr, 10);
+    else if (arg == "--gzip") config.gzip = true;
+    else if (arg == "--chunked")
+    {
+      config.chunked = true;
+      if (has_value) config.chunk_size = std::max<size_t>(1, std::strtoul(argv[++idx], nullptr, 10));
+    }
+    else
+    {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return -1;
+    }
+  }
+
+  if (config.cert.empty() || config.key.empty())
+  {
+    std::cerr << "usage: replay_server --cert cert.pem --key key.pem [--port 8443] [--dir .]" << std::endl;
+    std::cerr << "  [--latency ms] [--bandwidth bytes_per_sec] [--chunked [chunk_size]] [--gzip]" << std::endl;
+    return -1;
+  }
+
+  try
+  {
+    asio::io_service io_service;
+    asio::ssl::context context(asio::ssl::context::tlsv12_server);
+    context.use_certificate_chain_file(config.cert);
+    context.use_private_key_file(config.key, asio::ssl::context::pem);
+
+    asio::ip::tcp::acceptor acceptor(io_service,
+      asio::ip::tcp::endpoint(asio::ip::tcp::v4(), static_cast<unsigned short>(std::atoi(config.port.c_str()))));
+
+    std::cout << "Replaying " << config.dir << " on port " << config.port
+      << " latency " << config.latency_ms << " ms"
+      << " bandwidth " << config.bandwidth << " B/s"
+      << (config.chunked ? " chunked" : "")
+      << (config.gzip ? " gzip" : "") << std::endl;
+
+    while (true)
+    {
+      ssl_socket_t* sock = new ssl_socket_t(io_service, context);
+      acceptor.accept(sock->lowest_layer());
+      sock->lowest_layer().set_option(asio::ip::tcp::no_delay(true));
+      std::thread(serve, sock).detach();
+    }
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}
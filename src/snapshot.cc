@@ -0,0 +1,761 @@
+#include "snapshot.hh"
+#include "db_interface.hh"
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <limits>
+
+// groups above which the partial aggregates of a thread are a hash map instead of an array
+// (2 MB of aggregate_t), unless the array is no larger than one code column of the thread's rows
+// (GROUP_BY_DENSE_BYTES_PER_ROW each), so that the arrays of all threads together never take
+// more memory than one column of the snapshot
+const uint64_t GROUP_BY_DENSE_MAX = 1 << 16;
+const uint64_t GROUP_BY_DENSE_BYTES_PER_ROW = sizeof(uint32_t);
+// rows whose group numbers are computed together, one column at a time
+const size_t GROUP_BY_BLOCK = 1024;
+// rows per thread at least, smaller snapshots use fewer threads
+const size_t GROUP_BY_THREAD_ROWS = 256 * 1024;
+
+// the published snapshot, read and replaced only with std::atomic_load / std::atomic_store
+static std::shared_ptr<const FinMartSnapshot> current_snapshot;
+static std::mutex refresh_mutex;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// finmart_snapshot
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const FinMartSnapshot> finmart_snapshot()
+{
+  return std::atomic_load(&current_snapshot);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// refresh_finmart_snapshot
+// the new snapshot is built aside while readers keep using the current one; the old one is
+// freed when its last reader lets it go
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int refresh_finmart_snapshot(IFinMartDatabase* db)
+{
+  if (!db)
+  {
+    return -1;
+  }
+  std::lock_guard<std::mutex> lock(refresh_mutex);
+  std::shared_ptr<const FinMartSnapshot> snapshot = FinMartSnapshot::load(*db, db->get_backend_name());
+  if (!snapshot)
+  {
+    return -1;
+  }
+  std::atomic_store(&current_snapshot, snapshot);
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// dictionary_column_t::append
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FinMartSnapshot::dictionary_column_t::append(std::string_view value)
+{
+  std::string key(value);
+  std::unordered_map<std::string, uint32_t>::const_iterator it = index.find(key);
+  if (it != index.end())
+  {
+    codes.push_back(it->second);
+    return;
+  }
+  uint32_t code = static_cast<uint32_t>(values.size());
+  values.push_back(key);
+  index.emplace(key, code);
+  codes.push_back(code);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// add_transaction - rows arrive latest first, the order of the columns
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FinMartSnapshot::add_transaction(const transaction_view& t)
+{
+  ids.push_back(t.id);
+  amounts.push_back(t.amount);
+  dates.append(t.date);
+  departments.append(t.department);
+  categories.append(t.category);
+  vendors.append(t.vendor);
+  statuses.append(t.status);
+  source_systems.append(t.source_system);
+  total_spending += t.amount;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// add_financial_record
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FinMartSnapshot::add_financial_record(const financial_record_view& r)
+{
+  records.push_back(r.to_record());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// finish
+// drops the load-time indexes and orders the records for get_financial_records_by_company
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FinMartSnapshot::finish()
+{
+  dictionary_column_t* columns[] = { &dates, &departments, &categories, &vendors, &statuses, &source_systems };
+  for (size_t idx = 0; idx < sizeof(columns) / sizeof(columns[0]); idx++)
+  {
+    std::unordered_map<std::string, uint32_t>().swap(columns[idx]->index);
+  }
+  std::stable_sort(records.begin(), records.end(), [](const FinancialRecord& a, const FinancialRecord& b)
+    {
+      return a.company_id < b.company_id || (a.company_id == b.company_id && a.period < b.period);
+    });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// equal_mask - flags of the codes whose value is value; empty (no condition) if value is not set
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::vector<char> equal_mask(const std::vector<std::string>& values, const std::optional<std::string>& value)
+{
+  std::vector<char> mask;
+  if (!value)
+  {
+    return mask;
+  }
+  mask.resize(values.size());
+  for (size_t idx = 0; idx < values.size(); idx++)
+  {
+    mask[idx] = values[idx] == *value;
+  }
+  return mask;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// compile
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FinMartSnapshot::row_filter_t FinMartSnapshot::compile(const transaction_filter& filter) const
+{
+  row_filter_t compiled;
+  if (filter.date_from || filter.date_to)
+  {
+    compiled.date.resize(dates.values.size());
+    for (size_t idx = 0; idx < dates.values.size(); idx++)
+    {
+      const std::string& date = dates.values[idx];
+      compiled.date[idx] = (!filter.date_from || date >= *filter.date_from) && (!filter.date_to || date <= *filter.date_to);
+    }
+  }
+  compiled.department = equal_mask(departments.values, filter.department);
+  compiled.category = equal_mask(categories.values, filter.category);
+  compiled.status = equal_mask(statuses.values, filter.status);
+  compiled.source_system = equal_mask(source_systems.values, filter.source_system);
+  compiled.amount_min = filter.amount_min;
+  compiled.amount_max = filter.amount_max;
+  return compiled;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// matches
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool FinMartSnapshot::matches(const row_filter_t& filter, size_t row) const
+{
+  if (!filter.date.empty() && !filter.date[dates.codes[row]]) return false;
+  if (!filter.department.empty() && !filter.department[departments.codes[row]]) return false;
+  if (!filter.category.empty() && !filter.category[categories.codes[row]]) return false;
+  if (!filter.status.empty() && !filter.status[statuses.codes[row]]) return false;
+  if (!filter.source_system.empty() && !filter.source_system[source_systems.codes[row]]) return false;
+  if (filter.amount_min && amounts[row] < *filter.amount_min) return false;
+  if (filter.amount_max && amounts[row] > *filter.amount_max) return false;
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// row_view - text columns point into the dictionaries, valid as long as the snapshot
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+transaction_view FinMartSnapshot::row_view(size_t row) const
+{
+  transaction_view t;
+  t.id = ids[row];
+  t.date = dates.value(row);
+  t.department = departments.value(row);
+  t.category = categories.value(row);
+  t.vendor = vendors.value(row);
+  t.amount = amounts[row];
+  t.status = statuses.value(row);
+  t.source_system = source_systems.value(row);
+  return t;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// seek
+// first row after the cursor: binary search on (date, id), the order of the rows
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+size_t FinMartSnapshot::seek(const transaction_cursor& after) const
+{
+  if (after.is_start())
+  {
+    return 0;
+  }
+  size_t lo = 0;
+  size_t hi = ids.size();
+  while (lo < hi)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    const std::string& date = dates.value(mid);
+    if (date > after.date || (date == after.date && ids[mid] >= after.id))
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_department_spending
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::map<std::string, double> FinMartSnapshot::get_department_spending() const
+{
+  groups_t groups = group_by({ DEPARTMENT });
+  std::map<std::string, double> spending;
+  for (size_t idx = 0; idx < groups.size(); idx++)
+  {
+    spending[std::string(groups[idx].key[0])] = groups[idx].aggregate.sum;
+  }
+  return spending;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_source_system_counts
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::map<std::string, int> FinMartSnapshot::get_source_system_counts() const
+{
+  groups_t groups = group_by({ SOURCE_SYSTEM });
+  std::map<std::string, int> counts;
+  for (size_t idx = 0; idx < groups.size(); idx++)
+  {
+    counts[std::string(groups[idx].key[0])] = static_cast<int>(groups[idx].aggregate.count);
+  }
+  return counts;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_daily_spending - amount per day between date_from and date_to (inclusive)
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::map<std::string, double> FinMartSnapshot::get_daily_spending(const std::string& date_from, const std::string& date_to) const
+{
+  transaction_filter filter;
+  filter.date_from = date_from;
+  filter.date_to = date_to;
+  groups_t groups = group_by({ DATE }, filter);
+  std::map<std::string, double> spending;
+  for (size_t idx = 0; idx < groups.size(); idx++)
+  {
+    spending[std::string(groups[idx].key[0])] = groups[idx].aggregate.sum;
+  }
+  return spending;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// column - dictionary column of a dimension
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const FinMartSnapshot::dictionary_column_t& FinMartSnapshot::column(dimension_t dimension) const
+{
+  switch (dimension)
+  {
+  case DATE: return dates;
+  case DEPARTMENT: return departments;
+  case CATEGORY: return categories;
+  case VENDOR: return vendors;
+  case STATUS: return statuses;
+  case SOURCE_SYSTEM: break;
+  }
+  return source_systems;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// empty_aggregate - min and max start at the identities of min and max
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static FinMartSnapshot::aggregate_t empty_aggregate()
+{
+  FinMartSnapshot::aggregate_t aggregate;
+  aggregate.min = std::numeric_limits<double>::infinity();
+  aggregate.max = -std::numeric_limits<double>::infinity();
+  return aggregate;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// add_amount
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline void add_amount(FinMartSnapshot::aggregate_t& aggregate, double amount)
+{
+  aggregate.count++;
+  aggregate.sum += amount;
+  aggregate.min = std::min(amount, aggregate.min);
+  aggregate.max = std::max(amount, aggregate.max);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// merge_aggregate
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void merge_aggregate(FinMartSnapshot::aggregate_t& into, const FinMartSnapshot::aggregate_t& from)
+{
+  if (from.count == 0)
+  {
+    return;
+  }
+  into.count += from.count;
+  into.sum += from.sum;
+  into.min = std::min(into.min, from.min);
+  into.max = std::max(into.max, from.max);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// mask_codes - clears the rows whose code is not flagged; no condition if flags is empty
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline void mask_codes(unsigned char* mask, size_t count, const std::vector<char>& flags, const uint32_t* codes)
+{
+  if (flags.empty())
+  {
+    return;
+  }
+  const char* flag = flags.data();
+  for (size_t idx = 0; idx < count; idx++)
+  {
+    mask[idx] &= flag[codes[idx]];
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// mask_rows
+// the filter over count rows from begin, one condition at a time over the whole block: mask[idx]
+// is 1 if row begin + idx matches, 0 otherwise. Same rows as matches(), without a branch per row
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FinMartSnapshot::mask_rows(const row_filter_t& filter, size_t begin, size_t count, unsigned char* mask) const
+{
+  std::fill(mask, mask + count, static_cast<unsigned char>(1));
+  mask_codes(mask, count, filter.date, dates.codes.data() + begin);
+  mask_codes(mask, count, filter.department, departments.codes.data() + begin);
+  mask_codes(mask, count, filter.category, categories.codes.data() + begin);
+  mask_codes(mask, count, filter.status, statuses.codes.data() + begin);
+  mask_codes(mask, count, filter.source_system, source_systems.codes.data() + begin);
+  const double* values = amounts.data() + begin;
+  if (filter.amount_min)
+  {
+    double amount_min = *filter.amount_min;
+    for (size_t idx = 0; idx < count; idx++)
+    {
+      mask[idx] &= values[idx] >= amount_min;
+    }
+  }
+  if (filter.amount_max)
+  {
+    double amount_max = *filter.amount_max;
+    for (size_t idx = 0; idx < count; idx++)
+    {
+      mask[idx] &= values[idx] <= amount_max;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// aggregate
+// kernel of group_by over task.begin..task.end, a block of GROUP_BY_BLOCK rows at a time:
+// the group numbers are summed one column at a time (code * stride over contiguous arrays);
+// with a filter, the block's mask is built the same way and the matching keys and amounts are
+// compacted to the front (every row is written, the count advances by its mask); then each
+// key adds its amount to the partial of its group. No loop branches per row, the scatter into
+// the partials is the only access that is not sequential
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FinMartSnapshot::aggregate(group_task_t& task, const std::vector<const dictionary_column_t*>& columns,
+  const std::vector<uint64_t>& strides, const row_filter_t* filter) const
+{
+  uint64_t keys[GROUP_BY_BLOCK];
+  double selected[GROUP_BY_BLOCK];
+  unsigned char mask[GROUP_BY_BLOCK];
+  for (size_t block = task.begin; block < task.end; block += GROUP_BY_BLOCK)
+  {
+    size_t nbr_keys = std::min(GROUP_BY_BLOCK, task.end - block);
+    const uint32_t* codes = columns[0]->codes.data() + block;
+    for (size_t idx = 0; idx < nbr_keys; idx++)
+    {
+      keys[idx] = codes[idx];
+    }
+    for (size_t col = 1; col < columns.size(); col++)
+    {
+      codes = columns[col]->codes.data() + block;
+      uint64_t stride = strides[col];
+      for (size_t idx = 0; idx < nbr_keys; idx++)
+      {
+        keys[idx] += codes[idx] * stride;
+      }
+    }
+
+    const double* values = amounts.data() + block;
+    if (filter)
+    {
+      mask_rows(*filter, block, nbr_keys, mask);
+      size_t nbr_selected = 0;
+      for (size_t idx = 0; idx < nbr_keys; idx++)
+      {
+        keys[nbr_selected] = keys[idx];
+        selected[nbr_selected] = values[idx];
+        nbr_selected += mask[idx];
+      }
+      nbr_keys = nbr_selected;
+      values = selected;
+    }
+
+    if (!task.dense.empty())
+    {
+      aggregate_t* partials = task.dense.data();
+      for (size_t idx = 0; idx < nbr_keys; idx++)
+      {
+        add_amount(partials[keys[idx]], values[idx]);
+      }
+    }
+    else
+    {
+      for (size_t idx = 0; idx < nbr_keys; idx++)
+      {
+        add_amount(task.sparse.try_emplace(keys[idx], empty_aggregate()).first->second, values[idx]);
+      }
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// group_by_pool_t
+// worker threads of group_by, started by the first parallel call and kept until the process
+// exits, one less than the hardware threads (the caller is the other one). run() queues the
+// tasks, runs the first on the calling thread, then runs queued tasks (of any call) until its
+// own are done; concurrent calls share the workers
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class group_by_pool_t
+{
+public:
+  group_by_pool_t(size_t nbr_workers);
+  ~group_by_pool_t();
+  void run(const std::vector<std::function<void()>>& tasks);
+
+private:
+  struct batch_t
+  {
+    size_t pending;
+  };
+  struct job_t
+  {
+    const std::function<void()>* task;
+    batch_t* batch;
+  };
+  void work();
+  void finish(job_t job, std::unique_lock<std::mutex>& lock);
+
+  std::mutex mutex;
+  std::condition_variable queued;
+  std::condition_variable done;
+  std::deque<job_t> jobs;
+  std::vector<std::thread> workers;
+  bool stop;
+};
+
+static group_by_pool_t& group_by_pool()
+{
+  static group_by_pool_t pool(std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1);
+  return pool;
+}
+
+group_by_pool_t::group_by_pool_t(size_t nbr_workers) : stop(false)
+{
+  for (size_t idx = 0; idx < nbr_workers; idx++)
+  {
+    workers.emplace_back(&group_by_pool_t::work, this);
+  }
+}
+
+group_by_pool_t::~group_by_pool_t()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  queued.notify_all();
+  for (size_t idx = 0; idx < workers.size(); idx++)
+  {
+    workers[idx].join();
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// group_by_pool_t::finish - runs a job unlocked, then counts it done for its caller
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void group_by_pool_t::finish(job_t job, std::unique_lock<std::mutex>& lock)
+{
+  lock.unlock();
+  (*job.task)();
+  lock.lock();
+  if (--job.batch->pending == 0)
+  {
+    done.notify_all();
+  }
+}
+
+void group_by_pool_t::work()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+  {
+    queued.wait(lock, [this]() { return stop || !jobs.empty(); });
+    if (jobs.empty())
+    {
+      return;
+    }
+    job_t job = jobs.front();
+    jobs.pop_front();
+    finish(job, lock);
+  }
+}
+
+void group_by_pool_t::run(const std::vector<std::function<void()>>& tasks)
+{
+  if (tasks.empty())
+  {
+    return;
+  }
+  batch_t batch;
+  batch.pending = tasks.size() - 1;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t idx = 1; idx < tasks.size(); idx++)
+    {
+      jobs.push_back(job_t{ &tasks[idx], &batch });
+    }
+  }
+  queued.notify_all();
+  tasks[0]();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (batch.pending > 0)
+  {
+    if (jobs.empty())
+    {
+      done.wait(lock);
+      continue;
+    }
+    job_t job = jobs.front();
+    jobs.pop_front();
+    finish(job, lock);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// group_by
+// the group number of a row is sum(code[d] * stride[d]), stride[d] the product of the
+// cardinalities of the dimensions before d; it is decoded back into values for the result
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FinMartSnapshot::groups_t FinMartSnapshot::group_by(const std::vector<dimension_t>& dimensions,
+  const transaction_filter& filter, size_t nbr_threads) const
+{
+  groups_t groups;
+  if (dimensions.empty())
+  {
+    return groups;
+  }
+
+  std::vector<const dictionary_column_t*> columns;
+  std::vector<uint64_t> strides;
+  uint64_t nbr_groups = 1;
+  for (size_t idx = 0; idx < dimensions.size(); idx++)
+  {
+    columns.push_back(&column(dimensions[idx]));
+    strides.push_back(nbr_groups);
+    uint64_t cardinality = std::max<uint64_t>(columns.back()->values.size(), 1);
+    if (nbr_groups > std::numeric_limits<uint64_t>::max() / cardinality)
+    {
+      return groups; // more combinations than a 64-bit group number holds
+    }
+    nbr_groups *= cardinality;
+  }
+
+  row_filter_t compiled = compile(filter);
+  bool filtered = !compiled.date.empty() || !compiled.department.empty() || !compiled.category.empty() ||
+    !compiled.status.empty() || !compiled.source_system.empty() || compiled.amount_min || compiled.amount_max;
+
+  size_t nbr_rows = ids.size();
+  if (nbr_threads == 0)
+  {
+    nbr_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+  nbr_threads = std::max<size_t>(std::min(nbr_threads, nbr_rows / GROUP_BY_THREAD_ROWS), 1);
+
+  // same layout for every thread, so that partials merge index by index
+  uint64_t dense_budget = (nbr_rows / nbr_threads) * GROUP_BY_DENSE_BYTES_PER_ROW / sizeof(aggregate_t);
+  bool dense = nbr_groups <= std::max<uint64_t>(GROUP_BY_DENSE_MAX, dense_budget);
+  std::vector<group_task_t> tasks(nbr_threads);
+  for (size_t idx = 0; idx < nbr_threads; idx++)
+  {
+    tasks[idx].begin = nbr_rows * idx / nbr_threads;
+    tasks[idx].end = nbr_rows * (idx + 1) / nbr_threads;
+    if (dense)
+    {
+      tasks[idx].dense.assign(static_cast<size_t>(nbr_groups), empty_aggregate());
+    }
+  }
+
+  const row_filter_t* row_filter = filtered ? &compiled : nullptr;
+  if (nbr_threads == 1)
+  {
+    aggregate(tasks[0], columns, strides, row_filter);
+  }
+  else
+  {
+    std::vector<std::function<void()>> work;
+    for (size_t idx = 0; idx < nbr_threads; idx++)
+    {
+      group_task_t* task = &tasks[idx];
+      work.push_back([this, task, &columns, &strides, row_filter]()
+        {
+          aggregate(*task, columns, strides, row_filter);
+        });
+    }
+    group_by_pool().run(work);
+  }
+
+  group_task_t& total = tasks[0];
+  for (size_t idx = 1; idx < tasks.size(); idx++)
+  {
+    for (size_t group = 0; group < total.dense.size(); group++)
+    {
+      merge_aggregate(total.dense[group], tasks[idx].dense[group]);
+    }
+    for (std::unordered_map<uint64_t, aggregate_t>::const_iterator it = tasks[idx].sparse.begin(); it != tasks[idx].sparse.end(); ++it)
+    {
+      merge_aggregate(total.sparse.try_emplace(it->first, empty_aggregate()).first->second, it->second);
+    }
+  }
+
+  std::vector<std::pair<uint64_t, const aggregate_t*>> found;
+  for (size_t group = 0; group < total.dense.size(); group++)
+  {
+    if (total.dense[group].count > 0)
+    {
+      found.push_back(std::make_pair(static_cast<uint64_t>(group), &total.dense[group]));
+    }
+  }
+  for (std::unordered_map<uint64_t, aggregate_t>::const_iterator it = total.sparse.begin(); it != total.sparse.end(); ++it)
+  {
+    found.push_back(std::make_pair(it->first, &it->second));
+  }
+
+  std::sort(found.begin(), found.end());
+
+  groups.resize(found.size());
+  for (size_t idx = 0; idx < found.size(); idx++)
+  {
+    std::vector<std::string_view>& key = groups[idx].key;
+    key.resize(columns.size());
+    uint64_t group = found[idx].first;
+    for (size_t col = 0; col < columns.size(); col++)
+    {
+      uint64_t cardinality = std::max<uint64_t>(columns[col]->values.size(), 1);
+      key[col] = columns[col]->values[static_cast<size_t>(group % cardinality)];
+      group /= cardinality;
+    }
+    groups[idx].aggregate = *found[idx].second;
+  }
+  return groups;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_transactions_page
+// same rows and cursor as the database: seeks to the cursor, then scans for page_size matching
+// rows and one more to know whether another page follows
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+transaction_page FinMartSnapshot::get_transactions_page(const transaction_filter& filter, const transaction_cursor& after,
+  size_t page_size) const
+{
+  transaction_page page;
+  if (page_size == 0) return page;
+
+  row_filter_t compiled = compile(filter);
+  page.rows.reserve(page_size);
+  for (size_t row = seek(after); row < ids.size(); row++)
+  {
+    if (!matches(compiled, row))
+    {
+      continue;
+    }
+    if (page.rows.size() == page_size)
+    {
+      page.has_more = true;
+      break;
+    }
+    page.rows.push_back(row_view(row).to_transaction());
+  }
+
+  if (!page.rows.empty())
+  {
+    page.next.date = page.rows.back().date;
+    page.next.id = page.rows.back().id;
+  }
+  return page;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// for_each_transaction
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int FinMartSnapshot::for_each_transaction(const transaction_filter& filter, const std::function<bool(const transaction_view&)>& visit) const
+{
+  row_filter_t compiled = compile(filter);
+  for (size_t row = 0; row < ids.size(); row++)
+  {
+    if (matches(compiled, row) && !visit(row_view(row)))
+    {
+      return 0;
+    }
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_financial_records_by_company
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<FinancialRecord> FinMartSnapshot::get_financial_records_by_company(const std::string& company_id) const
+{
+  std::vector<FinancialRecord>::const_iterator first = std::lower_bound(records.begin(), records.end(), company_id,
+    [](const FinancialRecord& r, const std::string& company) { return r.company_id < company; });
+  std::vector<FinancialRecord>::const_iterator last = first;
+  while (last != records.end() && last->company_id == company_id)
+  {
+    ++last;
+  }
+  return std::vector<FinancialRecord>(first, last);
+}
@@ -0,0 +1,213 @@
+#ifndef SNAPSHOT_HH
+#define SNAPSHOT_HH
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
+#include "finmart.h"
+#include "metrics.hh"
+
+class IFinMartDatabase;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// FinMartSnapshot
+// immutable in-memory copy of transactions and financial_records, shared by all sessions
+// transactions are stored by column in (date DESC, id DESC) order: ids and amounts as arrays,
+// the text columns as dictionary codes (values are few: departments, statuses, dates), so
+// totals, group-bys and filters are loops over contiguous arrays and a filter on a text column
+// is compiled once into a per-code mask. financial records are one array sorted by
+// (company_id, period)
+// the read methods have the names and results of IFinMartDatabase, a view reads the snapshot
+// or a connection with the same code; a snapshot is never modified after load, any number of
+// threads read it without locks
+//
+// group_by aggregates amount (count, sum, min, max) over any combination of the text columns:
+// each row's group is the mixed-radix number of its dictionary codes, so groups are dense
+// integers and the partial aggregates of each thread live in a plain array (a hash map when
+// the combination has more groups than GROUP_BY_DENSE_MAX and the array would be larger than
+// a code column of the thread's rows); the
+// row range is split between the threads of a pool started once per process, each aggregates
+// blocks of rows into its own partials, which are merged at the end. Within a block the filter
+// is a mask built one column at a time and the matching rows are compacted before they are
+// added, the loops have no branch per row
+//
+// Usage:
+//   std::shared_ptr<const FinMartSnapshot> snapshot = finmart_snapshot();
+//   if (snapshot) total = snapshot->get_total_spending();
+//   FinMartSnapshot::groups_t groups = snapshot->group_by({ FinMartSnapshot::DEPARTMENT, FinMartSnapshot::STATUS });
+//   for (size_t idx = 0; idx < groups.size(); idx++) { groups[idx].key[0]; groups[idx].aggregate.sum; ... }
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class FinMartSnapshot
+{
+public:
+  enum dimension_t
+  {
+    DATE,
+    DEPARTMENT,
+    CATEGORY,
+    VENDOR,
+    STATUS,
+    SOURCE_SYSTEM
+  };
+
+  struct aggregate_t
+  {
+    long long count = 0;
+    double sum = 0;
+    double min = 0;
+    double max = 0;
+
+    double avg() const { return count ? sum / count : 0; }
+  };
+
+  // key: the values of the dimensions, in the order they were asked for; they point into the
+  // snapshot and are valid as long as it is
+  struct group_t
+  {
+    std::vector<std::string_view> key;
+    aggregate_t aggregate;
+  };
+
+  typedef std::vector<group_t> groups_t;
+
+  template<typename D>
+  static std::shared_ptr<const FinMartSnapshot> load(D& db, const std::string& source_name);
+
+  size_t nbr_transactions() const { return ids.size(); }
+  size_t nbr_financial_records() const { return records.size(); }
+  std::string get_backend_name() const { return source_name + " snapshot"; }
+
+  double get_total_spending() const { return total_spending; }
+  std::map<std::string, double> get_department_spending() const;
+  std::map<std::string, int> get_source_system_counts() const;
+  std::map<std::string, double> get_daily_spending(const std::string& date_from, const std::string& date_to) const;
+  transaction_page get_transactions_page(const transaction_filter& filter, const transaction_cursor& after,
+    size_t page_size) const;
+  int for_each_transaction(const transaction_filter& filter, const std::function<bool(const transaction_view&)>& visit) const;
+
+  // group_by: aggregates of the transactions matching filter by the dimensions, one group per
+  // combination of values present, in dictionary code order; nbr_threads 0 uses the hardware
+  // threads, fewer are used on small snapshots. Empty if dimensions is empty
+  groups_t group_by(const std::vector<dimension_t>& dimensions, const transaction_filter& filter = transaction_filter(),
+    size_t nbr_threads = 0) const;
+
+  std::vector<std::string> get_departments() const { return department_names; }
+  std::vector<std::string> get_companies() const { return company_ids; }
+  std::vector<FinancialRecord> get_financial_records() const { return records; }
+  std::vector<FinancialRecord> get_financial_records_by_company(const std::string& company_id) const;
+
+private:
+  // codes[row] indexes values; index maps a value to its code while loading only
+  struct dictionary_column_t
+  {
+    std::vector<uint32_t> codes;
+    std::vector<std::string> values;
+    std::unordered_map<std::string, uint32_t> index;
+
+    void append(std::string_view value);
+    const std::string& value(size_t row) const { return values[codes[row]]; }
+  };
+
+  // filter compiled against the dictionaries: one flag per code of each constrained column
+  struct row_filter_t
+  {
+    std::vector<char> date;
+    std::vector<char> department;
+    std::vector<char> category;
+    std::vector<char> status;
+    std::vector<char> source_system;
+    std::optional<double> amount_min;
+    std::optional<double> amount_max;
+  };
+
+  // rows of one thread, aggregated into dense (group number as index) or sparse partials
+  struct group_task_t
+  {
+    size_t begin;
+    size_t end;
+    std::vector<aggregate_t> dense;
+    std::unordered_map<uint64_t, aggregate_t> sparse;
+  };
+
+  FinMartSnapshot(const std::string& source_name) : source_name(source_name), total_spending(0) {}
+  void add_transaction(const transaction_view& t);
+  void add_financial_record(const financial_record_view& r);
+  void finish();
+  row_filter_t compile(const transaction_filter& filter) const;
+  bool matches(const row_filter_t& filter, size_t row) const;
+  void mask_rows(const row_filter_t& filter, size_t begin, size_t count, unsigned char* mask) const;
+  transaction_view row_view(size_t row) const;
+  size_t seek(const transaction_cursor& after) const;
+  const dictionary_column_t& column(dimension_t dimension) const;
+  void aggregate(group_task_t& task, const std::vector<const dictionary_column_t*>& columns,
+    const std::vector<uint64_t>& strides, const row_filter_t* filter) const;
+
+  std::string source_name;
+  std::vector<int> ids;
+  std::vector<double> amounts;
+  dictionary_column_t dates;
+  dictionary_column_t departments;
+  dictionary_column_t categories;
+  dictionary_column_t vendors;
+  dictionary_column_t statuses;
+  dictionary_column_t source_systems;
+  double total_spending;
+  std::vector<FinancialRecord> records;
+  std::vector<std::string> department_names;
+  std::vector<std::string> company_ids;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// load
+// reads both tables through the row visitors of D (IFinMartDatabase or finmart_db), and the
+// department and company lists from its get_departments/get_companies (the reference cache of
+// finmart_db, so the combos have one source whether they read the snapshot or a connection);
+// nullptr if a read fails
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename D>
+std::shared_ptr<const FinMartSnapshot> FinMartSnapshot::load(D& db, const std::string& source_name)
+{
+  std::shared_ptr<FinMartSnapshot> snapshot(new FinMartSnapshot(source_name));
+  if (db.for_each_transaction(transaction_filter(), [&snapshot](const transaction_view& t)
+    {
+      snapshot->add_transaction(t);
+      return true;
+    }) < 0)
+  {
+    return nullptr;
+  }
+  if (db.for_each_financial_record([&snapshot](const financial_record_view& r)
+    {
+      snapshot->add_financial_record(r);
+      return true;
+    }) < 0)
+  {
+    return nullptr;
+  }
+  snapshot->finish();
+  snapshot->department_names = db.get_departments();
+  snapshot->company_ids = db.get_companies();
+  return snapshot;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// finmart_snapshot
+// process-wide snapshot, nullptr until the first refresh; readers keep the one they got alive
+// for as long as they use it
+// refresh_finmart_snapshot: loads a new snapshot from db and swaps it in atomically, after an
+// ETL load; sessions see the old one or the new one, never a mix. Refreshes are serialized;
+// 0 on success, -1 if db is nullptr or a read failed (the current snapshot is kept)
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const FinMartSnapshot> finmart_snapshot();
+int refresh_finmart_snapshot(IFinMartDatabase* db);
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef SQLSERVER_MIGRATIONS_HH
+#define SQLSERVER_MIGRATIONS_HH
+
+#include "finmart.h"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// SQLSERVER_MIGRATIONS
+// applied in order by FinMartSQLServer::migrate_schema, the version is kept in table schema_version
+// with the name of each migration and the seconds it took
+// append new entries, never edit one that has shipped; index builds use WITH (ONLINE = {online}),
+// ON where the edition supports it (see online_index_option), so dashboards keep reading and ETL
+// keeps writing the table while a migration builds an index. The first (unique clustered) index
+// of a view cannot be built online, migration 4 builds them offline
+//
+// 1: indexes for the dashboard queries; INCLUDE columns make them covering, so the queries
+//    never look up the clustered index
+//   transactions(date DESC)                 ORDER BY date DESC, all columns included
+//   transactions(department)                GROUP BY department with SUM(amount)
+//   transactions(source_system)             GROUP BY source_system with COUNT(*)
+//   financial_records(company_id, period)   WHERE company_id = ? ORDER BY period, all columns included
+// 2: transactions(date DESC, id DESC) for keyset pagination (get_transactions_page), replaces
+//    idx_transactions_date, where the clustered key id is ascending and a page would need a sort
+// 3: transactions(department, date DESC, id DESC) for the department filter of get_transactions_page
+// 4: indexed views transactions_by_department, transactions_by_source_system, transactions_by_day
+//    (SUM(amount), COUNT_BIG(*) per group); SQL Server updates their clustered index in the
+//    statement that changes transactions, the SQL Server form of the SQLite summary tables;
+//    CREATE VIEW must be alone in its batch, hence EXEC
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const schema_migration_t SQLSERVER_MIGRATIONS[] =
+{
+  { 1, "dashboard indexes", R"(
+      IF NOT EXISTS (SELECT * FROM sys.indexes WHERE name = 'idx_transactions_date' AND object_id = OBJECT_ID('transactions'))
+        CREATE INDEX idx_transactions_date ON transactions(date DESC)
+        INCLUDE (department, category, vendor, amount, status, source_system) WITH (ONLINE = {online});
+      IF NOT EXISTS (SELECT * FROM sys.indexes WHERE name = 'idx_transactions_department' AND object_id = OBJECT_ID('transactions'))
+        CREATE INDEX idx_transactions_department ON transactions(department) INCLUDE (amount) WITH (ONLINE = {online});
+      IF NOT EXISTS (SELECT * FROM sys.indexes WHERE name = 'idx_transactions_source_system' AND object_id = OBJECT_ID('transactions'))
+        CREATE INDEX idx_transactions_source_system ON transactions(source_system) WITH (ONLINE = {online});
+      IF NOT EXISTS (SELECT * FROM sys.indexes WHERE name = 'idx_financial_records_company_period' AND object_id = OBJECT_ID('financial_records'))
+        CREATE INDEX idx_financial_records_company_period ON financial_records(company_id, period)
+        INCLUDE (revenue, cogs, operating_expenses, depreciation, amortization, interest, taxes,
+          current_assets, current_liabilities, inventory, total_assets, total_liabilities) WITH (ONLINE = {online});
+  )" },
+  { 2, "keyset pagination index", R"(
+      IF NOT EXISTS (SELECT * FROM sys.indexes WHERE name = 'idx_transactions_date_id' AND object_id = OBJECT_ID('transactions'))
+        CREATE INDEX idx_transactions_date_id ON transactions(date DESC, id DESC)
+        INCLUDE (department, category, vendor, amount, status, source_system) WITH (ONLINE = {online});
+      IF EXISTS (SELECT * FROM sys.indexes WHERE name = 'idx_transactions_date' AND object_id = OBJECT_ID('transactions'))
+        DROP INDEX idx_transactions_date ON transactions;
+  )" },
+  { 3, "department date index", R"(
+      IF NOT EXISTS (SELECT * FROM sys.indexes WHERE name = 'idx_transactions_department_date' AND object_id = OBJECT_ID('transactions'))
+        CREATE INDEX idx_transactions_department_date ON transactions(department, date DESC, id DESC)
+        INCLUDE (category, vendor, amount, status, source_system) WITH (ONLINE = {online});
+  )" },
+  { 4, "indexed summary views", R"(
+      IF OBJECT_ID('dbo.transactions_by_department', 'V') IS NULL
+        EXEC('CREATE VIEW dbo.transactions_by_department WITH SCHEMABINDING AS
+          SELECT department, SUM(amount) AS amount, COUNT_BIG(*) AS nbr FROM dbo.transactions GROUP BY department');
+      IF NOT EXISTS (SELECT * FROM sys.indexes WHERE name = 'idx_transactions_by_department' AND object_id = OBJECT_ID('dbo.transactions_by_department'))
+        CREATE UNIQUE CLUSTERED INDEX idx_transactions_by_department ON dbo.transactions_by_department(department);
+      IF OBJECT_ID('dbo.transactions_by_source_system', 'V') IS NULL
+        EXEC('CREATE VIEW dbo.transactions_by_source_system WITH SCHEMABINDING AS
+          SELECT source_system, SUM(amount) AS amount, COUNT_BIG(*) AS nbr FROM dbo.transactions GROUP BY source_system');
+      IF NOT EXISTS (SELECT * FROM sys.indexes WHERE name = 'idx_transactions_by_source_system' AND object_id = OBJECT_ID('dbo.transactions_by_source_system'))
+        CREATE UNIQUE CLUSTERED INDEX idx_transactions_by_source_system ON dbo.transactions_by_source_system(source_system);
+      IF OBJECT_ID('dbo.transactions_by_day', 'V') IS NULL
+        EXEC('CREATE VIEW dbo.transactions_by_day WITH SCHEMABINDING AS
+          SELECT date, SUM(amount) AS amount, COUNT_BIG(*) AS nbr FROM dbo.transactions GROUP BY date');
+      IF NOT EXISTS (SELECT * FROM sys.indexes WHERE name = 'idx_transactions_by_day' AND object_id = OBJECT_ID('dbo.transactions_by_day'))
+        CREATE UNIQUE CLUSTERED INDEX idx_transactions_by_day ON dbo.transactions_by_day(date);
+  )" },
+};
+
+#endif
@@ -4,77 +4,194 @@
 #include <vector>
 #include <ctime>
 #include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
 #include <assert.h>
 #include "asio.hpp"
 #include "asio/ssl.hpp"
 #include <openssl/ssl.h>
 #include "ssl_read.hh"
 
+typedef asio::ssl::stream<asio::ip::tcp::socket> ssl_socket_t;
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
-// ssl_read - Extended version that returns headers
+// split_host_port
+// "host", "host:port", "[v6]" or "[v6]:port"; an IPv6 literal must be bracketed to carry a port,
+// a bare literal ("::1") is taken as a host with the default port
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-int ssl_read(const std::string& host, const std::string& port_num, const std::string& http,
-  std::string& response, std::vector<std::string>& headers)
+void split_host_port(const std::string& host_port, const std::string& default_port,
+  std::string& host, std::string& port)
 {
-  headers.clear();
-  std::stringstream ss;
-
-  try
+  host = host_port;
+  port = default_port;
+  if (!host_port.empty() && host_port[0] == '[')
   {
-    std::error_code ec;
-    asio::io_service io_service;
-    asio::ip::tcp::resolver resolver(io_service);
-    asio::ip::tcp::resolver::query query(host, port_num);
-    asio::ip::tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
+    size_t end = host_port.find(']');
+    if (end == std::string::npos)
+    {
+      return;
+    }
+    host = host_port.substr(1, end - 1);
+    if (end + 1 < host_port.size() && host_port[end + 1] == ':')
+    {
+      port = host_port.substr(end + 2);
+    }
+    return;
+  }
+  size_t pos = host_port.find(':');
+  if (pos != std::string::npos && host_port.find(':', pos + 1) == std::string::npos)
+  {
+    host = host_port.substr(0, pos);
+    port = host_port.substr(pos + 1);
+  }
+}
 
-    asio::ssl::context context(asio::ssl::context::tlsv12_client);
-    context.set_default_verify_paths();
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// ssl_connect - resolve, connect and TLS handshake
+// a "host:port" host (e.g. localhost:8443 for the replay server) overrides port_num
+/////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    asio::ssl::stream<asio::ip::tcp::socket> sock(io_service, context);
-    asio::connect(sock.lowest_layer(), endpoint_iterator);
-    sock.lowest_layer().set_option(asio::ip::tcp::no_delay(true));
+static void ssl_connect(asio::io_service& io_service, ssl_socket_t& sock, const std::string& host_port,
+  const std::string& port_num)
+{
+  std::string host;
+  std::string port;
+  split_host_port(host_port, port_num, host, port);
 
-    // Server Name Indication (SNI)
-    ::SSL_set_tlsext_host_name(sock.native_handle(), host.c_str());
+  asio::ip::tcp::resolver resolver(io_service);
+  asio::ip::tcp::resolver::query query(host, port);
+  asio::ip::tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
 
-    sock.set_verify_mode(asio::ssl::verify_none);
-    sock.set_verify_callback(asio::ssl::rfc2818_verification(host));
-    sock.handshake(asio::ssl::stream<asio::ip::tcp::socket>::client);
+  asio::connect(sock.lowest_layer(), endpoint_iterator);
+  sock.lowest_layer().set_option(asio::ip::tcp::no_delay(true));
 
-    size_t ret = asio::write(sock, asio::buffer(http, http.size()));
+  // Server Name Indication (SNI)
+  ::SSL_set_tlsext_host_name(sock.native_handle(), host.c_str());
 
-    // Read until end of HTTP header
-    asio::streambuf sbuf;
-    std::string line;
+  sock.set_verify_mode(asio::ssl::verify_none);
+  sock.set_verify_callback(asio::ssl::rfc2818_verification(host));
+  sock.handshake(ssl_socket_t::client);
+}
 
-    asio::read_until(sock, sbuf, "\r\n\r\n");
-    std::istream response_stream(&sbuf);
-    while (std::getline(response_stream, line) && line != "\r")
-    {
-      headers.push_back(line);
-      std::cout << line << std::endl;
-    }
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// dechunk
+// decode a "Transfer-Encoding: chunked" body; chunk extensions and trailers are ignored
+/////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    // Dump whatever content we already have
-    if (sbuf.size() > 0)
+static std::string dechunk(const std::string& body)
+{
+  std::string out;
+  out.reserve(body.size());
+  size_t pos = 0;
+  while (pos < body.size())
+  {
+    size_t eol = body.find("\r\n", pos);
+    if (eol == std::string::npos)
     {
-      ss << &sbuf;
+      break;
     }
-
-    // Read until EOF, dumping to string stream as we go
-    while (asio::read(sock, sbuf, asio::transfer_at_least(1), ec))
+    size_t size = std::strtoul(body.c_str() + pos, nullptr, 16);
+    if (size == 0)
     {
-      ss << &sbuf;
+      break;
     }
+    pos = eol + 2;
+    out.append(body, pos, size);
+    pos += size + 2;
+  }
+  return out;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// is_chunked - true if the response headers announce a chunked body
+/////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    // Both EOF and stream_truncated are valid end conditions
-    // stream_truncated occurs when server closes SSL without close_notify (common with HTTP 204)
-    if (ec && ec != asio::error::eof && ec != asio::ssl::error::stream_truncated)
+static bool is_chunked(const std::vector<std::string>& headers)
+{
+  for (size_t idx = 0; idx < headers.size(); idx++)
+  {
+    std::string header = headers[idx];
+    std::transform(header.begin(), header.end(), header.begin(), ::tolower);
+    if (header.find("transfer-encoding:") == 0 && header.find("chunked") != std::string::npos)
     {
-      std::cerr << "Read error: " << ec.message() << std::endl;
+      return true;
     }
   }
+  return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// ssl_read_response - read HTTP header lines and the body until EOF
+// a chunked body is decoded, callers always receive the plain body
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void ssl_read_response(ssl_socket_t& sock, std::stringstream& ss, std::vector<std::string>& headers)
+{
+  std::error_code ec;
+
+  // Read until end of HTTP header
+  asio::streambuf sbuf;
+  std::string line;
+
+  asio::read_until(sock, sbuf, "\r\n\r\n");
+  std::istream response_stream(&sbuf);
+  while (std::getline(response_stream, line) && line != "\r")
+  {
+    headers.push_back(line);
+    std::cout << line << std::endl;
+  }
+
+  // Dump whatever content we already have
+  if (sbuf.size() > 0)
+  {
+    ss << &sbuf;
+  }
+
+  // Read until EOF, dumping to string stream as we go
+  while (asio::read(sock, sbuf, asio::transfer_at_least(1), ec))
+  {
+    ss << &sbuf;
+  }
+
+  // Both EOF and stream_truncated are valid end conditions
+  // stream_truncated occurs when server closes SSL without close_notify (common with HTTP 204)
+  if (ec && ec != asio::error::eof && ec != asio::ssl::error::stream_truncated)
+  {
+    std::cerr << "Read error: " << ec.message() << std::endl;
+  }
+
+  if (is_chunked(headers))
+  {
+    std::string body = dechunk(ss.str());
+    ss.str(body);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// ssl_read - Extended version that returns headers
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int ssl_read(const std::string& host, const std::string& port_num, const std::string& http,
+  std::string& response, std::vector<std::string>& headers)
+{
+  headers.clear();
+  std::stringstream ss;
+
+  try
+  {
+    asio::io_service io_service;
+    asio::ssl::context context(asio::ssl::context::tlsv12_client);
+    context.set_default_verify_paths();
+
+    ssl_socket_t sock(io_service, context);
+    ssl_connect(io_service, sock, host, port_num);
+
+    size_t ret = asio::write(sock, asio::buffer(http, http.size()));
+
+    ssl_read_response(sock, ss, headers);
+  }
   catch (std::exception& e)
   {
     std::cout << "Exception: " << e.what() << std::endl;
@@ -97,3 +214,65 @@ int ssl_read(const std::string& host, const std::string& port_num, const std::st
   std::vector<std::string> headers;
   return ssl_read(host, port_num, http, response, headers);
 }
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// ssl_read_chunked
+// sends the request header, then the body with chunked transfer encoding
+// each block returned by the producer becomes one chunk and is written directly from the
+// producer's buffer (size line, data and trailer as one gather write)
+// the request header must contain "Transfer-Encoding: chunked" and end with an empty line
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int ssl_read_chunked(const std::string& host, const std::string& port_num, const std::string& http_header,
+  const body_producer_t& producer, std::string& response, std::vector<std::string>& headers)
+{
+  headers.clear();
+  std::stringstream ss;
+
+  try
+  {
+    asio::io_service io_service;
+    asio::ssl::context context(asio::ssl::context::tlsv12_client);
+    context.set_default_verify_paths();
+
+    ssl_socket_t sock(io_service, context);
+    ssl_connect(io_service, sock, host, port_num);
+
+    asio::write(sock, asio::buffer(http_header, http_header.size()));
+
+    const char* data = nullptr;
+    size_t size = 0;
+    while (producer(data, size))
+    {
+      if (size == 0)
+      {
+        continue;
+      }
+
+      char size_line[20];
+      int len = snprintf(size_line, sizeof(size_line), "%zx\r\n", size);
+
+      std::vector<asio::const_buffer> chunk;
+      chunk.push_back(asio::buffer(size_line, len));
+      chunk.push_back(asio::buffer(data, size));
+      chunk.push_back(asio::buffer("\r\n", 2));
+      asio::write(sock, chunk);
+    }
+
+    // last chunk
+    asio::write(sock, asio::buffer("0\r\n\r\n", 5));
+
+    ssl_read_response(sock, ss, headers);
+  }
+  catch (std::exception& e)
+  {
+    std::cout << "Exception: " << e.what() << std::endl;
+    std::ofstream ofs1("exception.txt");
+    ofs1 << e.what();
+    ofs1.close();
+    return -1;
+  }
+
+  response = ss.str();
+  return 0;
+}
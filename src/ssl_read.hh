@@ -3,9 +3,22 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// body_producer_t
+// returns the next block of a request body in (data, size); false when the body is complete
+// the block must stay valid until the producer is called again
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef std::function<bool(const char*& data, size_t& size)> body_producer_t;
+
+void split_host_port(const std::string& host_port, const std::string& default_port,
+  std::string& host, std::string& port);
 int ssl_read(const std::string& host, const std::string& port_num, const std::string& http, std::string& response);
 int ssl_read(const std::string& host, const std::string& port_num, const std::string& http,
   std::string& response, std::vector<std::string>& headers);
+int ssl_read_chunked(const std::string& host, const std::string& port_num, const std::string& http_header,
+  const body_producer_t& producer, std::string& response, std::vector<std::string>& headers);
 
 #endif
@@ -0,0 +1,207 @@
+#include "columnar.hh"
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+const std::string col_file("test_columnar.col");
+int test_round_trip();
+int test_empty();
+int test_writer_errors();
+int test_corrupt();
+int write_sample(std::vector<char>& bytes);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//main
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+  if (test_round_trip() < 0) assert(0);
+  if (test_empty() < 0) assert(0);
+  if (test_writer_errors() < 0) assert(0);
+  if (test_corrupt() < 0) assert(0);
+
+  std::remove(col_file.c_str());
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//write_sample
+//writes a three row file with one column of each type and reads it back into bytes
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int write_sample(std::vector<char>& bytes)
+{
+  columnar_writer writer(3);
+  if (writer.add_int32("id", { 1, 2, 3 }) < 0) return -1;
+  if (writer.add_string("vendor", { "Acme", "", "Globex Corporation" }) < 0) return -1;
+  if (writer.add_double("amount", { 10.5, -2.25, 0.0 }) < 0) return -1;
+  if (writer.write(col_file) < 0) return -1;
+
+  std::ifstream in(col_file, std::ios::binary);
+  bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  return bytes.empty() ? -1 : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_round_trip
+//values written by columnar_writer read back unchanged through the mapped file
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_round_trip()
+{
+  std::vector<char> bytes;
+  if (write_sample(bytes) < 0) return -1;
+
+  columnar_file file;
+  if (file.open(col_file) < 0) return -1;
+  const columnar_reader& reader = file.reader();
+  if (reader.nbr_rows() != 3 || reader.nbr_columns() != 3) return -1;
+
+  int id = reader.column_index("id");
+  int vendor = reader.column_index("vendor");
+  int amount = reader.column_index("amount");
+  if (id != 0 || vendor != 1 || amount != 2 || reader.column_index("status") != -1) return -1;
+  if (reader.column_type(vendor) != COLUMNAR::STRING) return -1;
+
+  const int32_t* ids = reader.int32_column(id);
+  const double* amounts = reader.double_column(amount);
+  if (!ids || !amounts || reader.double_column(id)) return -1;
+  if (ids[0] != 1 || ids[1] != 2 || ids[2] != 3) return -1;
+  if (amounts[0] != 10.5 || amounts[1] != -2.25 || amounts[2] != 0.0) return -1;
+  if (reader.string_value(vendor, 0) != "Acme") return -1;
+  if (!reader.string_value(vendor, 1).empty()) return -1;
+  if (reader.string_value(vendor, 2) != "Globex Corporation") return -1;
+
+  std::cout << "columnar round trip: " << bytes.size() << " bytes" << std::endl;
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_empty
+//a file with columns and no rows is valid
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_empty()
+{
+  columnar_writer writer(0);
+  if (writer.add_int32("id", {}) < 0) return -1;
+  if (writer.add_string("vendor", {}) < 0) return -1;
+  if (writer.write(col_file) < 0) return -1;
+
+  columnar_file file;
+  if (file.open(col_file) < 0) return -1;
+  if (file.reader().nbr_rows() != 0 || file.reader().nbr_columns() != 2) return -1;
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_writer_errors
+//a column with the wrong number of values, or a name that does not fit, fails the write
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_writer_errors()
+{
+  {
+    columnar_writer writer(3);
+    if (writer.add_int32("id", { 1, 2 }) != -1) return -1;
+    if (writer.add_double("amount", { 1.0, 2.0, 3.0 }) < 0) return -1;
+    if (writer.write(col_file) != -1) return -1;
+  }
+  {
+    columnar_writer writer(1);
+    if (writer.add_string("vendor", { "Acme", "Globex" }) != -1) return -1;
+    if (writer.write(col_file) != -1) return -1;
+  }
+  {
+    columnar_writer writer(1);
+    if (writer.add_int32(std::string(COLUMNAR::NAME_SIZE, 'x'), { 1 }) < 0) return -1;
+    if (writer.write(col_file) != -1) return -1;
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_corrupt
+//the reader rejects truncated files and directories or offsets that point outside the input
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_corrupt()
+{
+  std::vector<char> bytes;
+  if (write_sample(bytes) < 0) return -1;
+
+  columnar_reader reader;
+  if (reader.open(bytes.data(), bytes.size()) < 0) return -1;
+
+  //every truncation fails
+  for (size_t size = 0; size < bytes.size(); size++)
+  {
+    if (reader.open(bytes.data(), size) != -1) return -1;
+  }
+
+  auto header = [](std::vector<char>& b) { return reinterpret_cast<columnar_header_t*>(b.data()); };
+  auto entry = [](std::vector<char>& b, size_t col)
+  {
+    return reinterpret_cast<columnar_entry_t*>(b.data() + sizeof(columnar_header_t)) + col;
+  };
+  auto offsets = [&entry](std::vector<char>& b)
+  {
+    return reinterpret_cast<uint32_t*>(b.data() + entry(b, 1)->values_offset);
+  };
+  auto rejected = [&reader](std::vector<char>& b)
+  {
+    return reader.open(b.data(), b.size()) == -1 && reader.nbr_columns() == 0;
+  };
+
+  std::vector<char> b;
+
+  b = bytes;
+  header(b)->magic[0] = 'X';
+  if (!rejected(b)) return -1;
+
+  b = bytes;
+  header(b)->nbr_columns = 0xffffffff;
+  if (!rejected(b)) return -1;
+
+  //row count large enough to overflow count * width
+  b = bytes;
+  header(b)->nbr_rows = 0x4000000000000000ULL;
+  if (!rejected(b)) return -1;
+
+  b = bytes;
+  entry(b, 0)->type = 99;
+  if (!rejected(b)) return -1;
+
+  //offset + size wraps around
+  b = bytes;
+  entry(b, 2)->values_offset = 0xfffffffffffffff8ULL;
+  if (!rejected(b)) return -1;
+
+  b = bytes;
+  entry(b, 1)->data_offset = 0xffffffffffffffffULL;
+  if (!rejected(b)) return -1;
+
+  b = bytes;
+  entry(b, 1)->data_size = b.size();
+  if (!rejected(b)) return -1;
+
+  //offsets out of order, the last one still matches data_size
+  b = bytes;
+  offsets(b)[1] = offsets(b)[2] + 1;
+  if (!rejected(b)) return -1;
+
+  //first offset past the data
+  b = bytes;
+  offsets(b)[0] = 0xffffff00;
+  if (!rejected(b)) return -1;
+
+  b = bytes;
+  offsets(b)[3] += 1;
+  if (!rejected(b)) return -1;
+
+  return 0;
+}
@@ -0,0 +1,591 @@
+#include "lite.hh"
+#include "snapshot.hh"
+#include "sqlserver_migrations.hh"
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <set>
+
+const std::string db_file("test_lite.db");
+const std::string staging_file("test_lite.staging.db");
+int test_schema_version();
+int test_migration_sql();
+int test_query_plans();
+int test_transactions_page();
+int test_transaction_filter();
+int test_summaries();
+int test_snapshot();
+int test_reference_data();
+int test_publish_replica();
+int count_transactions(sqlite3* db);
+size_t count_text(const std::string& sql, const std::string& text);
+std::string query_plan(sqlite3* db, const std::string& sql);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//main
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+  std::remove(db_file.c_str());
+
+  if (test_schema_version() < 0) assert(0);
+  if (test_migration_sql() < 0) assert(0);
+  if (test_query_plans() < 0) assert(0);
+  if (test_transactions_page() < 0) assert(0);
+  if (test_transaction_filter() < 0) assert(0);
+  if (test_summaries() < 0) assert(0);
+  if (test_snapshot() < 0) assert(0);
+  if (test_reference_data() < 0) assert(0);
+  if (test_publish_replica() < 0) assert(0);
+
+  std::remove(db_file.c_str());
+  std::remove(staging_file.c_str());
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_schema_version
+//a new database is created at the latest version with one timed schema_version row per
+//migration, opening it again runs no migration
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_schema_version()
+{
+  {
+    finmart_db db(db_file);
+    if (!db.is_open()) return -1;
+    if (db.get_schema_version() != finmart_db::latest_schema_version()) return -1;
+  }
+
+  sqlite3* raw = nullptr;
+  sqlite3_open(db_file.c_str(), &raw);
+  sqlite3_stmt* stmt = nullptr;
+  int nbr_steps = 0;
+  if (sqlite3_prepare_v2(raw, "SELECT version, name, seconds FROM schema_version ORDER BY version;", -1, &stmt, nullptr) == SQLITE_OK)
+  {
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+      nbr_steps++;
+      if (sqlite3_column_int(stmt, 0) != nbr_steps || sqlite3_column_double(stmt, 2) < 0) nbr_steps = -1000;
+    }
+  }
+  sqlite3_finalize(stmt);
+  sqlite3_close(raw);
+  if (nbr_steps != finmart_db::latest_schema_version()) return -1;
+
+  finmart_db db(db_file);
+  if (db.get_schema_version() != finmart_db::latest_schema_version()) return -1;
+  std::cout << "schema version " << db.get_schema_version() << std::endl;
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_migration_sql
+//ONLINE = ON only on the editions that build indexes online (3, 5, 8), every {online} of a
+//migration is replaced, and the shipped SQL Server migrations expand to ONLINE = ON or OFF
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_migration_sql()
+{
+  const int editions[] = { 1, 2, 3, 4, 5, 6, 8, 9, 0, -1 };
+  const char* expected[] = { "OFF", "OFF", "ON", "OFF", "ON", "OFF", "ON", "OFF", "OFF", "OFF" };
+  for (size_t idx = 0; idx < sizeof(editions) / sizeof(editions[0]); idx++)
+  {
+    if (online_index_option(editions[idx]) != expected[idx]) return -1;
+  }
+
+  schema_migration_t migration = { 1, "indexes",
+    "CREATE INDEX a ON t(x) WITH (ONLINE = {online}); CREATE INDEX b ON t(y) WITH (ONLINE = {online});" };
+  if (migration_sql(migration, "ON") != "CREATE INDEX a ON t(x) WITH (ONLINE = ON); CREATE INDEX b ON t(y) WITH (ONLINE = ON);") return -1;
+  if (migration_sql(migration, "OFF") != "CREATE INDEX a ON t(x) WITH (ONLINE = OFF); CREATE INDEX b ON t(y) WITH (ONLINE = OFF);") return -1;
+  //a value that contains the placeholder is not replaced again
+  if (migration_sql(migration, "{online}") != migration.sql) return -1;
+
+  schema_migration_t plain = { 2, "views", "CREATE VIEW v AS SELECT 1;" };
+  if (migration_sql(plain, "ON") != plain.sql) return -1;
+
+  //every CREATE INDEX of the shipped SQL Server migrations is built online where supported; the
+  //unique clustered indexes of the views (migration 4) cannot be
+  size_t nbr_online = 0;
+  for (size_t idx = 0; idx < sizeof(SQLSERVER_MIGRATIONS) / sizeof(SQLSERVER_MIGRATIONS[0]); idx++)
+  {
+    const schema_migration_t& shipped = SQLSERVER_MIGRATIONS[idx];
+    size_t nbr_indexes = count_text(shipped.sql, "CREATE INDEX");
+    size_t nbr_placeholders = count_text(shipped.sql, "{online}");
+    if (nbr_placeholders != nbr_indexes) return -1;
+    if (shipped.version <= 3 && nbr_indexes == 0) return -1;
+    std::string on = migration_sql(shipped, online_index_option(3));
+    std::string off = migration_sql(shipped, online_index_option(2));
+    if (count_text(on, "{online}") != 0 || count_text(off, "{online}") != 0) return -1;
+    if (count_text(on, "WITH (ONLINE = ON)") != nbr_placeholders || count_text(off, "WITH (ONLINE = OFF)") != nbr_placeholders) return -1;
+    nbr_online += nbr_placeholders;
+  }
+  std::cout << "SQL Server migrations: " << nbr_online << " online index builds" << std::endl;
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//count_text - occurrences of text in sql
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+size_t count_text(const std::string& sql, const std::string& text)
+{
+  size_t nbr = 0;
+  for (size_t pos = sql.find(text); pos != std::string::npos; pos = sql.find(text, pos + text.size()))
+  {
+    nbr++;
+  }
+  return nbr;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_query_plans
+//EXPLAIN QUERY PLAN of the finmart_db queries must name the migration indexes and must not
+//sort in a temporary b-tree; the SQL is a copy of the text in lite.cc
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_query_plans()
+{
+  struct plan_t
+  {
+    const char* sql;
+    const char* index;
+  };
+
+  const plan_t plans[] =
+  {
+    { "SELECT * FROM transactions ORDER BY date DESC LIMIT 100;",
+      "USING INDEX idx_transactions_date" },
+    { "SELECT department, SUM(amount), COUNT(*) FROM transactions GROUP BY department;",
+      "USING COVERING INDEX idx_transactions_department_amount" },
+    { "SELECT date, SUM(amount), COUNT(*) FROM transactions GROUP BY date;",
+      "USING INDEX idx_transactions_date" },
+    { "SELECT period, company_id, revenue, cogs, operating_expenses, "
+      "depreciation, amortization, interest, taxes, current_assets, current_liabilities, "
+      "inventory, total_assets, total_liabilities FROM financial_records WHERE company_id = ? ORDER BY period;",
+      "USING INDEX idx_financial_records_company_period (company_id=?)" },
+    { "SELECT period, company_id, revenue, cogs, operating_expenses, "
+      "depreciation, amortization, interest, taxes, current_assets, current_liabilities, "
+      "inventory, total_assets, total_liabilities FROM financial_records ORDER BY company_id, period;",
+      "USING INDEX idx_financial_records_company_period" },
+    { "SELECT id, date, department, category, vendor, amount, status, source_system "
+      "FROM transactions WHERE (date, id) < (?, ?) ORDER BY date DESC, id DESC LIMIT ?;",
+      "USING INDEX idx_transactions_date (date<?)" },
+    { "SELECT id, date, department, category, vendor, amount, status, source_system FROM transactions "
+      "WHERE department = ? AND (date, id) < (?, ?) ORDER BY date DESC, id DESC LIMIT ?;",
+      "USING INDEX idx_transactions_department_date (department=? AND date<?)" },
+  };
+
+  sqlite3* db = nullptr;
+  if (sqlite3_open(db_file.c_str(), &db) != SQLITE_OK)
+  {
+    sqlite3_close(db);
+    return -1;
+  }
+
+  int ret = 0;
+  for (size_t idx = 0; idx < sizeof(plans) / sizeof(plans[0]); idx++)
+  {
+    std::string plan = query_plan(db, plans[idx].sql);
+    bool ok = plan.find(plans[idx].index) != std::string::npos && plan.find("USE TEMP B-TREE") == std::string::npos;
+    std::cout << (ok ? "ok   " : "FAIL ") << plans[idx].sql << std::endl << plan;
+    if (!ok)
+    {
+      ret = -1;
+    }
+  }
+
+  sqlite3_close(db);
+  return ret;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_transactions_page
+//walking all pages returns every transaction once, in (date DESC, id DESC) order; 20 more
+//transactions share one date, so pages end in the middle of a date
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_transactions_page()
+{
+  finmart_db db(db_file);
+  std::vector<transaction> same_date(20, transaction{ 0, "2025-06-15", "IT", "Software", "Dell", 10.0, "Approved", "SAP" });
+  if (db.insert_transactions(same_date) < 0) return -1;
+
+  const size_t page_size = 7;
+  size_t nbr_rows = 0;
+  size_t nbr_pages = 0;
+  transaction_cursor after;
+  transaction previous = {};
+  int count = 0;
+  {
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3* raw = nullptr;
+    sqlite3_open(db_file.c_str(), &raw);
+    sqlite3_prepare_v2(raw, "SELECT COUNT(*) FROM transactions;", -1, &stmt, nullptr);
+    if (sqlite3_step(stmt) == SQLITE_ROW) count = sqlite3_column_int(stmt, 0);
+    sqlite3_finalize(stmt);
+    sqlite3_close(raw);
+  }
+
+  while (true)
+  {
+    transaction_page page = db.get_transactions_page(transaction_filter(), after, page_size);
+    nbr_pages++;
+    for (size_t idx = 0; idx < page.rows.size(); idx++)
+    {
+      const transaction& t = page.rows[idx];
+      if (nbr_rows > 0 && (t.date > previous.date || (t.date == previous.date && t.id >= previous.id)))
+      {
+        std::cout << "FAIL page order at id " << t.id << std::endl;
+        return -1;
+      }
+      previous = t;
+      nbr_rows++;
+    }
+    if (page.has_more != (page.rows.size() == page_size && static_cast<int>(nbr_rows) < count))
+    {
+      std::cout << "FAIL has_more on page " << nbr_pages << std::endl;
+      return -1;
+    }
+    if (!page.has_more) break;
+    after = page.next;
+  }
+
+  std::cout << nbr_rows << " transactions in " << nbr_pages << " pages" << std::endl;
+  return static_cast<int>(nbr_rows) == count && count > 0 ? 0 : -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_transaction_filter
+//pages and visitor with a filter return the same rows as filtering all transactions in C++
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_transaction_filter()
+{
+  finmart_db db(db_file);
+  transaction_filter filter;
+  filter.department = "IT";
+  filter.status = "Approved";
+  filter.date_from = "2025-03-01";
+  filter.date_to = "2025-10-31";
+  filter.amount_min = 10.0;
+
+  size_t expected = 0;
+  db.for_each_transaction(transaction_filter(), [&filter, &expected](const transaction_view& t)
+    {
+      if (t.department == *filter.department && t.status == *filter.status && t.date >= *filter.date_from &&
+        t.date <= *filter.date_to && t.amount >= *filter.amount_min)
+      {
+        expected++;
+      }
+      return true;
+    });
+
+  size_t visited = 0;
+  if (db.for_each_transaction(filter, [&visited](const transaction_view&) { visited++; return true; }) < 0) return -1;
+
+  size_t paged = 0;
+  transaction_cursor after;
+  while (true)
+  {
+    transaction_page page = db.get_transactions_page(filter, after, 3);
+    for (size_t idx = 0; idx < page.rows.size(); idx++)
+    {
+      if (page.rows[idx].department != "IT" || page.rows[idx].status != "Approved") return -1;
+    }
+    paged += page.rows.size();
+    if (!page.has_more) break;
+    after = page.next;
+  }
+
+  std::cout << "filter: " << expected << " expected, " << visited << " visited, " << paged << " paged" << std::endl;
+  return (expected > 0 && visited == expected && paged == expected) ? 0 : -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_summaries
+//the summary tables follow insert_transactions, with and without bulk load, and the inserts,
+//updates and deletes of other writers; check_summaries reports a row inserted with triggers
+//turned off, rebuild_summaries fixes it
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_summaries()
+{
+  finmart_db db(db_file);
+  std::vector<std::string> mismatches;
+  if (db.check_summaries(mismatches) != 0) return -1;
+
+  std::map<std::string, double> spending;
+  double total = 0;
+  db.for_each_transaction(transaction_filter(), [&spending, &total](const transaction_view& t)
+    {
+      spending[std::string(t.department)] += t.amount;
+      total += t.amount;
+      return true;
+    });
+  std::map<std::string, double> summary = db.get_department_spending();
+  if (summary.size() != spending.size() || std::fabs(db.get_total_spending() - total) > 1e-6) return -1;
+  for (std::map<std::string, double>::const_iterator it = spending.begin(); it != spending.end(); ++it)
+  {
+    if (std::fabs(summary[it->first] - it->second) > 1e-6) return -1;
+  }
+
+  std::vector<transaction> legal(3, transaction{ 0, "2026-01-01", "Legal", "Services", "Counsel", 500.0, "Approved", "Coupa" });
+  if (db.insert_transactions(legal) < 0) return -1;
+  if (db.get_department_spending()["Legal"] != 1500.0) return -1;
+
+  sqlite3* raw = nullptr;
+  sqlite3_open(db_file.c_str(), &raw);
+  sqlite3_exec(raw, "UPDATE transactions SET department = 'HR', amount = amount * 2 WHERE id % 7 = 0;", nullptr, nullptr, nullptr);
+  sqlite3_exec(raw, "DELETE FROM transactions WHERE id % 5 = 0;", nullptr, nullptr, nullptr);
+  sqlite3_exec(raw, "DELETE FROM transactions WHERE department = 'Legal';", nullptr, nullptr, nullptr);
+  if (db.check_summaries(mismatches) != 0)
+  {
+    for (size_t idx = 0; idx < mismatches.size(); idx++) std::cout << "FAIL " << mismatches[idx] << std::endl;
+    sqlite3_close(raw);
+    return -1;
+  }
+  if (db.get_daily_spending("2026-01-01", "2026-12-31").size() != 0) return -1;
+
+  //another writer's insert goes through the insert trigger
+  const char* insert_it = "INSERT INTO transactions (date, department, category, vendor, amount, status, source_system) "
+    "VALUES ('1999-01-01', 'IT', 'Software', 'Dell', 10, 'Approved', 'SAP');";
+  sqlite3_exec(raw, insert_it, nullptr, nullptr, nullptr);
+  if (db.check_summaries(mismatches) != 0 || db.get_daily_spending("1999-01-01", "1999-01-01")["1999-01-01"] != 10.0)
+  {
+    sqlite3_close(raw);
+    return -1;
+  }
+
+  //without bulk load, insert_transactions leaves the summaries to the trigger
+  db.set_bulk_load(false);
+  if (db.insert_transactions(legal) < 0 || db.get_department_spending()["Legal"] != 1500.0 || db.check_summaries(mismatches) != 0)
+  {
+    sqlite3_close(raw);
+    return -1;
+  }
+  db.set_bulk_load(true);
+
+  //a writer with triggers turned off bypasses the summaries
+  sqlite3_db_config(raw, SQLITE_DBCONFIG_ENABLE_TRIGGER, 0, nullptr);
+  sqlite3_exec(raw, insert_it, nullptr, nullptr, nullptr);
+  sqlite3_close(raw);
+  int nbr_mismatches = db.check_summaries(mismatches);
+  for (size_t idx = 0; idx < mismatches.size(); idx++)
+  {
+    std::cout << "expected mismatch: " << mismatches[idx] << std::endl;
+  }
+  if (nbr_mismatches != 3) return -1;
+
+  mismatches.clear();
+  if (db.rebuild_summaries() < 0) return -1;
+  return db.check_summaries(mismatches) == 0 ? 0 : -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_snapshot
+//a snapshot answers the dashboard queries with the same results as the database: totals,
+//group-bys, daily spending, every page of a filtered walk and the records of a company;
+//group_by agrees with a row by row aggregation
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_snapshot()
+{
+  finmart_db db(db_file);
+  std::shared_ptr<const FinMartSnapshot> snapshot = FinMartSnapshot::load(db, "SQLite");
+  if (!snapshot) return -1;
+
+  if (std::fabs(snapshot->get_total_spending() - db.get_total_spending()) > 1e-6) return -1;
+  std::map<std::string, double> spending = db.get_department_spending();
+  std::map<std::string, double> snapshot_spending = snapshot->get_department_spending();
+  if (snapshot_spending.size() != spending.size()) return -1;
+  for (std::map<std::string, double>::const_iterator it = spending.begin(); it != spending.end(); ++it)
+  {
+    if (std::fabs(snapshot_spending[it->first] - it->second) > 1e-6) return -1;
+  }
+  if (snapshot->get_source_system_counts() != db.get_source_system_counts()) return -1;
+  if (snapshot->get_daily_spending("2025-03-01", "2025-06-30").size() != db.get_daily_spending("2025-03-01", "2025-06-30").size()) return -1;
+
+  transaction_filter filter;
+  filter.department = "IT";
+  filter.date_to = "2025-10-31";
+  transaction_cursor after;
+  size_t nbr_rows = 0;
+  while (true)
+  {
+    transaction_page expected = db.get_transactions_page(filter, after, 7);
+    transaction_page page = snapshot->get_transactions_page(filter, after, 7);
+    if (page.rows.size() != expected.rows.size() || page.has_more != expected.has_more || !(page.next == expected.next)) return -1;
+    for (size_t idx = 0; idx < page.rows.size(); idx++)
+    {
+      if (page.rows[idx].id != expected.rows[idx].id || page.rows[idx].vendor != expected.rows[idx].vendor) return -1;
+    }
+    nbr_rows += page.rows.size();
+    if (!page.has_more) break;
+    after = page.next;
+  }
+
+  std::vector<FinancialRecord> records = db.get_financial_records_by_company("ACME Corp");
+  std::vector<FinancialRecord> snapshot_records = snapshot->get_financial_records_by_company("ACME Corp");
+  if (records.empty() || snapshot_records.size() != records.size() || snapshot_records.back().period != records.back().period) return -1;
+
+  std::map<std::pair<std::string, std::string>, FinMartSnapshot::aggregate_t> expected;
+  snapshot->for_each_transaction(transaction_filter(), [&expected](const transaction_view& t)
+    {
+      FinMartSnapshot::aggregate_t& a = expected[std::make_pair(std::string(t.department), std::string(t.status))];
+      a.min = a.count ? std::min(a.min, t.amount) : t.amount;
+      a.max = a.count ? std::max(a.max, t.amount) : t.amount;
+      a.sum += t.amount;
+      a.count++;
+      return true;
+    });
+  FinMartSnapshot::groups_t groups = snapshot->group_by({ FinMartSnapshot::DEPARTMENT, FinMartSnapshot::STATUS }, transaction_filter(), 2);
+  if (groups.size() != expected.size()) return -1;
+  for (size_t idx = 0; idx < groups.size(); idx++)
+  {
+    const FinMartSnapshot::aggregate_t& a = expected[std::make_pair(std::string(groups[idx].key[0]), std::string(groups[idx].key[1]))];
+    const FinMartSnapshot::aggregate_t& g = groups[idx].aggregate;
+    if (g.count != a.count || g.min != a.min || g.max != a.max || std::fabs(g.sum - a.sum) > 1e-6) return -1;
+  }
+
+  //the filter mask of group_by selects the rows of for_each_transaction
+  transaction_filter amounts;
+  amounts.status = "Approved";
+  amounts.amount_min = 100;
+  amounts.amount_max = 5000;
+  long long nbr_matching = 0;
+  snapshot->for_each_transaction(amounts, [&nbr_matching](const transaction_view&)
+    {
+      nbr_matching++;
+      return true;
+    });
+  FinMartSnapshot::groups_t filtered = snapshot->group_by({ FinMartSnapshot::DEPARTMENT }, amounts);
+  for (size_t idx = 0; idx < filtered.size(); idx++)
+  {
+    const FinMartSnapshot::aggregate_t& g = filtered[idx].aggregate;
+    if (g.min < 100 || g.max > 5000) return -1;
+    nbr_matching -= g.count;
+  }
+  if (nbr_matching != 0) return -1;
+
+  std::cout << "snapshot: " << snapshot->nbr_transactions() << " transactions, " << snapshot->nbr_financial_records()
+    << " financial records, " << nbr_rows << " filtered rows paged, " << groups.size() << " department/status groups, " << filtered.size() << " filtered departments" << std::endl;
+  return nbr_rows > 0 ? 0 : -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_reference_data
+//the ref lists match the tables and the snapshot, and are reloaded after a commit of another
+//connection and after a write of the same one
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_reference_data()
+{
+  finmart_db db(db_file);
+  std::vector<std::string> departments = db.get_departments();
+  std::set<std::string> expected;
+  db.for_each_transaction(transaction_filter(), [&expected](const transaction_view& t)
+    {
+      expected.insert(std::string(t.department));
+      return true;
+    });
+  if (departments != std::vector<std::string>(expected.begin(), expected.end())) return -1;
+
+  std::shared_ptr<const FinMartSnapshot> snapshot = FinMartSnapshot::load(db, "SQLite");
+  if (!snapshot || snapshot->get_departments() != departments || snapshot->get_companies() != db.get_companies()) return -1;
+  if (db.get_companies().empty()) return -1;
+
+  {
+    finmart_db other(db_file, false);
+    std::vector<transaction> audit(1, transaction{ 0, "2026-03-01", "Audit", "Services", "Counsel", 10.0, "Approved", "Coupa" });
+    if (other.insert_transactions(audit) < 0) return -1;
+  }
+  std::vector<std::string> reloaded = db.get_departments();
+  if (std::find(reloaded.begin(), reloaded.end(), "Audit") == reloaded.end()) return -1;
+
+  std::vector<transaction> tax(1, transaction{ 0, "2026-03-02", "Tax", "Services", "Counsel", 10.0, "Approved", "Coupa" });
+  if (db.insert_transactions(tax) < 0) return -1;
+  reloaded = db.get_departments();
+  if (std::find(reloaded.begin(), reloaded.end(), "Tax") == reloaded.end()) return -1;
+
+  std::cout << "reference data: " << departments.size() << " departments, then " << reloaded.size() << ", "
+    << db.get_companies().size() << " companies" << std::endl;
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_publish_replica
+//rows loaded into a staging copy are published with restore_from while a reader of the replica
+//is inside a read transaction: the copy does not wait for the reader, which keeps its view and
+//sees the new rows in its next transaction
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_publish_replica()
+{
+  std::remove(staging_file.c_str());
+  finmart_db staging(staging_file, false);
+  if (staging.restore_from(db_file) < 0) return -1;
+  std::vector<transaction> loaded(100, transaction{ 0, "2026-02-01", "Legal", "Services", "Counsel", 10.0, "Approved", "Coupa" });
+  if (staging.insert_transactions(loaded) < 0) return -1;
+
+  sqlite3* reader = nullptr;
+  sqlite3_open(db_file.c_str(), &reader);
+  sqlite3_exec(reader, "BEGIN;", nullptr, nullptr, nullptr);
+  int before = count_transactions(reader);
+
+  finmart_db replica(db_file, false);
+  int ret = replica.restore_from(staging_file);
+  int during = count_transactions(reader);
+  sqlite3_exec(reader, "COMMIT;", nullptr, nullptr, nullptr);
+  int after = count_transactions(reader);
+  sqlite3_close(reader);
+
+  std::vector<std::string> mismatches;
+  std::cout << "replica: " << before << " transactions, " << during << " during publish, " << after << " after" << std::endl;
+  if (ret < 0 || during != before || after != before + 100) return -1;
+  return replica.check_summaries(mismatches) == 0 ? 0 : -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//count_transactions
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int count_transactions(sqlite3* db)
+{
+  int count = -1;
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM transactions;", -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW)
+  {
+    count = sqlite3_column_int(stmt, 0);
+  }
+  sqlite3_finalize(stmt);
+  return count;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//query_plan
+//detail column of EXPLAIN QUERY PLAN, one line per plan step
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string query_plan(sqlite3* db, const std::string& sql)
+{
+  std::string plan;
+  sqlite3_stmt* stmt = nullptr;
+  std::string explain = "EXPLAIN QUERY PLAN " + sql;
+  if (sqlite3_prepare_v2(db, explain.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+  {
+    sqlite3_finalize(stmt);
+    return plan;
+  }
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+  {
+    plan += "  ";
+    plan += reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+    plan += "\n";
+  }
+  sqlite3_finalize(stmt);
+  return plan;
+}
@@ -8,6 +8,9 @@ void show(const table_t& table);
 int test_null();
 int test_float_1();
 int test_float_2();
+int test_block_fetch();
+int test_typed_fetch();
+int test_statement();
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 //main
@@ -21,6 +24,9 @@ int main()
   if (test_null() < 0) assert(0);
   if (test_float_1() < 0) assert(0);
   if (test_float_2() < 0) assert(0);
+  if (test_block_fetch() < 0) assert(0);
+  if (test_typed_fetch() < 0) assert(0);
+  if (test_statement() < 0) assert(0);
 
   query.disconnect();
   return 0;
@@ -133,3 +139,111 @@ int test_float_2()
   return 0;
 }
 
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_block_fetch
+//2500 rows with NULLs read in blocks of 1000 rows (the last one partial) and one row per
+//SQLFetch must give the same table
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_block_fetch()
+{
+  table_t table_block;
+  table_t table_row;
+  std::string sql;
+
+  sql = "DROP TABLE IF EXISTS table_4;";
+  if (query.exec_direct(sql) < 0) assert(0);
+
+  sql = "CREATE TABLE table_4 ([Id] [int] NOT NULL, [Name] [varchar](36) NULL, [Amount] [float] NULL);";
+  if (query.exec_direct(sql) < 0) assert(0);
+
+  sql = "WITH n AS (SELECT TOP (2500) ROW_NUMBER() OVER (ORDER BY (SELECT NULL)) AS i FROM sys.all_objects a CROSS JOIN sys.all_objects b) "
+    "INSERT INTO table_4 SELECT i, CASE WHEN i % 7 = 0 THEN NULL ELSE CONCAT('name ', i) END, i * 1.5 FROM n;";
+  if (query.exec_direct(sql) < 0) assert(0);
+
+  query.set_fetch_rows(1000);
+  if (query.fetch("SELECT * FROM [table_4] ORDER BY [Id];", table_block) < 0) assert(0);
+  query.set_fetch_rows(1);
+  if (query.fetch("SELECT * FROM [table_4] ORDER BY [Id];", table_row) < 0) assert(0);
+  query.set_fetch_rows(ODBC::FETCH_BLOCK_ROWS);
+
+  if (table_block.rows.size() != 2500 || table_row.rows.size() != 2500) return -1;
+  for (size_t idx_row = 0; idx_row < table_block.rows.size(); idx_row++)
+  {
+    if (table_block.rows.at(idx_row).col != table_row.rows.at(idx_row).col) return -1;
+  }
+  if (table_block.rows.at(6).col.at(1) != ODBC::SQL_NULL) return -1;
+
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_typed_fetch
+//table_4 of test_block_fetch read into a typed_table_t: int as SQLBIGINT, float as double,
+//varchar as text, with the NULL flags of the text fetch; the names are too many for a dictionary
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_typed_fetch()
+{
+  typed_table_t table;
+  if (query.fetch("SELECT [Id], [Name], [Amount] FROM [table_4] ORDER BY [Id];", table) < 0) assert(0);
+
+  if (table.nbr_rows != 2500 || table.cols.size() != 3) return -1;
+  if (table.cols[0].c_type != SQL_C_SBIGINT || table.cols[1].c_type != SQL_C_CHAR || table.cols[2].c_type != SQL_C_DOUBLE) return -1;
+  if (table.column_index("Amount") != 2) return -1;
+  for (size_t idx_row = 0; idx_row < table.nbr_rows; idx_row++)
+  {
+    long long id = static_cast<long long>(idx_row) + 1;
+    if (table.cols[0].integers[idx_row] != id) return -1;
+    if (table.cols[2].doubles[idx_row] != id * 1.5) return -1;
+    if ((table.cols[1].null[idx_row] != 0) != (id % 7 == 0)) return -1;
+  }
+  if (table.cols[1].text(0) != "name 1" || !table.cols[1].text(6).empty()) return -1;
+  //2143 distinct names, more than ODBC::DICTIONARY_MAX_VALUES
+  if (table.cols[1].dictionary_encoded) return -1;
+
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//test_statement
+//one prepared INSERT executed with parameter arrays of 3 and 2 rows, in a manual transaction;
+//a quote in a parameter is data, not SQL; a value longer than the column size is rejected
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int test_statement()
+{
+  std::string sql;
+  sql = "DROP TABLE IF EXISTS table_5;";
+  if (query.exec_direct(sql) < 0) assert(0);
+  sql = "CREATE TABLE table_5 ([Name] [varchar](36) NOT NULL, [Amount] [float] NOT NULL);";
+  if (query.exec_direct(sql) < 0) assert(0);
+
+  statement_t stmt;
+  if (stmt.prepare(query, "INSERT INTO table_5 ([Name], [Amount]) VALUES (?, ?);") < 0) return -1;
+  if (query.set_manual() < 0) return -1;
+  for (size_t nbr_rows = 3; nbr_rows >= 2; nbr_rows--)
+  {
+    std::vector<param_array_t> params;
+    params.push_back(param_array_t::text(36, nbr_rows));
+    params.push_back(param_array_t::real(nbr_rows));
+    if (params[0].set(0, std::string(37, 'x')) != -1) return -1;
+    for (size_t idx = 0; idx < nbr_rows; idx++)
+    {
+      if (params[0].set(idx, "O'Brien " + std::to_string(idx)) < 0) return -1;
+      params[1].set(idx, 1.5 * idx);
+    }
+    if (stmt.execute(params, nbr_rows) < 0) return -1;
+  }
+  if (query.commit_transaction() < 0) return -1;
+  query.set_auto_commit();
+  stmt.close();
+
+  table_t table;
+  if (query.fetch("SELECT COUNT(*), SUM([Amount]) FROM table_5 WHERE [Name] LIKE 'O''Brien%';", table) < 0) assert(0);
+  show(table);
+  if (table.rows.size() != 1 || table.rows.at(0).col.at(0) != "5") return -1;
+
+  return 0;
+}